@@ -0,0 +1,145 @@
+/*!
+ * \file jcl_batchevaluation.cpp
+ *
+ * This file contains the implementation for the BatchEvaluation object
+ */
+
+#include "jcl_batchevaluation.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "jcl_board.h"
+
+namespace jcl
+{
+
+BatchEvaluation::BatchEvaluation(size_t threadCount)
+  : mBatch(0)
+  , mActiveCount(0)
+  , mQuit(false)
+  , mPositions(nullptr)
+  , mScores(nullptr)
+  , mCount(0)
+  , mNextPosition(0)
+  , mNetwork(nullptr)
+{
+  threadCount = std::max<size_t>(threadCount, 1);
+  for (size_t i = 0; i < threadCount; i++)
+  {
+    mEvaluations.emplace_back(new Evaluation);
+  }
+
+  // The calling thread takes the first evaluation
+  for (size_t i = 1; i < threadCount; i++)
+  {
+    mThreads.emplace_back(&BatchEvaluation::runThread, this, i);
+  }
+}
+
+BatchEvaluation::~BatchEvaluation()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQuit = true;
+  }
+  mStartCondition.notify_all();
+
+  for (size_t i = 0; i < mThreads.size(); i++)
+  {
+    mThreads[i].join();
+  }
+}
+
+void BatchEvaluation::evaluate(const PackedPosition * positions, size_t count, int32_t * scores)
+{
+  mPositions = positions;
+  mScores = scores;
+  mCount = count;
+  mNextPosition = 0;
+
+  // A batch of a single chunk is not worth waking the pool for
+  if (mThreads.empty() || count <= CHUNK_SIZE)
+  {
+    evaluateChunks(mEvaluations[0].get());
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mActiveCount = mThreads.size();
+    mBatch++;
+  }
+  mStartCondition.notify_all();
+
+  evaluateChunks(mEvaluations[0].get());
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDoneCondition.wait(lock, [this] { return mActiveCount == 0; });
+}
+
+void BatchEvaluation::evaluateChunks(Evaluation * evaluation)
+{
+  for (;;)
+  {
+    size_t first = mNextPosition.fetch_add(CHUNK_SIZE);
+    if (first >= mCount)
+    {
+      break;
+    }
+
+    size_t last = std::min(first + CHUNK_SIZE, mCount);
+    for (size_t i = first; i < last; i++)
+    {
+      mScores[i] = evaluation->evaluatePosition(mPositions[i], mNetwork);
+    }
+  }
+}
+
+PackedPosition BatchEvaluation::pack(const Board * board)
+{
+  PackedPosition position;
+  std::memset(&position, 0, sizeof(position));
+  position.sideToMove = static_cast<uint8_t>(board->getSideToMove());
+
+  uint32_t index = 0;
+  for (uint8_t bit = 0; bit < 64 && index < 32; bit++)
+  {
+    PieceType pieceType = board->getPieceType(bit >> 3, 7 - (bit & 7));
+    if (pieceType != PieceType::None)
+    {
+      position.occupied |= 1ULL << bit;
+      position.pieces[index >> 1] |= static_cast<uint8_t>(static_cast<int>(pieceType) << ((index & 1) << 2));
+      index++;
+    }
+  }
+
+  return position;
+}
+
+void BatchEvaluation::runThread(size_t index)
+{
+  uint64_t batch = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStartCondition.wait(lock, [this, batch] { return mQuit || mBatch != batch; });
+      if (mQuit)
+      {
+        return;
+      }
+      batch = mBatch;
+    }
+
+    evaluateChunks(mEvaluations[index].get());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (--mActiveCount == 0)
+    {
+      mDoneCondition.notify_one();
+    }
+  }
+}
+
+}
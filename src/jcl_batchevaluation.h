@@ -0,0 +1,198 @@
+/*!
+ * \file jcl_batchevaluation.h
+ *
+ * This file contains the interface for the BatchEvaluation object
+ */
+
+#ifndef JCL_BATCHEVALUATION_H
+#define JCL_BATCHEVALUATION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "jcl_evaluation.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+class Board;
+class Network;
+
+/*!
+ * \brief Defines a position packed into 32 bytes
+ *
+ * A PackedPosition holds the pieces of a position and the side to
+ * move, which is all the evaluation needs. The occupied squares are
+ * a bitboard, with bit row * 8 + 7 - column as in \ref BitBoard, and
+ * the PieceType of each occupied square is stored in a nibble, in
+ * the order of the occupied bits from the least significant.
+ */
+struct PackedPosition
+{
+  uint64_t occupied;   /*!< The occupied squares */
+  uint8_t pieces[16];  /*!< The piece types of the occupied squares, low nibble first */
+  uint8_t sideToMove;  /*!< The Color to move */
+  uint8_t reserved[7]; /*!< Unused, zero */
+
+  /*!
+   * \brief Returns the type of an occupied square
+   *
+   * \param index The index of the square among the occupied squares
+   *
+   * \return The type of piece on the square
+   */
+  PieceType getPieceType(uint32_t index) const;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "A packed position is 32 bytes");
+
+inline PieceType PackedPosition::getPieceType(uint32_t index) const
+{
+  return static_cast<PieceType>((pieces[index >> 1] >> ((index & 1) << 2)) & 0xf);
+}
+
+/*!
+ * \brief Defines the evaluation of many positions at once
+ *
+ * The BatchEvaluation object scores arrays of \ref PackedPosition
+ * for offline work such as labelling training data, where positions
+ * are not reached by making moves and setting up a board for each
+ * one would cost more than evaluating it.
+ *
+ * The positions are split into chunks that a pool of threads take
+ * in turn, the calling thread being one of them. Each thread owns
+ * an \ref Evaluation, so the pawn tables and attack tables are
+ * reused from one position to the next and nothing is allocated
+ * while scoring. The threads are started once and wait between
+ * batches.
+ *
+ * Each position is scored with \ref Evaluation::evaluatePosition,
+ * which gives the same score as \ref Evaluation::evaluateBoard on a
+ * \ref BitBoard holding the position.
+ */
+class BatchEvaluation
+{
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a BatchEvaluation object and starts
+   * its threads.
+   *
+   * \param threadCount The number of threads, including the calling thread
+   */
+  BatchEvaluation(size_t threadCount = 1);
+
+  /*!
+   * \brief Destructor
+   *
+   * This function stops and joins the threads.
+   */
+  ~BatchEvaluation();
+
+  BatchEvaluation(const BatchEvaluation &) = delete;
+  BatchEvaluation & operator=(const BatchEvaluation &) = delete;
+
+  /*!
+   * \brief Evaluates an array of positions
+   *
+   * This function returns when all positions have been scored. It
+   * must not be called by more than one thread at a time.
+   *
+   * \param positions The positions to evaluate
+   * \param count The number of positions
+   * \param scores Holds the score of each position in centipawns from the point of view of white
+   */
+  void evaluate(const PackedPosition * positions, size_t count, int32_t * scores);
+
+  /*!
+   * \brief Returns the network positions are evaluated with
+   *
+   * \return The network, or nullptr for the hand-written evaluation
+   */
+  const Network * getNetwork() const;
+
+  /*!
+   * \brief Returns the number of threads
+   *
+   * \return The number of threads, including the calling thread
+   */
+  size_t getThreadCount() const;
+
+  /*!
+   * \brief Packs the position of a board
+   *
+   * \param board The board
+   *
+   * \return The packed position
+   */
+  static PackedPosition pack(const Board * board);
+
+  /*!
+   * \brief Sets the network positions are evaluated with
+   *
+   * \param network The network, or nullptr for the hand-written evaluation
+   */
+  void setNetwork(const Network * network);
+
+private:
+
+  /*!
+   * \brief Evaluates chunks of the current batch until none are left
+   *
+   * \param evaluation The evaluation of the calling thread
+   */
+  void evaluateChunks(Evaluation * evaluation);
+
+  /*!
+   * \brief Runs a thread of the pool
+   *
+   * \param index The index of the thread, and of its evaluation
+   */
+  void runThread(size_t index);
+
+private:
+  static constexpr size_t CHUNK_SIZE = 1024;     // Positions taken by a thread at a time
+
+private:
+  std::vector<std::unique_ptr<Evaluation>> mEvaluations; // Evaluation of each thread, the first for the calling thread
+  std::vector<std::thread> mThreads;             // Pool threads
+  std::mutex mMutex;                             // Guards the batch state below
+  std::condition_variable mStartCondition;       // Signals a new batch or shutdown
+  std::condition_variable mDoneCondition;        // Signals the last pool thread has finished a batch
+  uint64_t mBatch;                               // Number of batches started
+  size_t mActiveCount;                           // Pool threads still working on the batch
+  bool mQuit;                                    // Whether the pool threads should exit
+  const PackedPosition * mPositions;             // Positions of the current batch
+  int32_t * mScores;                             // Scores of the current batch
+  size_t mCount;                                 // Number of positions in the current batch
+  std::atomic<size_t> mNextPosition;             // First position of the next chunk
+  const Network * mNetwork;                      // Network to evaluate with, if any
+};
+
+inline const Network * BatchEvaluation::getNetwork() const
+{
+  return mNetwork;
+}
+
+inline size_t BatchEvaluation::getThreadCount() const
+{
+  return mEvaluations.size();
+}
+
+inline void BatchEvaluation::setNetwork(const Network * network)
+{
+  mNetwork = network;
+}
+
+}
+
+#endif // #ifndef JCL_BATCHEVALUATION_H
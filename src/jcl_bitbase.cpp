@@ -0,0 +1,31 @@
+/*!
+ * \file jcl_bitbase.cpp
+ *
+ * This file contains the implementation for the Bitbase object
+ */
+
+#include "jcl_bitbase.h"
+
+namespace jcl
+{
+
+bool Bitbase::probeKPK(uint8_t strongKing, uint8_t pawn, uint8_t weakKing, Color strongSide, Color sideToMove)
+{
+  // The table numbers squares row * 8 + column with white owning the pawn,
+  // so the bit order is reversed and black is mirrored to white
+  uint8_t mirror = (strongSide == Color::White) ? 7 : 63;
+  if (((pawn ^ mirror) & 7) > 3)
+  {
+    mirror ^= 7;
+  }
+
+  uint32_t whiteKing = strongKing ^ mirror;
+  uint32_t blackKing = weakKing ^ mirror;
+  uint32_t pawnSquare = pawn ^ mirror;
+  uint32_t pawnSlot = ((pawnSquare >> 3) - 1) * 4 + (pawnSquare & 7);
+  uint32_t side = (sideToMove == strongSide) ? 0 : 1;
+  uint32_t index = side + 2 * (blackKing + 64 * (whiteKing + 64 * pawnSlot));
+  return ((KPK_TABLE[index >> 5] >> (index & 31)) & 1) != 0;
+}
+
+}
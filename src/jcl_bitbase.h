@@ -0,0 +1,57 @@
+/*!
+ * \file jcl_bitbase.h
+ *
+ * This file contains the interface for the Bitbase object
+ */
+
+#ifndef JCL_BITBASE_H
+#define JCL_BITBASE_H
+
+#include <cstdint>
+
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines the endgame bitbases embedded in the library
+ *
+ * The Bitbase class answers whether a position of king and pawn
+ * against king is won, with one bit per position. The table is
+ * computed by retrograde analysis when the library is built, by the
+ * jcl_kpkgen program, and compiled into the library as a constant
+ * array of 24 KB, so there are no files to ship or load.
+ *
+ * The pawn is mirrored to files a to d, which leaves 24 pawn squares
+ * and 2 x 64 x 64 placements of the kings and side to move for each.
+ */
+class Bitbase
+{
+public:
+
+  /*!
+   * \brief Returns whether a king and pawn against king position is won
+   *
+   * Squares are bit indexes of the \ref BitBoard. The position must be
+   * legal, with the kings apart and the side not to move out of check.
+   *
+   * \param strongKing The square of the king of the side with the pawn
+   * \param pawn The square of the pawn
+   * \param weakKing The square of the other king
+   * \param strongSide The side with the pawn
+   * \param sideToMove The side to move
+   *
+   * \return true if the side with the pawn wins, false if the position is drawn
+   */
+  static bool probeKPK(uint8_t strongKing, uint8_t pawn, uint8_t weakKing, Color strongSide, Color sideToMove);
+
+private:
+  static constexpr uint32_t KPK_WORDS = 2 * 64 * 64 * 24 / 32; // Words of the table
+
+  static const uint32_t KPK_TABLE[KPK_WORDS];                    // Won positions, generated at build time
+};
+
+}
+
+#endif // #ifndef JCL_BITBASE_H
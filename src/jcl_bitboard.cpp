@@ -1,5 +1,6 @@
 #include "jcl_bitboard.h"
 
+#include <algorithm>
 #include <bitset>
 #include <cassert>
 #include <iomanip>
@@ -9,6 +10,7 @@
 #include "jcl_fen.h"
 #include "jcl_move.h"
 #include "jcl_movelist.h"
+#include "jcl_piecesquare.h"
 
 constexpr int8_t  NORTH          =  8;
 constexpr int8_t  SOUTH          = -8;
@@ -86,46 +88,97 @@ const uint64_t FILE_AH = FILE_A | FILE_H;
 #define getCol(index) ( (index & 7) )
 #define getBitboardIndex(row,col) (63 - (((7-row)<<3)+(col)))
 
-/**
- * bitScanForward
- * @author Martin Läuter (1997)
- *         Charles E. Leiserson
- *         Harald Prokop
- *         Keith H. Randall
- * "Using de Bruijn Sequences to Index a 1 in a Computer Word"
- * @param bb bitboard to scan
- * @precondition bb != 0
- * @return index (0..63) of least significant one bit
- */
-inline uint8_t bitScanForward(uint64_t bb)
+// Piece values for the static exchange evaluation, indexed by Piece
+static const int32_t SeeValue[] =
 {
-  static const uint8_t index64[64] =
-  {
-    63,  0, 58,  1, 59, 47, 53,  2,
-    60, 39, 48, 27, 54, 33, 42,  3,
-    61, 51, 37, 40, 49, 18, 28, 20,
-    55, 30, 34, 11, 43, 14, 22,  4,
-    62, 57, 46, 52, 38, 26, 32, 41,
-    50, 36, 17, 19, 29, 10, 13, 21,
-    56, 45, 25, 31, 35, 16,  9, 12,
-    44, 24, 15,  8, 23,  7,  6,  5
-  };
-
-  static const uint64_t debruijn64 = uint64_t(0x07EDD5E59A4E28C2);
-  assert (bb != 0);
-  return index64[((bb & -bb) * debruijn64) >> 58];
-
-  //uint32_t index = 0;
-  //_BitScanForward64(&index, bb);
-  //return static_cast<uint8_t>(index);
-}
+  0,      // None
+  60000,  // King
+  950,    // Queen
+  500,    // Rook
+  350,    // Bishop
+  300,    // Knight
+  100     // Pawn
+};
 
 BitBoard::BitBoard()
+  : Board(true)
 {
   init();
   initBoard();
 }
 
+Score BitBoard::doComputePieceSquareScore() const
+{
+  Score score = 0;
+  for (uint32_t i = 0; i < 12; i++)
+  {
+    uint64_t pieces = mBitboards[i];
+    if (pieces == 0)
+    {
+      continue;
+    }
+
+    int32_t count = static_cast<int32_t>(popCount(pieces));
+    int32_t midgame = mPieceSquareOffsets[i][0] * count;
+    int32_t endgame = mPieceSquareOffsets[i][1] * count;
+    for (uint32_t k = 0; k < PIECE_SQUARE_PLANES; k++)
+    {
+      midgame += static_cast<int32_t>(popCount(pieces & mPieceSquarePlanes[i][0][k])) << k;
+      endgame += static_cast<int32_t>(popCount(pieces & mPieceSquarePlanes[i][1][k])) << k;
+    }
+    score += makeScore(midgame, endgame);
+  }
+
+  return score;
+}
+
+bool BitBoard::doGenerateCaptures(MoveList & moveList) const
+{
+  uint64_t friendly = mWhitePieceBitboard;
+  uint64_t enemy = mBlackPieceBitboard;
+  uint64_t knights = mBitboards[WhiteKnight];
+  uint64_t kings = mBitboards[WhiteKing];
+  uint64_t bishops = mBitboards[WhiteBishop];
+  uint64_t queens = mBitboards[WhiteQueen];
+  uint64_t pawns = mBitboards[WhitePawn];
+  uint64_t rooks = mBitboards[WhiteRook];
+  if (this->getSideToMove() == Color::Black)
+  {
+    friendly = mBlackPieceBitboard;
+    enemy = mWhitePieceBitboard;
+    knights = mBitboards[BlackKnight];
+    kings = mBitboards[BlackKing];
+    bishops = mBitboards[BlackBishop];
+    queens = mBitboards[BlackQueen];
+    pawns = mBitboards[BlackPawn];
+    rooks = mBitboards[BlackRook];
+  }
+
+  // Pawn captures along with pushes to the promotion rank
+  if (this->getSideToMove() == Color::White)
+  {
+    generatePawnAttacks(pawns, mPawnAttacksWhite, enemy, RANK_8, moveList);
+    generateEnPassantCaptures(pawns, mPawnAttacksBlack, 5, moveList);
+    generatePawnPromotions(((pawns & RANK_7) << 8) & mNoPieceBitboard, -NORTH, moveList);
+  }
+  else
+  {
+    generatePawnAttacks(pawns, mPawnAttacksBlack, enemy, RANK_1, moveList);
+    generateEnPassantCaptures(pawns, mPawnAttacksWhite, 2, moveList);
+    generatePawnPromotions(((pawns & RANK_2) >> 8) & mNoPieceBitboard, -SOUTH, moveList);
+  }
+
+  // The only targets for the remaining pieces are enemy occupied squares
+  generateLeapAttacks(knights, Piece::Knight, mKnightMoves, enemy, enemy, moveList);
+  generateLeapAttacks(kings, Piece::King, mKingMoves, enemy, enemy, moveList);
+  generateRookAttacks(rooks, friendly, enemy, enemy, Piece::Rook, moveList);
+  generateBishopAttacks(bishops, friendly, enemy, enemy, Piece::Bishop, moveList);
+  generateRookAttacks(queens, friendly, enemy, enemy, Piece::Queen, moveList);
+  generateBishopAttacks(queens, friendly, enemy, enemy, Piece::Queen, moveList);
+
+  return true;
+}
+
 bool BitBoard::doGenerateMoves(MoveList & moveList) const
 {
   generateCastlingMoves(moveList);
@@ -154,19 +207,22 @@ bool BitBoard::doGenerateMoves(MoveList & moveList) const
   {
     generatePawnPushesWhite(pawns, mAllPieceBitBoard, moveList);
     generatePawnAttacks(pawns, mPawnAttacksWhite, enemy, RANK_8, moveList);
+    generateEnPassantCaptures(pawns, mPawnAttacksBlack, 5, moveList);
   }
   else
   {
     generatePawnPushesBlack(pawns, mAllPieceBitBoard, moveList);
     generatePawnAttacks(pawns, mPawnAttacksBlack, enemy, RANK_1, moveList);
+    generateEnPassantCaptures(pawns, mPawnAttacksWhite, 2, moveList);
   }
 
-  generateLeapAttacks(knights, Piece::Knight, mKnightMoves, friendly, enemy, moveList);
-  generateLeapAttacks(kings, Piece::King, mKingMoves, friendly, enemy, moveList);
-  generateRookAttacks(rooks, friendly, enemy, Piece::Rook, moveList);
-  generateBishopAttacks(bishops, friendly, enemy, Piece::Bishop, moveList);
-  generateRookAttacks(queens, friendly, enemy, Piece::Queen, moveList);
-  generateBishopAttacks(queens, friendly, enemy, Piece::Queen, moveList);
+  uint64_t targets = ~friendly;
+  generateLeapAttacks(knights, Piece::Knight, mKnightMoves, targets, enemy, moveList);
+  generateLeapAttacks(kings, Piece::King, mKingMoves, targets, enemy, moveList);
+  generateRookAttacks(rooks, friendly, enemy, targets, Piece::Rook, moveList);
+  generateBishopAttacks(bishops, friendly, enemy, targets, Piece::Bishop, moveList);
+  generateRookAttacks(queens, friendly, enemy, targets, Piece::Queen, moveList);
+  generateBishopAttacks(queens, friendly, enemy, targets, Piece::Queen, moveList);
 
   return true;
 }
@@ -214,11 +270,17 @@ PieceType BitBoard::doGetPieceType(uint8_t row, uint8_t col) const
 
 bool BitBoard::doIsCellAttacked(uint8_t row, uint8_t col, Color attackingColor) const
 {
-  return false;
+  return isCellAttacked(getIndex(row, col), attackingColor);
 }
 
 bool BitBoard::doMakeMove(const Move * move)
 {
+  // Null moves do not change any squares
+  if (move->isNull())
+  {
+    return true;
+  }
+
   Color sideToMove = this->getSideToMove();
   Color otherSide = (sideToMove == Color::White) ? Color::Black : Color::White;
   uint8_t sourceRow = move->getSourceRow();
@@ -290,7 +352,7 @@ bool BitBoard::doMakeMove(const Move * move)
     else if (move->isEnPassantCapture())
     {
       uint8_t sourceRow = move->getSourceRow();
-      int8_t epColumn = getEnpassantColumn();
+      uint8_t epColumn = move->getDestinationColumn();
       uint8_t captureSquare = getIndex(sourceRow, epColumn);
       uint8_t bbCaptureSquare = getBitboardIndex(sourceRow, epColumn);
 
@@ -593,6 +655,12 @@ bool BitBoard::doSetPosition(const Fen & fen)
 
 bool BitBoard::doUnmakeMove(const Move * move)
 {
+  // Null moves do not change any squares
+  if (move->isNull())
+  {
+    return true;
+  }
+
   Color sideToMove = this->getSideToMove();
   Color otherSide = (sideToMove == Color::White) ? Color::Black : Color::White;
 
@@ -664,7 +732,7 @@ bool BitBoard::doUnmakeMove(const Move * move)
     }
     else if (move->isEnPassantCapture())
     {
-      int8_t epColumn = getEnpassantColumn();
+      uint8_t epColumn = move->getDestinationColumn();
       uint8_t captureSquare = getIndex(sourceRow, epColumn);
       uint8_t bbCaptureSquare = getBitboardIndex(sourceRow, epColumn);
 
@@ -793,77 +861,12 @@ void BitBoard::extractMoves(uint64_t bitboard, MoveList & moveList) const
 
 }
 
-void BitBoard::generateBishopAttacks(uint64_t bishops, uint64_t friendly, uint64_t enemy, Piece piece, MoveList & moveList) const
+void BitBoard::generateBishopAttacks(uint64_t bishops, uint64_t friendly, uint64_t enemy, uint64_t targets, Piece piece, MoveList & moveList) const
 {
   while (bishops)
   {
-    uint64_t moveBitboard = 0;
     uint8_t fromIndex = bitScanForward(bishops);
-    uint64_t bbIndex = (ONE << fromIndex);
-
-    while (true)
-    {
-      bbIndex >>= 9;
-      if (!bbIndex || bbIndex & FILE_A || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
-    bbIndex = (ONE << fromIndex);
-    while (true)
-    {
-      bbIndex >>= 7;
-      if (!bbIndex || bbIndex & FILE_H || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
-    bbIndex = (ONE << fromIndex);
-    while (true)
-    {
-      bbIndex <<= 9;
-      if (!bbIndex || bbIndex & FILE_H || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
-    bbIndex = (ONE << fromIndex);
-    while (true)
-    {
-      bbIndex <<= 7;
-      if (!bbIndex || bbIndex & FILE_A || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
+    uint64_t moveBitboard = getBishopAttacks(fromIndex, friendly | enemy) & targets;
     uint64_t captureBitboard = moveBitboard & enemy;
     moveBitboard &= ~captureBitboard;
 
@@ -955,13 +958,13 @@ void BitBoard::generateCastlingMoves(MoveList & moveList) const
 
 // }
 
-void BitBoard::generateLeapAttacks(uint64_t pieceBitBoard, Piece piece, const uint64_t * moves, uint64_t friendly, uint64_t enemy, MoveList & moveList) const
+void BitBoard::generateLeapAttacks(uint64_t pieceBitBoard, Piece piece, const uint64_t * moves, uint64_t targets, uint64_t enemy, MoveList & moveList) const
 {
   while (pieceBitBoard)
   {
     uint8_t fromIndex = bitScanForward(pieceBitBoard);
     uint64_t attacks = moves[fromIndex];
-    uint64_t moveBitboard = attacks & ~friendly;
+    uint64_t moveBitboard = attacks & targets;
     uint64_t captureBitboard = moveBitboard & enemy;
     moveBitboard &= ~captureBitboard;
 
@@ -1046,6 +1049,26 @@ void BitBoard::generateLeapAttacks(uint64_t pieceBitBoard, Piece piece, const ui
 //   }
 // }
 
+void BitBoard::generateEnPassantCaptures(uint64_t pawns, const uint64_t * enemyPawnAttacks, uint8_t destRow, MoveList & moveList) const
+{
+  uint8_t epColumn = getEnpassantColumn();
+  if (epColumn == INVALID_ENPASSANT_COLUMN)
+  {
+    return;
+  }
+
+  // A pawn attacks the en-passant square exactly when an enemy
+  // pawn standing on that square would attack the pawn
+  uint8_t toIndex = getBitboardIndex(destRow, epColumn);
+  uint64_t attackers = enemyPawnAttacks[toIndex] & pawns;
+  while (attackers)
+  {
+    uint8_t fromIndex = bitScanForward(attackers);
+    pushMove(fromIndex, toIndex, Piece::Pawn, Piece::Pawn, Piece::Pawn, Move::Type::EpCapture, moveList);
+    attackers &= attackers-1;
+  }
+}
+
 void BitBoard::generatePawnAttacks(uint64_t pawns, const uint64_t * pawnAttacks, uint64_t enemy, uint64_t promoRank, MoveList & moveList) const
 {
   while (pawns)
@@ -1085,6 +1108,20 @@ void BitBoard::generatePawnAttacks(uint64_t pawns, const uint64_t * pawnAttacks,
   }
 }
 
+void BitBoard::generatePawnPromotions(uint64_t promotions, int8_t fromOffset, MoveList & moveList) const
+{
+  while (promotions)
+  {
+    uint8_t toSq = bitScanForward(promotions);
+    uint8_t fromSq = toSq + fromOffset;
+    pushMove(fromSq, toSq, Piece::Pawn, Piece::None, Piece::Queen, Move::Type::Promotion, moveList);
+    pushMove(fromSq, toSq, Piece::Pawn, Piece::None, Piece::Rook, Move::Type::Promotion, moveList);
+    pushMove(fromSq, toSq, Piece::Pawn, Piece::None, Piece::Bishop, Move::Type::Promotion, moveList);
+    pushMove(fromSq, toSq, Piece::Pawn, Piece::None, Piece::Knight, Move::Type::Promotion, moveList);
+    promotions &= promotions-1;
+  }
+}
+
 void BitBoard::generatePawnPushesBlack(uint64_t pawns, uint64_t blockers, MoveList & moveList) const
 {
   uint64_t doubleEmpty = ~(blockers << 8) & ~(blockers << 16);
@@ -1179,77 +1216,12 @@ void BitBoard::generatePawnPushesWhite(uint64_t pawns, uint64_t blockers, MoveLi
   //writeBitBoard(pawnPromotions, std::cout);
 }
 
-void BitBoard::generateRookAttacks(uint64_t rooks, uint64_t friendly, uint64_t enemy, Piece piece, MoveList & moveList) const
+void BitBoard::generateRookAttacks(uint64_t rooks, uint64_t friendly, uint64_t enemy, uint64_t targets, Piece piece, MoveList & moveList) const
 {
   while (rooks)
   {
-    uint64_t moveBitboard = 0;
     uint8_t fromIndex = bitScanForward(rooks);
-    uint64_t bbIndex = (ONE << fromIndex);
-
-    while (true)
-    {
-      bbIndex >>= 1;
-      if (!bbIndex || bbIndex & FILE_A || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
-    bbIndex = (ONE << fromIndex);
-    while (true)
-    {
-      bbIndex >>= 8;
-      if (!bbIndex || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
-    bbIndex = (ONE << fromIndex);
-    while (true)
-    {
-      bbIndex <<= 1;
-      if (!bbIndex || bbIndex & FILE_H || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
-    bbIndex = (ONE << fromIndex);
-    while (true)
-    {
-      bbIndex <<= 8;
-      if (!bbIndex || bbIndex & friendly)
-      {
-        break;
-      }
-      moveBitboard |= bbIndex;
-
-      if (bbIndex & enemy)
-      {
-        break;
-      }
-    }
-
+    uint64_t moveBitboard = getRookAttacks(fromIndex, friendly | enemy) & targets;
     uint64_t captureBitboard = moveBitboard & enemy;
     moveBitboard &= ~captureBitboard;
 
@@ -1274,6 +1246,79 @@ void BitBoard::generateRookAttacks(uint64_t rooks, uint64_t friendly, uint64_t e
   }
 }
 
+uint64_t BitBoard::getAttackers(uint8_t square, uint64_t occupied) const
+{
+  uint64_t bishops = mBitboards[WhiteBishop] | mBitboards[BlackBishop] | mBitboards[WhiteQueen] | mBitboards[BlackQueen];
+  uint64_t rooks = mBitboards[WhiteRook] | mBitboards[BlackRook] | mBitboards[WhiteQueen] | mBitboards[BlackQueen];
+
+  // A white pawn attacks the square when a black pawn on the square would attack it
+  uint64_t attackers = 0;
+  attackers |= mPawnAttacksBlack[square] & mBitboards[WhitePawn];
+  attackers |= mPawnAttacksWhite[square] & mBitboards[BlackPawn];
+  attackers |= mKnightMoves[square] & (mBitboards[WhiteKnight] | mBitboards[BlackKnight]);
+  attackers |= mKingMoves[square] & (mBitboards[WhiteKing] | mBitboards[BlackKing]);
+  attackers |= getBishopAttacks(square, occupied) & bishops;
+  attackers |= getRookAttacks(square, occupied) & rooks;
+  return attackers;
+}
+
+uint64_t BitBoard::getBishopAttacks(uint8_t square, uint64_t occupied) const
+{
+  return getRayAttacks(square, occupied, NorthWest) |
+         getRayAttacks(square, occupied, NorthEast) |
+         getRayAttacks(square, occupied, SouthWest) |
+         getRayAttacks(square, occupied, SouthEast);
+}
+
+uint64_t BitBoard::getLeastValuableAttacker(uint64_t attackers, Color color, Piece & piece) const
+{
+  static const Piece pieces[] = { Piece::Pawn, Piece::Knight, Piece::Bishop, Piece::Rook, Piece::Queen, Piece::King };
+
+  for (Piece attacker : pieces)
+  {
+    uint64_t subset = attackers & mBitboards[translatePiece(attacker, color)];
+    if (subset)
+    {
+      piece = attacker;
+      return subset & -subset;
+    }
+  }
+
+  return 0;
+}
+
+uint64_t BitBoard::getPawnAttacks(uint64_t pawns, Color color)
+{
+  // Bit zero is h1, so moving towards the a-file shifts left
+  if (color == Color::White)
+  {
+    return ((pawns & ~FILE_A) << 9) | ((pawns & ~FILE_H) << 7);
+  }
+
+  return ((pawns & ~FILE_A) >> 7) | ((pawns & ~FILE_H) >> 9);
+}
+
+uint64_t BitBoard::getRayAttacks(uint8_t square, uint64_t occupied, RayDirection direction) const
+{
+  // Rays in the first four directions run towards the most significant bit
+  uint64_t attacks = mRays[direction][square];
+  uint64_t blockers = attacks & occupied;
+  if (blockers)
+  {
+    uint8_t blocker = (direction < South) ? bitScanForward(blockers) : bitScanReverse(blockers);
+    attacks ^= mRays[direction][blocker];
+  }
+  return attacks;
+}
+
+uint64_t BitBoard::getRookAttacks(uint8_t square, uint64_t occupied) const
+{
+  return getRayAttacks(square, occupied, North) |
+         getRayAttacks(square, occupied, West) |
+         getRayAttacks(square, occupied, South) |
+         getRayAttacks(square, occupied, East);
+}
+
 void BitBoard::init()
 {
   for (uint8_t i = 0; i < 64; i++)
@@ -1298,8 +1343,10 @@ void BitBoard::init()
   initKnightMoves();
   initKingMoves();
   initPawnAttacks();
+  initPieceSquarePlanes();
   initRookAttacks();
   initBishopAttacks();
+  initRays();
 }
 
 void BitBoard::initBoard()
@@ -1498,6 +1545,72 @@ void BitBoard::initPawnAttacks()
   }
 }
 
+void BitBoard::initPieceSquarePlanes()
+{
+  for (uint32_t i = 0; i < 12; i++)
+  {
+    // Bitboard squares count the columns from the h-file
+    int32_t values[2][64];
+    PieceType pieceType = mPieceToType[static_cast<BitBoardPiece>(i)];
+    for (uint8_t square = 0; square < 64; square++)
+    {
+      Score value = PieceSquare::getValue(pieceType, square >> 3, 7 - (square & 7));
+      values[0][square] = getMidgameValue(value);
+      values[1][square] = getEndgameValue(value);
+    }
+
+    for (uint32_t stage = 0; stage < 2; stage++)
+    {
+      int32_t offset = *std::min_element(values[stage], values[stage] + 64);
+      mPieceSquareOffsets[i][stage] = offset;
+      for (uint32_t k = 0; k < PIECE_SQUARE_PLANES; k++)
+      {
+        mPieceSquarePlanes[i][stage][k] = 0;
+      }
+
+      for (uint8_t square = 0; square < 64; square++)
+      {
+        int32_t bits = values[stage][square] - offset;
+        assert(bits < (1 << PIECE_SQUARE_PLANES));
+        for (uint32_t k = 0; k < PIECE_SQUARE_PLANES; k++)
+        {
+          if ((bits >> k) & 1)
+          {
+            mPieceSquarePlanes[i][stage][k] |= mMask[square];
+          }
+        }
+      }
+    }
+  }
+}
+
+void BitBoard::initRays()
+{
+  static const int8_t rowStep[] = { 1, 0, 1, 1, -1, 0, -1, -1 };
+  static const int8_t colStep[] = { 0, -1, -1, 1, 0, 1, 1, -1 };
+
+  for (int8_t row = 0; row < 8; row++)
+  {
+    for (int8_t col = 0; col < 8; col++)
+    {
+      uint8_t index = getBitboardIndex(row, col);
+      for (uint8_t direction = 0; direction < 8; direction++)
+      {
+        uint64_t rayBitboard = 0;
+        int8_t r = row + rowStep[direction];
+        int8_t c = col + colStep[direction];
+        while (r >= 0 && r < 8 && c >= 0 && c < 8)
+        {
+          rayBitboard |= (ONE << getBitboardIndex(r, c));
+          r += rowStep[direction];
+          c += colStep[direction];
+        }
+        mRays[direction][index] = rayBitboard;
+      }
+    }
+  }
+}
+
 void BitBoard::initRookAttacks()
 {
   for (int8_t i = 0; i < 8; i++)
@@ -1560,7 +1673,9 @@ void BitBoard::initRookAttacks()
 
 bool BitBoard::isCellAttacked(uint8_t index, Color attackColor) const
 {
-  return false;
+  uint8_t square = getBitboardIndex(getRow(index), getCol(index));
+  uint64_t attackers = getAttackers(square, mAllPieceBitBoard);
+  return (attackers & getPieces(attackColor)) != 0;
 }
 
 void BitBoard::pushMove(uint8_t from, uint8_t to, Piece piece, Piece capture, Piece promote, Move::Type type, MoveList & moveList) const
@@ -1573,6 +1688,147 @@ void BitBoard::pushMove(uint8_t from, uint8_t to, Piece piece, Piece capture, Pi
   Board::pushMove(sourceRow, sourceCol, destRow, destCol, piece, capture, promote, type, moveList);
 }
 
+int32_t BitBoard::see(const Move * move) const
+{
+  uint8_t fromSquare = getBitboardIndex(move->getSourceRow(), move->getSourceColumn());
+  uint8_t toSquare = getBitboardIndex(move->getDestinationRow(), move->getDestinationColumn());
+  uint64_t fromBitboard = (ONE << fromSquare);
+  uint64_t occupied = mAllPieceBitBoard;
+  uint64_t mayXray = mBitboards[WhitePawn] | mBitboards[BlackPawn] |
+                     mBitboards[WhiteBishop] | mBitboards[BlackBishop] |
+                     mBitboards[WhiteRook] | mBitboards[BlackRook] |
+                     mBitboards[WhiteQueen] | mBitboards[BlackQueen];
+
+  Piece piece = move->getPiece();
+  Color color = getSideToMove();
+
+  int32_t gain[32];
+  int32_t depth = 0;
+  gain[0] = SeeValue[static_cast<int>(move->getCapturedPiece())];
+  if (move->isEnPassantCapture())
+  {
+    occupied ^= (ONE << getBitboardIndex(move->getSourceRow(), move->getDestinationColumn()));
+  }
+
+  if (move->isPromotion() || move->isPromotionCapture())
+  {
+    piece = move->getPromotedPiece();
+    gain[0] += SeeValue[static_cast<int>(piece)] - SeeValue[static_cast<int>(Piece::Pawn)];
+  }
+
+  uint64_t attackers = getAttackers(toSquare, occupied);
+  do
+  {
+    // Speculatively assume the last capturing piece is recaptured
+    depth++;
+    gain[depth] = SeeValue[static_cast<int>(piece)] - gain[depth-1];
+
+    attackers &= ~fromBitboard;
+    occupied &= ~fromBitboard;
+    if (fromBitboard & mayXray)
+    {
+      attackers |= getBishopAttacks(toSquare, occupied) & occupied & (getBishops(Color::White) | getBishops(Color::Black) | getQueens(Color::White) | getQueens(Color::Black));
+      attackers |= getRookAttacks(toSquare, occupied) & occupied & (getRooks(Color::White) | getRooks(Color::Black) | getQueens(Color::White) | getQueens(Color::Black));
+    }
+
+    color = !color;
+    fromBitboard = getLeastValuableAttacker(attackers, color, piece);
+
+    // A king may only recapture when the square is no longer defended
+    if (piece == Piece::King && (attackers & getPieces(!color)))
+    {
+      break;
+    }
+  } while (fromBitboard && depth < 31);
+
+  while (--depth)
+  {
+    gain[depth-1] = -std::max(-gain[depth-1], gain[depth]);
+  }
+
+  return gain[0];
+}
+
+bool BitBoard::seeGE(const Move * move, int32_t threshold) const
+{
+  uint8_t fromSquare = getBitboardIndex(move->getSourceRow(), move->getSourceColumn());
+  uint8_t toSquare = getBitboardIndex(move->getDestinationRow(), move->getDestinationColumn());
+  Piece piece = move->getPiece();
+
+  int32_t swap = SeeValue[static_cast<int>(move->getCapturedPiece())] - threshold;
+  if (move->isPromotion() || move->isPromotionCapture())
+  {
+    piece = move->getPromotedPiece();
+    swap += SeeValue[static_cast<int>(piece)] - SeeValue[static_cast<int>(Piece::Pawn)];
+  }
+
+  // Fails even if the moving piece is not recaptured
+  if (swap < 0)
+  {
+    return false;
+  }
+
+  // Succeeds even if the moving piece is lost for nothing
+  swap = SeeValue[static_cast<int>(piece)] - swap;
+  if (swap <= 0)
+  {
+    return true;
+  }
+
+  uint64_t occupied = mAllPieceBitBoard ^ (ONE << fromSquare) ^ (ONE << toSquare);
+  if (move->isEnPassantCapture())
+  {
+    occupied ^= (ONE << getBitboardIndex(move->getSourceRow(), move->getDestinationColumn()));
+  }
+
+  uint64_t bishops = getBishops(Color::White) | getBishops(Color::Black) | getQueens(Color::White) | getQueens(Color::Black);
+  uint64_t rooks = getRooks(Color::White) | getRooks(Color::Black) | getQueens(Color::White) | getQueens(Color::Black);
+  uint64_t attackers = getAttackers(toSquare, occupied);
+  Color color = getSideToMove();
+
+  // The result flips each time a side recaptures, swap holds the
+  // material the recapturing side must win back to change it
+  bool result = true;
+  while (true)
+  {
+    color = !color;
+    attackers &= occupied;
+    uint64_t colorAttackers = attackers & getPieces(color);
+    if (!colorAttackers)
+    {
+      break;
+    }
+
+    uint64_t attackerBitboard = getLeastValuableAttacker(colorAttackers, color, piece);
+    result = !result;
+
+    // A king may only recapture when the square is no longer defended
+    if (piece == Piece::King)
+    {
+      return (attackers & getPieces(!color)) ? !result : result;
+    }
+
+    swap = SeeValue[static_cast<int>(piece)] - swap;
+    if (swap < static_cast<int32_t>(result))
+    {
+      break;
+    }
+
+    occupied ^= attackerBitboard;
+    if (piece == Piece::Pawn || piece == Piece::Bishop || piece == Piece::Queen)
+    {
+      attackers |= getBishopAttacks(toSquare, occupied) & bishops;
+    }
+
+    if (piece == Piece::Rook || piece == Piece::Queen)
+    {
+      attackers |= getRookAttacks(toSquare, occupied) & rooks;
+    }
+  }
+
+  return result;
+}
+
 BitBoard::BitBoardPiece BitBoard::translatePiece(Piece piece, Color color) const
 {
   BitBoardPiece pieceType = None;
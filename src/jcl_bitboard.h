@@ -1,6 +1,8 @@
 #ifndef BITBOARD_H
 #define BITBOARD_H
 
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <map>
 
@@ -11,6 +13,128 @@
 namespace jcl
 {
 
+/**
+ * bitScanForward
+ * @author Martin Läuter (1997)
+ *         Charles E. Leiserson
+ *         Harald Prokop
+ *         Keith H. Randall
+ * "Using de Bruijn Sequences to Index a 1 in a Computer Word"
+ * @param bb bitboard to scan
+ * @precondition bb != 0
+ * @return index (0..63) of least significant one bit
+ */
+inline uint8_t bitScanForward(uint64_t bb)
+{
+  static const uint8_t index64[64] =
+  {
+    63,  0, 58,  1, 59, 47, 53,  2,
+    60, 39, 48, 27, 54, 33, 42,  3,
+    61, 51, 37, 40, 49, 18, 28, 20,
+    55, 30, 34, 11, 43, 14, 22,  4,
+    62, 57, 46, 52, 38, 26, 32, 41,
+    50, 36, 17, 19, 29, 10, 13, 21,
+    56, 45, 25, 31, 35, 16,  9, 12,
+    44, 24, 15,  8, 23,  7,  6,  5
+  };
+
+  static const uint64_t debruijn64 = uint64_t(0x07EDD5E59A4E28C2);
+  assert (bb != 0);
+  return index64[((bb & -bb) * debruijn64) >> 58];
+
+  //uint32_t index = 0;
+  //_BitScanForward64(&index, bb);
+  //return static_cast<uint8_t>(index);
+}
+
+/**
+ * bitScanReverse
+ * @authors Kim Walisch, Mark Dickinson
+ * @param bb bitboard to scan
+ * @precondition bb != 0
+ * @return index (0..63) of most significant one bit
+ */
+inline uint8_t bitScanReverse(uint64_t bb)
+{
+  static const uint8_t index64[64] =
+  {
+    0, 47,  1, 56, 48, 27,  2, 60,
+   57, 49, 41, 37, 28, 16,  3, 61,
+   54, 58, 35, 52, 50, 42, 21, 44,
+   38, 32, 29, 23, 17, 11,  4, 62,
+   46, 55, 26, 59, 40, 36, 15, 53,
+   34, 51, 20, 43, 31, 22, 10, 45,
+   25, 39, 14, 33, 19, 30,  9, 24,
+   13, 18,  8, 12,  7,  6,  5, 63
+  };
+
+  static const uint64_t debruijn64 = uint64_t(0x03f79d71b4cb0a89);
+  assert (bb != 0);
+  bb |= bb >> 1;
+  bb |= bb >> 2;
+  bb |= bb >> 4;
+  bb |= bb >> 8;
+  bb |= bb >> 16;
+  bb |= bb >> 32;
+  return index64[(bb * debruijn64) >> 58];
+}
+
+/*!
+ * \brief Counts the bits set in a bitboard
+ *
+ * \param bb The bitboard
+ *
+ * \return The number of bits set
+ */
+inline uint32_t popCount(uint64_t bb)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<uint32_t>(__builtin_popcountll(bb));
+#else
+  bb = bb - ((bb >> 1) & 0x5555555555555555ULL);
+  bb = (bb & 0x3333333333333333ULL) + ((bb >> 2) & 0x3333333333333333ULL);
+  bb = (bb + (bb >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<uint32_t>((bb * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Offsets of each piece in the bitboards of one side, which follow PieceType
+constexpr uint32_t PAWNS = 0;
+constexpr uint32_t ROOKS = 1;
+constexpr uint32_t KNIGHTS = 2;
+constexpr uint32_t BISHOPS = 3;
+constexpr uint32_t QUEENS = 4;
+constexpr uint32_t KINGS = 5;
+
+/*!
+ * \brief Returns the offset of the bitboards of one side
+ *
+ * The twelve piece bitboards (see \ref BitBoard::getBitboards) hold
+ * the white pieces first, so the pieces of a side start at this offset.
+ *
+ * \param color The side
+ *
+ * \return The index of the pawn bitboard of the side
+ */
+inline uint32_t getSideOffset(Color color)
+{
+  return (color == Color::White) ? 0 : 6;
+}
+
+/*!
+ * \brief Returns the bitboards of one side
+ *
+ * \param pieces The twelve piece bitboards
+ * \param color The side
+ *
+ * \return The six bitboards of the side, indexed by \ref PAWNS to \ref KINGS
+ */
+inline const uint64_t * getSideBitboards(const uint64_t * pieces, Color color)
+{
+  return pieces + getSideOffset(color);
+}
+
+
 class BitBoard
 : public Board
 {
@@ -25,6 +149,90 @@ public:
 
   uint64_t getAll() const;
   uint64_t getAll(Color color) const;
+
+  /*!
+   * \brief Returns the pieces attacking a square
+   *
+   * This function returns a bitboard of all pieces of either color
+   * that attack the specified square. Sliding pieces are blocked
+   * by the supplied occupancy rather than the current board, which
+   * allows attackers hidden behind other pieces (x-rays) to be
+   * discovered by removing the blocking pieces from the occupancy.
+   *
+   * \param square The bitboard index of the square
+   * \param occupied The bitboard of squares that block sliding pieces
+   *
+   * \return The bitboard of pieces attacking the square
+   */
+  uint64_t getAttackers(uint8_t square, uint64_t occupied) const;
+
+  /*!
+   * \brief Returns the diagonal attacks from a square
+   *
+   * This function returns the squares attacked by a bishop on the
+   * specified square. Each ray stops at, and includes, the first
+   * occupied square.
+   *
+   * \param square The bitboard index of the square
+   * \param occupied The bitboard of squares that block the rays
+   *
+   * \return The bitboard of attacked squares
+   */
+  uint64_t getBishopAttacks(uint8_t square, uint64_t occupied) const;
+
+  /*!
+   * \brief Returns the bitboards of all pieces
+   *
+   * \return The twelve piece bitboards, indexed by PieceType minus one
+   */
+  const uint64_t * getBitboards() const;
+
+  /*!
+   * \brief Returns the king attacks from a square
+   *
+   * \param square The bitboard index of the square
+   *
+   * \return The bitboard of attacked squares
+   */
+  uint64_t getKingAttacks(uint8_t square) const;
+
+  /*!
+   * \brief Returns the knight attacks from a square
+   *
+   * \param square The bitboard index of the square
+   *
+   * \return The bitboard of attacked squares
+   */
+  uint64_t getKnightAttacks(uint8_t square) const;
+
+  /*!
+   * \brief Returns the squares attacked by pawns
+   *
+   * This function returns all squares attacked by the supplied pawns
+   * of the specified color, computed by shifting the pawn bitboard
+   * rather than visiting each pawn.
+   *
+   * \param pawns The bitboard of the pawns
+   * \param color The color of the pawns
+   *
+   * \return The bitboard of attacked squares
+   */
+  static uint64_t getPawnAttacks(uint64_t pawns, Color color);
+
+  /*!
+   * \brief Returns the orthogonal attacks from a square
+   *
+   * This function returns the squares attacked by a rook on the
+   * specified square. Each ray stops at, and includes, the first
+   * occupied square.
+   *
+   * \param square The bitboard index of the square
+   * \param occupied The bitboard of squares that block the rays
+   *
+   * \return The bitboard of attacked squares
+   */
+  uint64_t getRookAttacks(uint8_t square, uint64_t occupied) const;
+
   uint64_t getBishops(Color color) const;
   uint64_t getKings(Color color) const;
   uint64_t getKnights(Color color) const;
@@ -34,9 +242,43 @@ public:
   uint64_t getQueens(Color color) const;
   uint64_t getRooks(Color color) const;
 
+  /*!
+   * \brief Returns the static exchange evaluation of a move
+   *
+   * This function returns the material balance, from the point of
+   * view of the side making the move, of the sequence of captures on
+   * the destination square of the move when both sides always
+   * recapture with their least valuable piece and may stop capturing
+   * at any time. Attackers revealed behind sliding pieces are included.
+   *
+   * The board is not modified and pins are not taken into account.
+   *
+   * \param move The move to evaluate
+   *
+   * \return The expected material gain of the move
+   */
+  int32_t see(const Move * move) const;
+
+  /*!
+   * \brief Returns whether the static exchange evaluation reaches a threshold
+   *
+   * This function returns whether the static exchange evaluation of
+   * the move is greater than or equal to the threshold. It is cheaper
+   * than \ref see since the exchange is abandoned as soon as its
+   * outcome relative to the threshold is known.
+   *
+   * \param move The move to evaluate
+   * \param threshold The material threshold
+   *
+   * \return true if the exchange gains at least threshold, false otherwise
+   */
+  bool seeGE(const Move * move, int32_t threshold) const;
+
 protected:
 
   // Override
+  Score doComputePieceSquareScore() const override;
+  bool doGenerateCaptures(MoveList & moveList) const override;
   bool doGenerateMoves(MoveList & moveList) const override;
   bool doGenerateMoves(uint8_t row, uint8_t col, MoveList & moveList) const override;
   PieceType doGetPieceType(uint8_t row, uint8_t col) const override;
@@ -48,6 +290,8 @@ protected:
   bool doUnmakeMove(const Move * move) override;
 
 private:
+  static constexpr uint32_t PIECE_SQUARE_PLANES = 7;     // Bits in a piece-square value above its offset
+
   enum BitBoardPiece
   {
     WhitePawn = 0,
@@ -65,8 +309,19 @@ private:
     None,
   };
 
+  enum RayDirection
+  {
+    North = 0,
+    West,
+    NorthWest,
+    NorthEast,
+    South,
+    East,
+    SouthWest,
+    SouthEast
+  };
 
-  void generateBishopAttacks(uint64_t rooks, uint64_t friendly, uint64_t enemy, Piece piece, MoveList & moveList) const;
+  void generateBishopAttacks(uint64_t bishops, uint64_t friendly, uint64_t enemy, uint64_t targets, Piece piece, MoveList & moveList) const;
   /*!
    * \brief Generates the castling moves
    *
@@ -79,11 +334,69 @@ private:
    * \param moveList The move list to hold the moves
    */
   void generateCastlingMoves(MoveList & moveList) const;
-  void generateLeapAttacks(uint64_t pieceBitBoard, Piece piece, const uint64_t * moves, uint64_t friendly, uint64_t enemy, MoveList & moveList) const;
+  void generateLeapAttacks(uint64_t pieceBitBoard, Piece piece, const uint64_t * moves, uint64_t targets, uint64_t enemy, MoveList & moveList) const;
   void generatePawnAttacks(uint64_t pawns, const uint64_t * pawnAttacks, uint64_t enemy, uint64_t promoRank, MoveList & moveList) const;
+
+  /*!
+   * \brief Generates the en-passant captures
+   *
+   * This function pushes a capture onto the en-passant square
+   * for each pawn attacking it. The attacking pawns are found
+   * with the enemy pawn attack table, since a pawn attacks the
+   * square exactly when an enemy pawn on it would attack the
+   * pawn. Nothing is generated without an en-passant column.
+   *
+   * \param pawns The pawns of the side to move
+   * \param enemyPawnAttacks The pawn attack table of the other side
+   * \param destRow The row of the en-passant square
+   * \param moveList The move list to hold the moves
+   */
+  void generateEnPassantCaptures(uint64_t pawns, const uint64_t * enemyPawnAttacks, uint8_t destRow, MoveList & moveList) const;
+
+  /*!
+   * \brief Generates the non-capturing pawn promotions
+   *
+   * This function pushes the four promotion moves for each
+   * destination square in the supplied bitboard. The fromOffset
+   * parameter is added to a destination square to find the
+   * square the pawn is moving from.
+   *
+   * \param promotions The bitboard of promotion destination squares
+   * \param fromOffset The offset from the destination to the source square
+   * \param moveList The move list to hold the moves
+   */
+  void generatePawnPromotions(uint64_t promotions, int8_t fromOffset, MoveList & moveList) const;
   void generatePawnPushesBlack(uint64_t pawns, uint64_t friendly, MoveList & moveList) const;
   void generatePawnPushesWhite(uint64_t pawns, uint64_t friendly, MoveList & moveList) const;
-  void generateRookAttacks(uint64_t rooks, uint64_t friendly, uint64_t enemy, Piece piece, MoveList & moveList) const;
+  void generateRookAttacks(uint64_t rooks, uint64_t friendly, uint64_t enemy, uint64_t targets, Piece piece, MoveList & moveList) const;
+
+  /*!
+   * \brief Returns the least valuable attacker
+   *
+   * This function finds the least valuable piece of the specified
+   * color within the attackers bitboard.
+   *
+   * \param attackers The bitboard of attacking pieces
+   * \param color The color of the attacker to find
+   * \param piece Holds the piece of the attacker when one is found
+   *
+   * \return The bitboard holding the attacker, or zero if there is none
+   */
+  uint64_t getLeastValuableAttacker(uint64_t attackers, Color color, Piece & piece) const;
+
+  /*!
+   * \brief Returns the attacks along a single ray
+   *
+   * This function returns the squares along the ray from the
+   * specified square up to and including the first occupied square.
+   *
+   * \param square The bitboard index of the square
+   * \param occupied The bitboard of squares that block the ray
+   * \param direction The direction of the ray
+   *
+   * \return The bitboard of attacked squares
+   */
+  uint64_t getRayAttacks(uint8_t square, uint64_t occupied, RayDirection direction) const;
 
   void init();
 
@@ -97,8 +410,22 @@ private:
 
   void initPawnAttacks();
 
+  /*!
+   * \brief Initializes the piece-square bit planes
+   *
+   * This function splits the midgame and endgame piece-square
+   * values of each piece, less the smallest value of the piece,
+   * into bit planes. Plane k holds the squares whose value has
+   * bit k set, so the sum of the values of a set of pieces is the
+   * sum of the population counts of the pieces on each plane,
+   * shifted by k, plus the smallest value for each piece.
+   */
+  void initPieceSquarePlanes();
+
   void initRookAttacks();
 
+  void initRays();
+
   /*!
    * \brief Determines if a cell is attacked
    *
@@ -143,6 +470,9 @@ private:
   uint64_t mPawnAttacksBlack[64];
   uint64_t mPawnAttacksWhite[64];
   uint64_t mRookAttacks[64];
+  uint64_t mRays[8][64];                                  // Empty board rays in each direction
+  int32_t mPieceSquareOffsets[12][2];                     // Smallest midgame and endgame value of each piece
+  uint64_t mPieceSquarePlanes[12][2][PIECE_SQUARE_PLANES]; // Bit planes of the midgame and endgame values of each piece
   Color mColors[64];                                     // Color on each square
   std::map<BitBoardPiece, jcl::PieceType> mPieceToType;  // Map of BitBoardPiece type to PieceType
 };
@@ -157,16 +487,31 @@ inline uint64_t BitBoard::getAll(Color color) const
   return (color == Color::White) ? mWhitePieceBitboard : mBlackPieceBitboard;
 }
 
+inline const uint64_t * BitBoard::getBitboards() const
+{
+  return mBitboards;
+}
+
 inline uint64_t BitBoard::getBishops(Color color) const
 {
   return (color == Color::White) ? mBitboards[WhiteBishop] : mBitboards[BlackBishop];
 }
 
+inline uint64_t BitBoard::getKingAttacks(uint8_t square) const
+{
+  return mKingMoves[square];
+}
+
 inline uint64_t BitBoard::getKings(Color color) const
 {
   return (color == Color::White) ? mBitboards[WhiteKing] : mBitboards[BlackKing];
 }
 
+inline uint64_t BitBoard::getKnightAttacks(uint8_t square) const
+{
+  return mKnightMoves[square];
+}
+
 inline uint64_t BitBoard::getKnights(Color color) const
 {
   return (color == Color::White) ? mBitboards[WhiteKnight] : mBitboards[BlackKnight];
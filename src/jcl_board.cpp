@@ -6,11 +6,17 @@
 
 #include "jcl_board.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <string>
 
+#include "jcl_bitboard.h"
 #include "jcl_fen.h"
+#include "jcl_materialtable.h"
+#include "jcl_piecesquare.h"
+#include "jcl_polyglot.h"
+#include "jcl_zobrist.h"
 
 // Macros for mapping (row,col)->index and vice-versa
 #define getIndex(row,col) (((row)<<3)+(col))
@@ -30,11 +36,74 @@ enum Square
 namespace jcl
 {
 
+static PieceType toPieceType(Piece piece, Color color)
+{
+  static const PieceType whitePieces[] = { PieceType::None, PieceType::WhiteKing, PieceType::WhiteQueen, PieceType::WhiteRook,
+                                           PieceType::WhiteBishop, PieceType::WhiteKnight, PieceType::WhitePawn };
+  static const PieceType blackPieces[] = { PieceType::None, PieceType::BlackKing, PieceType::BlackQueen, PieceType::BlackRook,
+                                           PieceType::BlackBishop, PieceType::BlackKnight, PieceType::BlackPawn };
+
+  return (color == Color::White) ? whitePieces[static_cast<int>(piece)] : blackPieces[static_cast<int>(piece)];
+}
+
+// Calls the function for each piece a move adds or removes, with 1 for
+// a piece added and -1 for a piece removed when the move is made
+template <typename Function>
+static void forEachChangedPiece(const Move * move, Color side, Function function)
+{
+  uint8_t sourceRow = move->getSourceRow();
+  uint8_t sourceCol = move->getSourceColumn();
+  uint8_t destRow = move->getDestinationRow();
+  uint8_t destCol = move->getDestinationColumn();
+
+  PieceType piece = toPieceType(move->getPiece(), side);
+  PieceType placedPiece = piece;
+  if (move->isPromotion() || move->isPromotionCapture())
+  {
+    placedPiece = toPieceType(move->getPromotedPiece(), side);
+  }
+
+  function(piece, sourceRow, sourceCol, -1);
+  function(placedPiece, destRow, destCol, 1);
+
+  // The pawn captured en-passant is beside the source square
+  if (move->isEnPassantCapture())
+  {
+    function(toPieceType(Piece::Pawn, !side), sourceRow, destCol, -1);
+  }
+  else if (move->isCapture())
+  {
+    function(toPieceType(move->getCapturedPiece(), !side), destRow, destCol, -1);
+  }
+
+  if (move->isCastle())
+  {
+    PieceType rook = toPieceType(Piece::Rook, side);
+    uint8_t rookSourceCol = (destCol == 6) ? 7 : 0;
+    uint8_t rookDestCol = (destCol == 6) ? 5 : 3;
+    function(rook, sourceRow, rookSourceCol, -1);
+    function(rook, sourceRow, rookDestCol, 1);
+  }
+}
+
 Board::Board()
+  : Board(false)
+{
+
+}
+
+Board::Board(bool isBitBoard)
+  : mIsBitBoard(isBitBoard)
+  , mNetwork(nullptr)
 {
   init();
 }
 
+bool Board::generateCaptures(MoveList & moveList) const
+{
+  return doGenerateCaptures(moveList);
+}
+
 bool Board::generateMoves(MoveList & moveList) const
 {
   return doGenerateMoves(moveList);
@@ -45,6 +114,118 @@ bool Board::generateMoves(uint8_t row, uint8_t col, MoveList & moveList) const
   return doGenerateMoves(row, col, moveList);
 }
 
+uint64_t Board::computeHashKey() const
+{
+  uint64_t hashKey = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      hashKey ^= Zobrist::getPieceKey(getPieceType(i, j), i, j);
+    }
+  }
+
+  hashKey ^= Zobrist::getCastlingKey(mCastlingRights);
+  hashKey ^= Zobrist::getEnPassantKey(mEnPassantColumn);
+  if (mSideToMove == Color::Black)
+  {
+    hashKey ^= Zobrist::getSideKey();
+  }
+
+  return hashKey;
+}
+
+uint64_t Board::computeMaterialKey() const
+{
+  uint64_t materialKey = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      materialKey += MaterialTable::getPieceKey(getPieceType(i, j));
+    }
+  }
+
+  return materialKey;
+}
+
+uint64_t Board::computePolyglotKey() const
+{
+  uint64_t polyglotKey = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      polyglotKey ^= Polyglot::getPieceKey(getPieceType(i, j), i, j);
+    }
+  }
+
+  polyglotKey ^= Polyglot::getCastlingKey(mCastlingRights);
+  polyglotKey ^= getPolyglotEnPassantKey(mSideToMove);
+  if (mSideToMove == Color::White)
+  {
+    polyglotKey ^= Polyglot::getSideKey();
+  }
+
+  return polyglotKey;
+}
+
+uint64_t Board::computePawnHashKey() const
+{
+  uint64_t hashKey = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      PieceType pieceType = getPieceType(i, j);
+      if (pieceType == PieceType::WhitePawn || pieceType == PieceType::BlackPawn)
+      {
+        hashKey ^= Zobrist::getPieceKey(pieceType, i, j);
+      }
+    }
+  }
+
+  return hashKey;
+}
+
+int32_t Board::computePhase() const
+{
+  int32_t phase = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      phase += PieceSquare::getPhase(getPieceType(i, j));
+    }
+  }
+
+  return phase;
+}
+
+Score Board::computePieceSquareScore() const
+{
+  return doComputePieceSquareScore();
+}
+
+Score Board::doComputePieceSquareScore() const
+{
+  Score score = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      score += PieceSquare::getValue(getPieceType(i, j), i, j);
+    }
+  }
+
+  return score;
+}
+
+const BitBoard * Board::getBitBoard() const
+{
+  return mIsBitBoard ? static_cast<const BitBoard *>(this) : nullptr;
+}
+
 uint8_t Board::getKingColumn(Color color) const
 {
   return mKingColumn.find(color)->second;
@@ -55,11 +236,38 @@ uint8_t Board::getKingRow(Color color) const
   return mKingRow.find(color)->second;
 }
 
+Move Board::getNullMove() const
+{
+  return Move(0, 0, 0, 0, mCastlingRights, mEnPassantColumn, mHalfMoveClock, mFullMoveCounter, Piece::None, Move::Type::Null);
+}
+
 PieceType Board::getPieceType(uint8_t row, uint8_t col) const
 {
   return doGetPieceType(row, col);
 }
 
+const uint64_t * Board::getPieceBitboards(uint64_t pieces[12]) const
+{
+  if (mIsBitBoard)
+  {
+    return static_cast<const BitBoard *>(this)->getBitboards();
+  }
+
+  std::fill(pieces, pieces + 12, 0ULL);
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      PieceType pieceType = getPieceType(i, j);
+      if (pieceType != PieceType::None)
+      {
+        pieces[static_cast<int>(pieceType) - 1] |= 1ULL << ((i << 3) + 7 - j);
+      }
+    }
+  }
+  return pieces;
+}
+
 void Board::init()
 {
   mCastlingRights = CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN | CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN;
@@ -71,6 +279,26 @@ void Board::init()
   mKingRow[Color::White] = 0;
   mKingColumn[Color::Black] = 4;
   mKingRow[Color::Black] = 7;
+  mHashHistory.clear();
+  mNullMoveHistory.clear();
+
+  // Derived boards start from the standard initial position
+  static const Piece backRank[] = { Piece::Rook, Piece::Knight, Piece::Bishop, Piece::Queen,
+                                    Piece::King, Piece::Bishop, Piece::Knight, Piece::Rook };
+  mHashKey = Zobrist::getCastlingKey(mCastlingRights);
+  mPolyglotKey = Polyglot::getCastlingKey(mCastlingRights) ^ Polyglot::getSideKey();
+  mPolyglotEnPassantKey = 0;
+  mMaterialKey = 0;
+  mPawnHashKey = 0;
+  mPieceSquareScore = 0;
+  mPhase = 0;
+  for (uint8_t col = 0; col < 8; col++)
+  {
+    togglePiece(toPieceType(backRank[col], Color::White), 0, col, 1);
+    togglePiece(PieceType::WhitePawn, 1, col, 1);
+    togglePiece(PieceType::BlackPawn, 6, col, 1);
+    togglePiece(toPieceType(backRank[col], Color::Black), 7, col, 1);
+  }
 }
 
 bool Board::isCellAttacked(uint8_t row, uint8_t col, Color attackColor) const
@@ -78,10 +306,97 @@ bool Board::isCellAttacked(uint8_t row, uint8_t col, Color attackColor) const
   return doIsCellAttacked(row, col, attackColor);
 }
 
+bool Board::isDrawByFiftyMove() const
+{
+  return (mHalfMoveClock >= 100);
+}
+
+bool Board::isDrawByRepetition(uint32_t rootPly) const
+{
+  uint32_t size = static_cast<uint32_t>(mHashHistory.size());
+  uint32_t distance = getRepetitionDistance();
+
+  // A repeat inside the search is a draw at once, one reaching the
+  // game history needs two earlier occurrences
+  uint32_t found = 0;
+  for (uint32_t i = 2; i <= distance; i += 2)
+  {
+    uint32_t index = size - i;
+    if (mHashHistory[index] == mHashKey && (index > rootPly || ++found >= 2))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Board::isRepetition(uint32_t count) const
+{
+  uint32_t size = static_cast<uint32_t>(mHashHistory.size());
+  uint32_t distance = getRepetitionDistance();
+
+  uint32_t found = 0;
+  for (uint32_t i = 2; i <= distance; i += 2)
+  {
+    if (mHashHistory[size - i] == mHashKey && ++found >= count)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint64_t Board::getPolyglotEnPassantKey(Color side) const
+{
+  if (mEnPassantColumn == INVALID_ENPASSANT_COLUMN)
+  {
+    return 0;
+  }
+
+  // The key only counts when a pawn beside the pushed pawn can capture it
+  uint8_t row = (side == Color::White) ? 4 : 3;
+  PieceType pawn = (side == Color::White) ? PieceType::WhitePawn : PieceType::BlackPawn;
+  if ((mEnPassantColumn > 0 && getPieceType(row, mEnPassantColumn - 1) == pawn) ||
+      (mEnPassantColumn < 7 && getPieceType(row, mEnPassantColumn + 1) == pawn))
+  {
+    return Polyglot::getEnPassantKey(mEnPassantColumn);
+  }
+
+  return 0;
+}
+
+uint32_t Board::getRepetitionDistance() const
+{
+  // Positions before the last irreversible move cannot repeat, and
+  // positions before a null move are not part of the game
+  uint32_t size = static_cast<uint32_t>(mHashHistory.size());
+  uint32_t distance = (mHalfMoveClock < size) ? mHalfMoveClock : size;
+  if (!mNullMoveHistory.empty())
+  {
+    distance = std::min(distance, size - mNullMoveHistory.back());
+  }
+
+  return distance;
+}
+
 bool Board::makeMove(const Move * move)
 {
   Color sideToMove = this->getSideToMove();
   Color otherSide = (mSideToMove == Color::White) ? Color::Black : Color::White;
+  mHashHistory.push_back(mHashKey);
+
+  // A null move only passes the turn
+  if (move->isNull())
+  {
+    mNullMoveHistory.push_back(static_cast<uint32_t>(mHashHistory.size()));
+    doMakeMove(move);
+    setEnPassantColumn(INVALID_ENPASSANT_COLUMN);
+    updateMoveClocks(move);
+    setSideToMove(otherSide);
+    return true;
+  }
 
   // Update for king move
   if (move->getPiece() == Piece::King)
@@ -91,13 +406,18 @@ bool Board::makeMove(const Move * move)
   }
 
   // Let subclasses update their state
+  updatePieces(move, sideToMove, 1);
   doMakeMove(move);
+  if (mNetwork != nullptr)
+  {
+    pushAccumulator(move, sideToMove);
+  }
 
   // Handle double pawn pushes
-  mEnPassantColumn = INVALID_ENPASSANT_COLUMN;
+  setEnPassantColumn(INVALID_ENPASSANT_COLUMN);
   if (move->isDoublePush())
   {
-    mEnPassantColumn = move->getSourceColumn();
+    setEnPassantColumn(move->getSourceColumn());
   }
 
   // Update board state
@@ -124,14 +444,75 @@ void Board::pushMove(uint8_t sourceRow,
   moveList.addMove(newMove);
 }
 
+void Board::pushAccumulator(const Move * move, Color side)
+{
+  mAccumulators.push_back(mAccumulators.back());
+  Network::Accumulator & accumulator = mAccumulators.back();
+
+  // A king move changes every feature seen from the side that moved
+  for (Color perspective : { Color::White, Color::Black })
+  {
+    if (perspective == side && move->getPiece() == Piece::King)
+    {
+      mNetwork->refreshAccumulator(this, perspective, accumulator);
+      continue;
+    }
+
+    uint8_t kingSquare = getIndex(getKingRow(perspective), getKingColumn(perspective));
+    forEachChangedPiece(move, side, [&](PieceType pieceType, uint8_t row, uint8_t col, int32_t change)
+    {
+      mNetwork->updateAccumulator(accumulator, perspective, kingSquare, pieceType, getIndex(row, col), change);
+    });
+  }
+}
+
+void Board::refreshAccumulators()
+{
+  mAccumulators.clear();
+  if (mNetwork != nullptr)
+  {
+    mAccumulators.resize(1);
+    mNetwork->refreshAccumulator(this, Color::White, mAccumulators[0]);
+    mNetwork->refreshAccumulator(this, Color::Black, mAccumulators[0]);
+  }
+}
+
 void Board::reset()
 {
   init();
   doReset();
+  refreshAccumulators();
+}
+
+void Board::setCastlingRights(uint8_t value)
+{
+  mHashKey ^= Zobrist::getCastlingKey(mCastlingRights) ^ Zobrist::getCastlingKey(value);
+  mPolyglotKey ^= Polyglot::getCastlingKey(mCastlingRights) ^ Polyglot::getCastlingKey(value);
+  mCastlingRights = value;
+}
+
+void Board::setEnPassantColumn(uint8_t value)
+{
+  mHashKey ^= Zobrist::getEnPassantKey(mEnPassantColumn) ^ Zobrist::getEnPassantKey(value);
+  mEnPassantColumn = value;
+
+  // The column is set while the side that pushed the pawn is still to move
+  mPolyglotKey ^= mPolyglotEnPassantKey;
+  mPolyglotEnPassantKey = getPolyglotEnPassantKey(!mSideToMove);
+  mPolyglotKey ^= mPolyglotEnPassantKey;
+}
+
+void Board::setNetwork(const Network * network)
+{
+  mNetwork = network;
+  refreshAccumulators();
 }
 
 bool Board::setPieceType(uint8_t row, uint8_t col, PieceType pieceType)
 {
+  togglePiece(getPieceType(row, col), row, col, -1);
+  togglePiece(pieceType, row, col, 1);
+
   if (pieceType == PieceType::WhiteKing)
   {
     mKingRow[Color::White] = row;
@@ -144,7 +525,9 @@ bool Board::setPieceType(uint8_t row, uint8_t col, PieceType pieceType)
     mKingColumn[Color::Black] = col;
   }
 
-  return doSetPieceType(row, col, pieceType);
+  bool result = doSetPieceType(row, col, pieceType);
+  refreshAccumulators();
+  return result;
 }
 
 bool Board::setPosition(const std::string & fenString)
@@ -183,7 +566,42 @@ bool Board::setPosition(const std::string & fenString)
   setHalfMoveClock(fen.getHalfMoveClock());
   setSideToMove(fen.getSideToMove());
 
-  return doSetPosition(fen);
+  bool result = doSetPosition(fen);
+  mHashKey = computeHashKey();
+  mPolyglotEnPassantKey = getPolyglotEnPassantKey(mSideToMove);
+  mPolyglotKey = computePolyglotKey();
+  mMaterialKey = computeMaterialKey();
+  mPawnHashKey = computePawnHashKey();
+  mPieceSquareScore = computePieceSquareScore();
+  mPhase = computePhase();
+  mHashHistory.clear();
+  mNullMoveHistory.clear();
+  refreshAccumulators();
+  return result;
+}
+
+void Board::setSideToMove(Color value)
+{
+  if (value != mSideToMove)
+  {
+    mHashKey ^= Zobrist::getSideKey();
+    mPolyglotKey ^= Polyglot::getSideKey();
+  }
+  mSideToMove = value;
+}
+
+void Board::togglePiece(PieceType pieceType, uint8_t row, uint8_t col, int32_t sign)
+{
+  uint64_t key = Zobrist::getPieceKey(pieceType, row, col);
+  mHashKey ^= key;
+  mPolyglotKey ^= Polyglot::getPieceKey(pieceType, row, col);
+  if (pieceType == PieceType::WhitePawn || pieceType == PieceType::BlackPawn)
+  {
+    mPawnHashKey ^= key;
+  }
+  mMaterialKey += (sign > 0) ? MaterialTable::getPieceKey(pieceType) : -MaterialTable::getPieceKey(pieceType);
+  mPieceSquareScore += sign * PieceSquare::getValue(pieceType, row, col);
+  mPhase += sign * PieceSquare::getPhase(pieceType);
 }
 
 bool Board::unmakeMove(const Move * move)
@@ -199,6 +617,14 @@ bool Board::unmakeMove(const Move * move)
 
   // Let subclasses update their state
   doUnmakeMove(move);
+  if (!move->isNull())
+  {
+    updatePieces(move, otherSide, -1);
+    if (mNetwork != nullptr)
+    {
+      mAccumulators.pop_back();
+    }
+  }
 
   // Reset the board state
   setFullMoveCounter(move->getFullMoveCounter());
@@ -208,6 +634,15 @@ bool Board::unmakeMove(const Move * move)
 
   setSideToMove(otherSide);
 
+  if (!mHashHistory.empty())
+  {
+    mHashHistory.pop_back();
+  }
+  if (move->isNull() && !mNullMoveHistory.empty())
+  {
+    mNullMoveHistory.pop_back();
+  }
+
   return true;
 }
 
@@ -215,6 +650,7 @@ void Board::updateCastlingRights(const Move * move)
 {
   uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
   uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
+  uint8_t castlingRights = mCastlingRights;
 
   // Update castling rights
   // If the square associated with a king or rook is
@@ -223,46 +659,48 @@ void Board::updateCastlingRights(const Move * move)
   switch (fromSquare)
   {
   case H1:
-    mCastlingRights &= ~CASTLE_WHITE_KING;
+    castlingRights &= ~CASTLE_WHITE_KING;
     break;
   case E1:
-    mCastlingRights &= ~(CASTLE_WHITE_KING|CASTLE_WHITE_QUEEN);
+    castlingRights &= ~(CASTLE_WHITE_KING|CASTLE_WHITE_QUEEN);
     break;
   case A1:
-    mCastlingRights &= ~CASTLE_WHITE_QUEEN;
+    castlingRights &= ~CASTLE_WHITE_QUEEN;
     break;
   case H8:
-    mCastlingRights &= ~CASTLE_BLACK_KING;
+    castlingRights &= ~CASTLE_BLACK_KING;
     break;
   case E8:
-    mCastlingRights &= ~(CASTLE_BLACK_KING|CASTLE_BLACK_QUEEN);
+    castlingRights &= ~(CASTLE_BLACK_KING|CASTLE_BLACK_QUEEN);
     break;
   case A8:
-    mCastlingRights &= ~CASTLE_BLACK_QUEEN;
+    castlingRights &= ~CASTLE_BLACK_QUEEN;
     break;
   }
 
   switch (toSquare)
   {
   case H1:
-    mCastlingRights &= ~CASTLE_WHITE_KING;
+    castlingRights &= ~CASTLE_WHITE_KING;
     break;
   case E1:
-    mCastlingRights &= ~(CASTLE_WHITE_KING|CASTLE_WHITE_QUEEN);
+    castlingRights &= ~(CASTLE_WHITE_KING|CASTLE_WHITE_QUEEN);
     break;
   case A1:
-    mCastlingRights &= ~CASTLE_WHITE_QUEEN;
+    castlingRights &= ~CASTLE_WHITE_QUEEN;
     break;
   case H8:
-    mCastlingRights &= ~CASTLE_BLACK_KING;
+    castlingRights &= ~CASTLE_BLACK_KING;
     break;
   case E8:
-    mCastlingRights &= ~(CASTLE_BLACK_KING|CASTLE_BLACK_QUEEN);
+    castlingRights &= ~(CASTLE_BLACK_KING|CASTLE_BLACK_QUEEN);
     break;
   case A8:
-    mCastlingRights &= ~CASTLE_BLACK_QUEEN;
+    castlingRights &= ~CASTLE_BLACK_QUEEN;
     break;
   }
+
+  setCastlingRights(castlingRights);
 }
 
 void Board::updateMoveClocks(const Move * move)
@@ -279,4 +717,12 @@ void Board::updateMoveClocks(const Move * move)
   }
 }
 
+void Board::updatePieces(const Move * move, Color side, int32_t sign)
+{
+  forEachChangedPiece(move, side, [this, sign](PieceType pieceType, uint8_t row, uint8_t col, int32_t change)
+  {
+    togglePiece(pieceType, row, col, sign * change);
+  });
+}
+
 }
@@ -10,15 +10,19 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "jcl_fen.h"
 #include "jcl_move.h"
 #include "jcl_movelist.h"
+#include "jcl_network.h"
 #include "jcl_types.h"
 
 namespace jcl
 {
 
+class BitBoard;
+
 /*!
  * \brief Defines a chess board
  *
@@ -51,6 +55,34 @@ public:
    */
   Board();
 
+  /*!
+   * \brief Computes the piece-square score from scratch
+   *
+   * This function sums the material and piece-square values of
+   * all pieces on the board. The board keeps this sum up to date
+   * as moves are made (see \ref getPieceSquareScore), so this is
+   * only needed when a position is set up.
+   *
+   * \return The packed material and piece-square score for the position
+   */
+  Score computePieceSquareScore() const;
+
+  /*!
+   * \brief Generates all capture moves
+   *
+   * This function is called to generate all pseudo-legal captures
+   * and promotions for the player that is currently moving. Only
+   * squares occupied by the opponent (and the promotion squares)
+   * are used as move targets so this is considerably cheaper than
+   * calling \ref generateMoves and filtering the result. This
+   * is primarily used by the quiescence search.
+   *
+   * \param moveList The move list to hold the moves
+   *
+   * \return true if successful, false otherwise
+   */
+  bool generateCaptures(MoveList & moveList) const;
+
   /*!
    * \brief Generates all moves
    *
@@ -102,6 +134,18 @@ public:
    */
   uint8_t getKingRow(Color color) const;
 
+  /*!
+   * \brief Returns a null move
+   *
+   * This function returns a null move for the current position.
+   * Making a null move passes the turn to the opponent without moving
+   * a piece and clears any en-passant capture. Like any other move it
+   * holds the board state needed to undo it with \ref unmakeMove.
+   *
+   * \return The null move for the current position
+   */
+  Move getNullMove() const;
+
   /*!
    * \brief Returns the piece type
    *
@@ -116,6 +160,44 @@ public:
    */
   PieceType getPieceType(uint8_t row, uint8_t col) const;
 
+  /*!
+   * \brief Returns the bitboards of all pieces
+   *
+   * This function returns the twelve piece bitboards, indexed by
+   * PieceType minus one, in the layout of \ref BitBoard. A BitBoard
+   * returns the bitboards it keeps; other boards are scanned into the
+   * supplied array, which is then returned.
+   *
+   * \param pieces The array filled in for boards without bitboards
+   *
+   * \return The twelve piece bitboards
+   */
+  const uint64_t * getPieceBitboards(uint64_t pieces[12]) const;
+
+  /*!
+   * \brief Returns the network accumulator for the position
+   *
+   * This function returns the feature transformer outputs of the
+   * network set by \ref setNetwork for the current position. The
+   * accumulator is updated incrementally when moves are made and
+   * restored from a stack when they are unmade. It must only be
+   * called when a network is set.
+   *
+   * \return The accumulator for the position
+   */
+  const Network::Accumulator & getAccumulator() const;
+
+  /*!
+   * \brief Returns the board as a bitboard representation
+   *
+   * This function lets the evaluation and search use the piece
+   * bitboards and attack tables of a \ref BitBoard without a
+   * dynamic_cast for every position they visit.
+   *
+   * \return The board, or nullptr if it does not keep bitboards
+   */
+  const BitBoard * getBitBoard() const;
+
   /*!
    * \brief Gets the current castling rights
    *
@@ -155,6 +237,89 @@ public:
    */
   uint32_t getFullMoveNumber() const;
 
+  /*!
+   * \brief Returns the hash key for the position
+   *
+   * This function returns a 64-bit Zobrist hash of the current
+   * position. The hash includes the pieces on the board, the side to
+   * move, the castling rights and the en-passant column. It is
+   * updated incrementally when moves are made and unmade, so two
+   * boards holding the same position will have the same hash key.
+   *
+   * \return The hash key for the position
+   */
+  uint64_t getHashKey() const;
+
+  /*!
+   * \brief Returns the Polyglot key
+   *
+   * This function returns the key of the current position in the
+   * Polyglot opening book format (see \ref Polyglot), which matches
+   * the books written by other programs. Like the hash key it is
+   * updated incrementally when moves are made and unmade.
+   *
+   * \return The Polyglot key for the position
+   */
+  uint64_t getPolyglotKey() const;
+
+  /*!
+   * \brief Returns the material key
+   *
+   * This function returns the count of each type of piece packed
+   * into one key (see \ref MaterialTable), which is maintained as
+   * moves are made and unmade. Positions with the same material share
+   * the same key, so it can be used to cache the evaluation of a
+   * material configuration.
+   *
+   * \return The material key
+   */
+  uint64_t getMaterialKey() const;
+
+  /*!
+   * \brief Returns the network
+   *
+   * \return The network used to evaluate the board, or nullptr if none is set
+   */
+  const Network * getNetwork() const;
+
+  /*!
+   * \brief Returns the pawn hash key
+   *
+   * This function returns a Zobrist hash of the pawns alone, which
+   * is maintained along with the hash key. Positions with the same
+   * pawn structure share the same pawn hash key, so it can be used
+   * to cache pawn structure evaluation.
+   *
+   * \return The pawn hash key
+   */
+  uint64_t getPawnHashKey() const;
+
+  /*!
+   * \brief Returns the game phase
+   *
+   * This function returns the sum of the phase weights of the pieces
+   * on the board (see \ref PieceSquare), which falls from
+   * PieceSquare::MAX_PHASE in the starting position towards zero as
+   * pieces are exchanged. It is maintained as moves are made and
+   * unmade.
+   *
+   * \return The game phase
+   */
+  int32_t getPhase() const;
+
+  /*!
+   * \brief Returns the material and piece-square score
+   *
+   * This function returns the sum of the material and piece-square
+   * values of all pieces on the board, positive when white is ahead,
+   * with the midgame and endgame values packed into one \ref Score.
+   * The sum is maintained as moves are made and unmade, so it is
+   * available without visiting the squares of the board.
+   *
+   * \return The packed material and piece-square score
+   */
+  Score getPieceSquareScore() const;
+
   /*!
    * \brief Returns the half move clock number
    *
@@ -168,6 +333,16 @@ public:
    */
   uint32_t getHalfMoveClock() const;
 
+  /*!
+   * \brief Returns the number of moves made on the board
+   *
+   * This function returns the number of moves, including null
+   * moves, made since the position was last set or reset.
+   *
+   * \return The number of moves made
+   */
+  uint32_t getHistorySize() const;
+
   /*!
    * \brief Returns the side to move
    *
@@ -194,6 +369,47 @@ public:
    */
   bool isCellAttacked(uint8_t row, uint8_t col, Color attackColor) const;
 
+  /*!
+   * \brief Determines if the game is drawn by the fifty-move rule
+   *
+   * This function returns true when one hundred half moves have
+   * been played without a pawn move or capture. It does not check
+   * whether the side to move has been mated on the last move.
+   *
+   * \return true if the fifty-move rule applies, false otherwise
+   */
+  bool isDrawByFiftyMove() const;
+
+  /*!
+   * \brief Determines if the current position is drawn by repetition in a search
+   *
+   * This function treats a position as drawn when it repeats one
+   * reached after the root of the search, since the side to move
+   * could then repeat it again. A position that only repeats ones
+   * from the game history, including the root, is drawn when it has
+   * occurred twice before, as the threefold repetition rule requires.
+   *
+   * \param rootPly The history size when the search started, see \ref getHistorySize
+   *
+   * \return true if the position is drawn by repetition, false otherwise
+   */
+  bool isDrawByRepetition(uint32_t rootPly) const;
+
+  /*!
+   * \brief Determines if the current position is a repetition
+   *
+   * This function compares the hash key of the current position with
+   * the positions reached since the last irreversible move, as given
+   * by the half move clock, or the last null move. Only positions with
+   * the same side to move are compared. A game is drawn when the
+   * position has occurred twice before.
+   *
+   * \param count The number of earlier occurrences required
+   *
+   * \return true if the position occurred at least count times before, false otherwise
+   */
+  bool isRepetition(uint32_t count = 1) const;
+
   /*!
    * \brief Makes a move
    *
@@ -278,6 +494,19 @@ public:
    */
   void setSideToMove(Color value);
 
+  /*!
+   * \brief Sets the network
+   *
+   * This function sets the network used to evaluate the board and
+   * computes its accumulator for the current position. While a
+   * network is set, each move made pushes an updated accumulator
+   * and each move unmade pops it. The network must have weights
+   * loaded and must outlive the board or be unset first.
+   *
+   * \param network The network, or nullptr to stop maintaining accumulators
+   */
+  void setNetwork(const Network * network);
+
   /*!
    * \brief Sets the piece type
    *
@@ -320,6 +549,40 @@ public:
 
 protected:
 
+  /*!
+   * \brief Constructor
+   *
+   * Defines a default Board object for a derived representation.
+   *
+   * \param isBitBoard true if the derived class is a \ref BitBoard
+   */
+  explicit Board(bool isBitBoard);
+
+  /*!
+   * \brief Computes the piece-square score from scratch
+   *
+   * This function sums the piece-square values of every square on
+   * the board. Derived classes may override this function when
+   * they can compute the sum without visiting every square.
+   *
+   * \return The packed material and piece-square score for the position
+   */
+  virtual Score doComputePieceSquareScore() const;
+
+  /*!
+   * \brief Generates a capture move list
+   *
+   * This function generates all pseudo-legal captures and
+   * promotions for the current position. Derived classes
+   * must override this function to generate these moves
+   * using only the opponent occupied squares as targets.
+   *
+   * \param moveList The move list to update
+   *
+   * \return true if the function is successful, false otherwise
+   */
+  virtual bool doGenerateCaptures(MoveList & moveList) const = 0;
+
   /*!
    * \brief Generates a move list
    *
@@ -493,6 +756,44 @@ protected:
 
 private:
 
+  /*!
+   * \brief Computes the hash key from scratch
+   *
+   * This function computes the hash key for the current position
+   * from the pieces on the board and the board state.
+   *
+   * \return The hash key for the position
+   */
+  uint64_t computeHashKey() const;
+
+  /*!
+   * \brief Computes the material key from scratch
+   *
+   * \return The material key for the position
+   */
+  uint64_t computeMaterialKey() const;
+
+  /*!
+   * \brief Computes the pawn hash key from scratch
+   *
+   * \return The pawn hash key for the position
+   */
+  uint64_t computePawnHashKey() const;
+
+  /*!
+   * \brief Computes the Polyglot key from scratch
+   *
+   * \return The Polyglot key for the position
+   */
+  uint64_t computePolyglotKey() const;
+
+  /*!
+   * \brief Computes the game phase from scratch
+   *
+   * \return The game phase for the position
+   */
+  int32_t computePhase() const;
+
   /*!
    * \brief Initializes the board
    *
@@ -500,6 +801,43 @@ private:
    */
   void init();
 
+  /*!
+   * \brief Pushes the accumulator for a move
+   *
+   * This function pushes a copy of the current accumulator and
+   * updates it for the pieces changed by the move. A king move
+   * refreshes the accumulator of the side that moved. It must be
+   * called after the move has been made on the board.
+   *
+   * \param move The move
+   * \param side The side making the move
+   */
+  void pushAccumulator(const Move * move, Color side);
+
+  /*!
+   * \brief Resets the accumulator stack to the current position
+   */
+  void refreshAccumulators();
+
+  /*!
+   * \brief Returns the Polyglot en-passant key for the current column
+   *
+   * The key is zero unless a pawn of the capturing side stands
+   * beside the pawn that was pushed two squares.
+   *
+   * \param side The side that could capture en-passant
+   *
+   * \return The en-passant key, or zero
+   */
+  uint64_t getPolyglotEnPassantKey(Color side) const;
+
+  /*!
+   * \brief Returns how many plies back a position can repeat
+   *
+   * \return The plies since the last irreversible or null move
+   */
+  uint32_t getRepetitionDistance() const;
+
   /*!
    * \brief Updates the castling rights
    *
@@ -520,16 +858,57 @@ private:
    */
   void updateMoveClocks(const Move * move);
 
+  /*!
+   * \brief Updates the hash key and score for the pieces of a move
+   *
+   * This function adds or removes all pieces moved, captured or
+   * promoted by the move from the hash key and the piece-square
+   * score. The same call is used with the opposite sign to unmake
+   * the move.
+   *
+   * \param move The move
+   * \param side The side making the move
+   * \param sign 1 to make the move, -1 to unmake it
+   */
+  void updatePieces(const Move * move, Color side, int32_t sign);
+
+  /*!
+   * \brief Adds or removes a piece from the hash keys, score and phase
+   *
+   * \param pieceType The type of piece
+   * \param row The row of the piece
+   * \param col The column of the piece
+   * \param sign 1 to add the piece, -1 to remove it
+   */
+  void togglePiece(PieceType pieceType, uint8_t row, uint8_t col, int32_t sign);
+
   // Members
+  std::vector<Network::Accumulator> mAccumulators; // Network accumulators, one for each move made
   uint8_t mCastlingRights;              // Current castling rights
   uint8_t mEnPassantColumn;             // Current en-passant capture column
   uint32_t mFullMoveCounter;            // Current full move counter
   uint32_t mHalfMoveClock;              // Current half move clock
+  uint64_t mHashKey;                    // Current Zobrist hash of the position
+  uint64_t mMaterialKey;                // Current count of each type of piece
+  uint64_t mPawnHashKey;                // Current Zobrist hash of the pawns
+  uint64_t mPolyglotKey;                // Current Polyglot key of the position
+  uint64_t mPolyglotEnPassantKey;       // En-passant key included in the Polyglot key
+  std::vector<uint64_t> mHashHistory;   // Hash keys of the positions before each move made
+  std::vector<uint32_t> mNullMoveHistory; // History sizes just after each null move made
+  bool mIsBitBoard;                     // Whether the board is a BitBoard
+  const Network * mNetwork;             // Network maintained by the board, if any
+  int32_t mPhase;                       // Current game phase
+  Score mPieceSquareScore;              // Current material and piece-square score
   Color mSideToMove;                    // Current side to move
   std::map<Color, uint8_t> mKingColumn; // Column for king for each side
   std::map<Color, uint8_t> mKingRow;    // Row for king for each side
 };
 
+inline const Network::Accumulator & Board::getAccumulator() const
+{
+  return mAccumulators.back();
+}
+
 inline uint8_t Board::getCastlingRights() const
 {
   return mCastlingRights;
@@ -545,24 +924,54 @@ inline uint32_t Board::getFullMoveNumber() const
   return mFullMoveCounter;
 }
 
-inline uint32_t Board::getHalfMoveClock() const
+inline uint64_t Board::getHashKey() const
 {
-  return mHalfMoveClock;
+  return mHashKey;
 }
 
-inline Color Board::getSideToMove() const
+inline uint64_t Board::getPolyglotKey() const
 {
-  return mSideToMove;
+  return mPolyglotKey;
 }
 
-inline void Board::setCastlingRights(uint8_t value)
+inline uint64_t Board::getMaterialKey() const
 {
-  mCastlingRights = value;
+  return mMaterialKey;
 }
 
-inline void Board::setEnPassantColumn(uint8_t value)
+inline const Network * Board::getNetwork() const
 {
-  mEnPassantColumn = value;
+  return mNetwork;
+}
+
+inline uint64_t Board::getPawnHashKey() const
+{
+  return mPawnHashKey;
+}
+
+inline int32_t Board::getPhase() const
+{
+  return mPhase;
+}
+
+inline Score Board::getPieceSquareScore() const
+{
+  return mPieceSquareScore;
+}
+
+inline uint32_t Board::getHalfMoveClock() const
+{
+  return mHalfMoveClock;
+}
+
+inline uint32_t Board::getHistorySize() const
+{
+  return static_cast<uint32_t>(mHashHistory.size());
+}
+
+inline Color Board::getSideToMove() const
+{
+  return mSideToMove;
 }
 
 inline void Board::setFullMoveCounter(uint32_t value)
@@ -575,11 +984,6 @@ inline void Board::setHalfMoveClock(uint32_t value)
   mHalfMoveClock = value;
 }
 
-inline void Board::setSideToMove(Color value)
-{
-  mSideToMove = value;
-}
-
 }
 
 #endif // #ifndef JCL_BOARD_H
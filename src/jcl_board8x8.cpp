@@ -43,6 +43,15 @@ Board8x8::Board8x8()
   initBoard();
 }
 
+bool Board8x8::doGenerateCaptures(MoveList & moveList) const
+{
+  for (uint8_t index = 0; index < 64; index++)
+  {
+    generatePieceCaptures(index, moveList);
+  }
+  return true;
+}
+
 bool Board8x8::doGenerateMoves(MoveList & moveList) const
 {
   generateCastlingMoves(moveList);
@@ -107,6 +116,12 @@ bool Board8x8::doIsCellAttacked(uint8_t row,
 
 bool Board8x8::doMakeMove(const Move * move)
 {
+  // Null moves do not change any squares
+  if (move->isNull())
+  {
+    return true;
+  }
+
   Color side = this->getSideToMove();
   uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
   uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
@@ -372,6 +387,12 @@ bool Board8x8::doSetPosition(const Fen & fen)
 
 bool Board8x8::doUnmakeMove(const Move * move)
 {
+  // Null moves do not change any squares
+  if (move->isNull())
+  {
+    return true;
+  }
+
   Color side = this->getSideToMove();
   uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
   uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
@@ -506,6 +527,70 @@ void Board8x8::generateCastlingMoves(MoveList & moveList) const
 
 
 
+void Board8x8::generatePieceCaptures(uint8_t index,
+                                     MoveList & moveList) const
+{
+  Piece piece = mPieces[index];
+  Color sideToMove = this->getSideToMove();
+
+  if (piece == Piece::None || mColors[index] != sideToMove)
+  {
+    return;
+  }
+
+  if (piece == Piece::Bishop)
+  {
+    generateSliderCaptures(index, +1, +1, true, moveList);
+    generateSliderCaptures(index, +1, -1, true, moveList);
+    generateSliderCaptures(index, -1, +1, true, moveList);
+    generateSliderCaptures(index, -1, -1, true, moveList);
+  }
+  else if (piece == Piece::Rook)
+  {
+    generateSliderCaptures(index, +1, +0, true, moveList);
+    generateSliderCaptures(index, -1, +0, true, moveList);
+    generateSliderCaptures(index, +0, +1, true, moveList);
+    generateSliderCaptures(index, +0, -1, true, moveList);
+  }
+  else if (piece == Piece::Queen)
+  {
+    generateSliderCaptures(index, +1, +1, true, moveList);
+    generateSliderCaptures(index, +1, -1, true, moveList);
+    generateSliderCaptures(index, -1, +1, true, moveList);
+    generateSliderCaptures(index, -1, -1, true, moveList);
+    generateSliderCaptures(index, +1, +0, true, moveList);
+    generateSliderCaptures(index, -1, +0, true, moveList);
+    generateSliderCaptures(index, +0, +1, true, moveList);
+    generateSliderCaptures(index, +0, -1, true, moveList);
+  }
+  else if (piece == Piece::King)
+  {
+    generateSliderCaptures(index, +1, +1, false, moveList);
+    generateSliderCaptures(index, +1, -1, false, moveList);
+    generateSliderCaptures(index, -1, +1, false, moveList);
+    generateSliderCaptures(index, -1, -1, false, moveList);
+    generateSliderCaptures(index, +1, +0, false, moveList);
+    generateSliderCaptures(index, -1, +0, false, moveList);
+    generateSliderCaptures(index, +0, +1, false, moveList);
+    generateSliderCaptures(index, +0, -1, false, moveList);
+  }
+  else if (piece == Piece::Knight)
+  {
+    generateSliderCaptures(index, +2, +1, false, moveList);
+    generateSliderCaptures(index, +2, -1, false, moveList);
+    generateSliderCaptures(index, +1, -2, false, moveList);
+    generateSliderCaptures(index, -1, -2, false, moveList);
+    generateSliderCaptures(index, -2, -1, false, moveList);
+    generateSliderCaptures(index, -2, +1, false, moveList);
+    generateSliderCaptures(index, -1, +2, false, moveList);
+    generateSliderCaptures(index, +1, +2, false, moveList);
+  }
+  else if (piece == Piece::Pawn)
+  {
+    generatePawnCaptures(index, sideToMove, moveList);
+  }
+}
+
 bool Board8x8::generateMoves(uint8_t row,
                              uint8_t col,
                              MoveList & moveList,
@@ -638,6 +723,103 @@ void Board8x8::generateSliderMoves(uint8_t index,
   }
 }
 
+void Board8x8::generateSliderCaptures(uint8_t index,
+                                      int8_t rowIncrement,
+                                      int8_t colIncrement,
+                                      bool slider,
+                                      MoveList & moveList) const
+{
+  Piece piece = mPieces[index];
+  Color otherSide = !this->getSideToMove();
+  uint8_t row = getRow(index);
+  uint8_t col = getCol(index);
+
+  int8_t destRow = row + rowIncrement;
+  int8_t destCol = col + colIncrement;
+  while (destRow >= 0 && destRow <= 7 && destCol >= 0 && destCol <= 7)
+  {
+    uint8_t destIndex = getIndex(destRow, destCol);
+    Piece destPiece = mPieces[destIndex];
+    if (destPiece != Piece::None)
+    {
+      if (mColors[destIndex] == otherSide)
+      {
+        pushMove(row, col, destRow, destCol, piece, destPiece, Piece::None, Move::Type::Capture, moveList);
+      }
+      break;
+    }
+
+    if (!slider)
+    {
+      break;
+    }
+
+    destRow += rowIncrement;
+    destCol += colIncrement;
+  }
+}
+
+void Board8x8::generatePawnCaptures(uint8_t index,
+                                    Color sideToMove,
+                                    MoveList & moveList) const
+{
+  Color otherSide = !sideToMove;
+  int8_t row = getRow(index);
+  int8_t col = getCol(index);
+  int8_t rowIncr = (sideToMove == Color::White) ? +1 : -1;
+  int8_t destRow = row + rowIncr;
+
+  if (destRow < 0 || destRow > 7)
+  {
+    return;
+  }
+
+  bool promotion = (destRow == 0 || destRow == 7);
+
+  // Generate promotions from a standard push
+  if (promotion && mPieces[getIndex(destRow, col)] == Piece::None)
+  {
+    pushMove(row, col, destRow, col, Piece::Pawn, Piece::None, Piece::Queen, Move::Type::Promotion, moveList);
+    pushMove(row, col, destRow, col, Piece::Pawn, Piece::None, Piece::Rook, Move::Type::Promotion, moveList);
+    pushMove(row, col, destRow, col, Piece::Pawn, Piece::None, Piece::Bishop, Move::Type::Promotion, moveList);
+    pushMove(row, col, destRow, col, Piece::Pawn, Piece::None, Piece::Knight, Move::Type::Promotion, moveList);
+  }
+
+  // Generate capture moves
+  int8_t enPassantColumn = getEnpassantColumn();
+  int8_t enPassantRow = (sideToMove == Color::White) ? 5 : 2;
+  constexpr int8_t dirs[] = {EAST, WEST};
+  for (int8_t i = 0; i < 2; i++)
+  {
+    int8_t destCol = col + dirs[i];
+    if (destCol < 0 || destCol > 7)
+    {
+      continue;
+    }
+
+    uint8_t destIndex = getIndex(destRow, destCol);
+    Piece capturePiece = mPieces[destIndex];
+    if (capturePiece != Piece::None && mColors[destIndex] == otherSide)
+    {
+      if (promotion)
+      {
+        pushMove(row, col, destRow, destCol, Piece::Pawn, capturePiece, Piece::Queen, Move::Type::PromotionCapture, moveList);
+        pushMove(row, col, destRow, destCol, Piece::Pawn, capturePiece, Piece::Rook, Move::Type::PromotionCapture, moveList);
+        pushMove(row, col, destRow, destCol, Piece::Pawn, capturePiece, Piece::Bishop, Move::Type::PromotionCapture, moveList);
+        pushMove(row, col, destRow, destCol, Piece::Pawn, capturePiece, Piece::Knight, Move::Type::PromotionCapture, moveList);
+      }
+      else
+      {
+        pushMove(row, col, destRow, destCol, Piece::Pawn, capturePiece, Piece::None, Move::Type::Capture, moveList);
+      }
+    }
+    else if (destRow == enPassantRow && destCol == enPassantColumn)
+    {
+      pushMove(row, col, destRow, destCol, Piece::Pawn, Piece::Pawn, Piece::Pawn, Move::Type::EpCapture, moveList);
+    }
+  }
+}
+
 void Board8x8::generatePawnMoves(uint8_t index,
                                  Color sideToMove,
                                  MoveList & moveList) const
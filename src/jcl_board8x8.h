@@ -48,6 +48,7 @@ public:
 protected:
 
   // Overrides
+  bool doGenerateCaptures(MoveList & moveList) const override;
   bool doGenerateMoves(MoveList & moveList) const override;
   bool doGenerateMoves(uint8_t row, uint8_t col, MoveList & moveList) const override;
   PieceType doGetPieceType(uint8_t row, uint8_t col) const override;
@@ -73,6 +74,20 @@ private:
    */
   void generateCastlingMoves(MoveList & moveList) const;
 
+  /*!
+   * \brief Generates the capture moves for an index
+   *
+   * This function generates all captures and promotions for
+   * the piece located at the specified index. Only squares
+   * occupied by an opposing piece are used as destinations
+   * with the exception of pawn promotions and enpassant captures.
+   *
+   * \param index The index of the piece
+   * \param moveList The move list to update
+   */
+  void generatePieceCaptures(uint8_t index,
+                             MoveList & moveList) const;
+
   /*!
    * \brief Generates a move list
    *
@@ -140,6 +155,42 @@ private:
                          Color sideToMove,
                          MoveList & moveList) const;
 
+  /*!
+   * \brief Generates the pawn captures for an index
+   *
+   * This function generates all captures, including enpassant
+   * captures, and all promotions for a pawn located at the
+   * specified index.
+   *
+   * \param index The index of the pawn
+   * \param sideToMove The color of the pawn
+   * \param moveList The move list to hold the moves
+   */
+  void generatePawnCaptures(uint8_t index,
+                            Color sideToMove,
+                            MoveList & moveList) const;
+
+  /*!
+   * \brief Generates non-pawn captures
+   *
+   * This function follows a single direction from the piece
+   * at the specified index until an occupied square is found
+   * and generates a capture if that square holds an opposing
+   * piece. See \ref generateSliderMoves for a description of
+   * the parameters.
+   *
+   * \param index The index of the piece
+   * \param rowIncrement The displacement in row for each move
+   * \param colIncrement The displacement in column for each move
+   * \param slider true if the piece is a sliding piece
+   * \param moveList The list to hold the moves
+   */
+  void generateSliderCaptures(uint8_t index,
+                              int8_t rowIncrement,
+                              int8_t colIncrement,
+                              bool slider,
+                              MoveList & moveList) const;
+
   /*!
    * \brief Generates non-pawn moves
    *
@@ -0,0 +1,230 @@
+/*!
+ * \file jcl_endgame.cpp
+ *
+ * This file contains the implementation for the Endgame object
+ */
+
+#include "jcl_endgame.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "jcl_bitbase.h"
+#include "jcl_bitboard.h"
+#include "jcl_piecesquare.h"
+
+namespace jcl
+{
+
+// Bonus that keeps a won endgame ahead of any material the general evaluation sees
+static const int32_t KnownWin = 1000;
+
+// Returns the row of a square as seen from a side, so that row 0 is its home row
+static int32_t getRow(uint8_t square, Color color)
+{
+  int32_t row = square >> 3;
+  return (color == Color::White) ? row : 7 - row;
+}
+
+// Returns the column of a square, bit zero being h1
+static int32_t getColumn(uint8_t square)
+{
+  return 7 - (square & 7);
+}
+
+// Returns the number of king moves between two squares
+static int32_t getDistance(uint8_t first, uint8_t second)
+{
+  return std::max(std::abs((first >> 3) - (second >> 3)), std::abs((first & 7) - (second & 7)));
+}
+
+// Returns whether a square is dark, a1 being dark
+static bool isDark(uint8_t square)
+{
+  return (((square >> 3) + getColumn(square)) & 1) == 0;
+}
+
+// Returns a bonus for a king far from the centre
+static int32_t pushToEdge(uint8_t square)
+{
+  int32_t row = square >> 3;
+  int32_t col = getColumn(square);
+  return 10 * (std::abs(2 * row - 7) + std::abs(2 * col - 7));
+}
+
+// Returns a bonus for two kings close together
+static int32_t pushClose(uint8_t first, uint8_t second)
+{
+  return 140 - 20 * getDistance(first, second);
+}
+
+void Endgame::assign(MaterialTable::Entry * entry)
+{
+  uint32_t pawns[2], knights[2], bishops[2], rooks[2], queens[2];
+  int32_t material[2];
+  for (int side = 0; side < 2; side++)
+  {
+    uint32_t offset = getSideOffset(static_cast<Color>(side));
+    pawns[side] = MaterialTable::getPieceCount(entry->key, static_cast<PieceType>(offset + 1 + PAWNS));
+    rooks[side] = MaterialTable::getPieceCount(entry->key, static_cast<PieceType>(offset + 1 + ROOKS));
+    knights[side] = MaterialTable::getPieceCount(entry->key, static_cast<PieceType>(offset + 1 + KNIGHTS));
+    bishops[side] = MaterialTable::getPieceCount(entry->key, static_cast<PieceType>(offset + 1 + BISHOPS));
+    queens[side] = MaterialTable::getPieceCount(entry->key, static_cast<PieceType>(offset + 1 + QUEENS));
+    material[side] = knights[side] * PieceSquareValues::KNIGHT_WEIGHT_MG + bishops[side] * PieceSquareValues::BISHOP_WEIGHT_MG +
+                     rooks[side] * PieceSquareValues::ROOK_WEIGHT_MG + queens[side] * PieceSquareValues::QUEEN_WEIGHT_MG;
+  }
+
+  entry->strongSide = Color::White;
+  entry->evaluate = nullptr;
+  entry->scale = nullptr;
+  for (int side = 0; side < 2; side++)
+  {
+    int other = 1 - side;
+
+    // Without pawns a side needs more than a minor piece of advantage to win
+    entry->factor[side] = MaterialTable::SCALE_NORMAL;
+    if (pawns[side] == 0 && material[side] - material[other] <= PieceSquareValues::BISHOP_WEIGHT_MG)
+    {
+      entry->factor[side] = (material[side] < PieceSquareValues::ROOK_WEIGHT_MG) ? 0 : ((material[other] <= PieceSquareValues::BISHOP_WEIGHT_MG) ? 4 : 14);
+    }
+
+    // Two knights cannot force mate against a lone king
+    bool twoKnights = (pawns[side] == 0 && material[side] == 2 * PieceSquareValues::KNIGHT_WEIGHT_MG && knights[side] == 2);
+    bool loneKing = (pawns[other] == 0 && material[other] == 0);
+    if (twoKnights && loneKing)
+    {
+      entry->factor[side] = 0;
+    }
+
+    if (loneKing && pawns[side] == 0 && knights[side] == 1 && bishops[side] == 1 && rooks[side] == 0 && queens[side] == 0)
+    {
+      entry->strongSide = static_cast<Color>(side);
+      entry->evaluate = &Endgame::evaluateKBNK;
+    }
+    else if (loneKing && !twoKnights && material[side] >= PieceSquareValues::ROOK_WEIGHT_MG)
+    {
+      entry->strongSide = static_cast<Color>(side);
+      entry->evaluate = &Endgame::evaluateKXK;
+    }
+    else if (loneKing && pawns[side] == 1 && material[side] == 0)
+    {
+      entry->strongSide = static_cast<Color>(side);
+      entry->evaluate = &Endgame::evaluateKPK;
+    }
+    else if (pawns[side] == 0 && material[side] == PieceSquareValues::ROOK_WEIGHT_MG && rooks[side] == 1 &&
+             pawns[other] == 1 && material[other] == 0)
+    {
+      entry->strongSide = static_cast<Color>(side);
+      entry->evaluate = &Endgame::evaluateKRKP;
+    }
+  }
+
+  // A bishop each and nothing but pawns besides
+  if (entry->evaluate == nullptr && bishops[0] == 1 && bishops[1] == 1 &&
+      material[0] == PieceSquareValues::BISHOP_WEIGHT_MG && material[1] == PieceSquareValues::BISHOP_WEIGHT_MG)
+  {
+    entry->scale = &Endgame::scaleOppositeBishops;
+  }
+}
+
+int32_t Endgame::evaluateKBNK(const uint64_t * pieces, Color strongSide, Color)
+{
+  const uint64_t * strong = getSideBitboards(pieces, strongSide);
+  const uint64_t * weak = getSideBitboards(pieces, !strongSide);
+  uint8_t strongKing = bitScanForward(strong[KINGS]);
+  uint8_t weakKing = bitScanForward(weak[KINGS]);
+
+  // Mate can only be forced in a corner the bishop covers
+  int32_t row = weakKing >> 3;
+  int32_t col = getColumn(weakKing);
+  int32_t cornerDistance = isDark(bitScanForward(strong[BISHOPS])) ? std::min(row + col, 14 - row - col)
+                                                                     : std::min(row + 7 - col, 7 - row + col);
+
+  int32_t score = KnownWin + PieceSquareValues::BISHOP_WEIGHT_EG + PieceSquareValues::KNIGHT_WEIGHT_EG;
+  score += 20 * (7 - cornerDistance) + pushClose(strongKing, weakKing);
+  return score;
+}
+
+int32_t Endgame::evaluateKPK(const uint64_t * pieces, Color strongSide, Color sideToMove)
+{
+  const uint64_t * strong = getSideBitboards(pieces, strongSide);
+  uint8_t strongKing = bitScanForward(strong[KINGS]);
+  uint8_t weakKing = bitScanForward(getSideBitboards(pieces, !strongSide)[KINGS]);
+  uint8_t pawn = bitScanForward(strong[PAWNS]);
+  if (!Bitbase::probeKPK(strongKing, pawn, weakKing, strongSide, sideToMove))
+  {
+    return 0;
+  }
+
+  // A won position still needs the pawn pushed to promote
+  return KnownWin + PieceSquareValues::PAWN_WEIGHT_EG + 20 * getRow(pawn, strongSide);
+}
+
+int32_t Endgame::evaluateKRKP(const uint64_t * pieces, Color strongSide, Color sideToMove)
+{
+  const uint64_t * strong = getSideBitboards(pieces, strongSide);
+  const uint64_t * weak = getSideBitboards(pieces, !strongSide);
+  uint8_t strongKing = bitScanForward(strong[KINGS]);
+  uint8_t weakKing = bitScanForward(weak[KINGS]);
+  uint8_t rook = bitScanForward(strong[ROOKS]);
+  uint8_t pawn = bitScanForward(weak[PAWNS]);
+
+  // Rows are seen from the strong side, so the pawn promotes on row 0
+  int32_t pawnRow = getRow(pawn, strongSide);
+  uint8_t queeningSquare = static_cast<uint8_t>(((strongSide == Color::White) ? 0 : 56) + (pawn & 7));
+  uint8_t stopSquare = static_cast<uint8_t>((strongSide == Color::White) ? pawn - 8 : pawn + 8);
+  int32_t tempo = (sideToMove == strongSide) ? 1 : 0;
+
+  // The strong king in front of the pawn, or the weak king too far from it, wins the pawn
+  if (getColumn(strongKing) == getColumn(pawn) && getRow(strongKing, strongSide) < pawnRow)
+  {
+    return PieceSquareValues::ROOK_WEIGHT_EG - getDistance(strongKing, pawn);
+  }
+
+  if (getDistance(weakKing, pawn) >= 3 + (1 - tempo) && getDistance(weakKing, rook) >= 3)
+  {
+    return PieceSquareValues::ROOK_WEIGHT_EG - getDistance(strongKing, pawn);
+  }
+
+  // An advanced pawn supported by its king against a distant king is a likely draw
+  if (getRow(weakKing, strongSide) <= 2 && getDistance(weakKing, pawn) == 1 &&
+      getRow(strongKing, strongSide) >= 3 && getDistance(strongKing, pawn) > 2 + tempo)
+  {
+    return 80 - 8 * getDistance(strongKing, pawn);
+  }
+
+  return 200 - 8 * (getDistance(strongKing, stopSquare) - getDistance(weakKing, stopSquare) - getDistance(pawn, queeningSquare));
+}
+
+int32_t Endgame::evaluateKXK(const uint64_t * pieces, Color strongSide, Color)
+{
+  const uint64_t * strong = getSideBitboards(pieces, strongSide);
+  const uint64_t * weak = getSideBitboards(pieces, !strongSide);
+  uint8_t strongKing = bitScanForward(strong[KINGS]);
+  uint8_t weakKing = bitScanForward(weak[KINGS]);
+
+  int32_t score = KnownWin;
+  score += static_cast<int32_t>(popCount(strong[PAWNS])) * PieceSquareValues::PAWN_WEIGHT_EG;
+  score += static_cast<int32_t>(popCount(strong[KNIGHTS])) * PieceSquareValues::KNIGHT_WEIGHT_EG;
+  score += static_cast<int32_t>(popCount(strong[BISHOPS])) * PieceSquareValues::BISHOP_WEIGHT_EG;
+  score += static_cast<int32_t>(popCount(strong[ROOKS])) * PieceSquareValues::ROOK_WEIGHT_EG;
+  score += static_cast<int32_t>(popCount(strong[QUEENS])) * PieceSquareValues::QUEEN_WEIGHT_EG;
+  score += pushToEdge(weakKing) + pushClose(strongKing, weakKing);
+  return score;
+}
+
+int32_t Endgame::scaleOppositeBishops(const uint64_t * pieces, Color)
+{
+  uint8_t whiteBishop = bitScanForward(getSideBitboards(pieces, Color::White)[BISHOPS]);
+  uint8_t blackBishop = bitScanForward(getSideBitboards(pieces, Color::Black)[BISHOPS]);
+  if (isDark(whiteBishop) == isDark(blackBishop))
+  {
+    return MaterialTable::SCALE_NORMAL;
+  }
+
+  // With a pawn or less left the ending is almost always drawn
+  uint32_t pawns = popCount(getSideBitboards(pieces, Color::White)[PAWNS] | getSideBitboards(pieces, Color::Black)[PAWNS]);
+  return (pawns <= 1) ? 8 : 32;
+}
+
+}
@@ -0,0 +1,119 @@
+/*!
+ * \file jcl_endgame.h
+ *
+ * This file contains the interface for the Endgame object
+ */
+
+#ifndef JCL_ENDGAME_H
+#define JCL_ENDGAME_H
+
+#include <cstdint>
+
+#include "jcl_materialtable.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines the evaluation of specific endgames
+ *
+ * The Endgame class recognizes material configurations that the
+ * general evaluation misjudges and chooses how to evaluate them. It
+ * is consulted once for each configuration, when its entry in the
+ * \ref MaterialTable is filled in, so recognizing the endgame costs
+ * nothing at the positions that share the material.
+ *
+ * Some endgames are evaluated by a specialized function in place of
+ * the general terms:
+ *
+ * - KXK, a lone king against at least a rook's worth of pieces, is
+ *   a known win, scored by the material and by driving the losing
+ *   king to the edge with the winning king close by.
+ * - KBNK is also a known win, but the losing king must be driven to
+ *   a corner of the same color as the bishop.
+ * - KRKP is scored by whether the rook side's king can reach the
+ *   pawn before it promotes.
+ * - KPK is scored exactly as won or drawn from the \ref Bitbase.
+ *
+ * Others keep the general terms but scale the endgame value towards
+ * a draw, either for good from the material alone, such as a side
+ * without pawns that is only a minor piece ahead, or by a scaling
+ * function that looks at the pieces, such as opposite-colored
+ * bishops.
+ */
+class Endgame
+{
+public:
+
+  /*!
+   * \brief Chooses the endgame functions and scale factors of an entry
+   *
+   * This function fills in the scale factors, the strong side and the
+   * specialized evaluation and scaling functions of a material table
+   * entry from its key.
+   *
+   * \param entry The material table entry
+   */
+  static void assign(MaterialTable::Entry * entry);
+
+private:
+
+  /*!
+   * \brief Evaluates a king, bishop and knight against a lone king
+   *
+   * \param pieces The piece bitboards, indexed by PieceType minus one
+   * \param strongSide The side with the bishop and knight
+   * \param sideToMove The side to move
+   *
+   * \return The score from the point of view of the strong side
+   */
+  static int32_t evaluateKBNK(const uint64_t * pieces, Color strongSide, Color sideToMove);
+
+  /*!
+   * \brief Evaluates a king and pawn against a lone king
+   *
+   * \param pieces The piece bitboards, indexed by PieceType minus one
+   * \param strongSide The side with the pawn
+   * \param sideToMove The side to move
+   *
+   * \return The score from the point of view of the strong side
+   */
+  static int32_t evaluateKPK(const uint64_t * pieces, Color strongSide, Color sideToMove);
+
+  /*!
+   * \brief Evaluates a king and rook against a king and pawn
+   *
+   * \param pieces The piece bitboards, indexed by PieceType minus one
+   * \param strongSide The side with the rook
+   * \param sideToMove The side to move
+   *
+   * \return The score from the point of view of the strong side
+   */
+  static int32_t evaluateKRKP(const uint64_t * pieces, Color strongSide, Color sideToMove);
+
+  /*!
+   * \brief Evaluates mating material against a lone king
+   *
+   * \param pieces The piece bitboards, indexed by PieceType minus one
+   * \param strongSide The side with the material
+   * \param sideToMove The side to move
+   *
+   * \return The score from the point of view of the strong side
+   */
+  static int32_t evaluateKXK(const uint64_t * pieces, Color strongSide, Color sideToMove);
+
+  /*!
+   * \brief Scales an ending with bishops on opposite colors
+   *
+   * \param pieces The piece bitboards, indexed by PieceType minus one
+   * \param strongSide Unused, the scale applies to both sides
+   *
+   * \return The scale factor
+   */
+  static int32_t scaleOppositeBishops(const uint64_t * pieces, Color strongSide);
+};
+
+}
+
+#endif // #ifndef JCL_ENDGAME_H
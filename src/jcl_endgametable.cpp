@@ -0,0 +1,355 @@
+/*!
+ * \file jcl_endgametable.cpp
+ *
+ * This file contains the implementation for the EndgameTable object
+ */
+
+#include "jcl_endgametable.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "jcl_bitboard.h"
+#include "jcl_materialtable.h"
+
+namespace jcl
+{
+
+// The header is padded to 32 bytes so the entries start aligned
+struct FileHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t materialKey;
+  uint64_t entryCount;
+  uint64_t reserved;
+};
+
+// Letters of the white piece types in signatures, indexed by PieceType minus one
+static const char PieceLetters[] = "PRNBQK";
+
+// Order of the piece types in signatures
+static const PieceType SignatureOrder[] =
+{
+  PieceType::WhiteKing, PieceType::WhiteQueen, PieceType::WhiteRook,
+  PieceType::WhiteBishop, PieceType::WhiteKnight, PieceType::WhitePawn
+};
+
+// Squares are numbered row * 8 + column here, so mirroring a file or
+// a rank is an exclusive or and a reflection swaps the row and column
+static const uint8_t MIRROR_FILE = 7;
+static const uint8_t MIRROR_RANK = 56;
+
+// Number of squares the white king is indexed by, with and without pawns
+static const uint64_t PAWN_KING_SQUARES = 32;
+static const uint64_t TRIANGLE_KING_SQUARES = 10;
+
+// Returns the index of a square in the a1-d1-d4 triangle, or -1 outside it
+static int32_t getTriangleIndex(uint8_t square)
+{
+  int32_t row = square >> 3;
+  int32_t col = square & 7;
+  if (row > col || col > 3)
+  {
+    return -1;
+  }
+  return row * 4 - row * (row - 1) / 2 + col - row;
+}
+
+// Returns the square of an index in the a1-d1-d4 triangle
+static uint8_t getTriangleSquare(uint64_t index)
+{
+  static const uint8_t squares[TRIANGLE_KING_SQUARES] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+  return squares[index];
+}
+
+// Reflects a square in the a1-h8 diagonal
+static uint8_t reflectSquare(uint8_t square)
+{
+  return static_cast<uint8_t>(((square & 7) << 3) | (square >> 3));
+}
+
+EndgameTable::EndgameTable()
+  : mEntries(nullptr)
+  , mEntryCount(0)
+  , mMaterialKey(0)
+  , mPawns(false)
+{
+
+}
+
+EndgameTable::~EndgameTable()
+{
+  unload();
+}
+
+bool EndgameTable::create(uint64_t materialKey)
+{
+  unload();
+  if (!setMaterial(materialKey))
+  {
+    return false;
+  }
+
+  mValues.assign(mEntryCount, DRAW);
+  mEntries = mValues.data();
+  return true;
+}
+
+uint64_t EndgameTable::flipMaterialKey(uint64_t materialKey)
+{
+  // The six white piece counts fill the low 24 bits and the black counts the next 24
+  return ((materialKey & 0xffffffULL) << 24) | ((materialKey >> 24) & 0xffffffULL);
+}
+
+int32_t EndgameTable::getDistance(uint8_t value)
+{
+  return isLoss(value) ? value - LOSS : value;
+}
+
+uint64_t EndgameTable::getIndex(const uint64_t * pieces, Color sideToMove) const
+{
+  uint64_t remaining[12];
+  std::memcpy(remaining, pieces, sizeof(remaining));
+
+  // Pieces of the same type are taken in bit order
+  uint8_t squares[MAX_PIECES];
+  uint32_t pieceCount = getPieceCount();
+  for (uint32_t i = 0; i < pieceCount; i++)
+  {
+    uint64_t & bb = remaining[static_cast<int>(mPieceTypes[i]) - 1];
+    squares[i] = bitScanForward(bb) ^ 7;
+    bb &= bb - 1;
+  }
+
+  // The symmetry brings the white king to its indexed squares
+  uint8_t mirror = ((squares[0] & 7) > 3) ? MIRROR_FILE : 0;
+  if (!mPawns && ((squares[0] ^ mirror) >> 3) > 3)
+  {
+    mirror ^= MIRROR_RANK;
+  }
+
+  for (uint32_t i = 0; i < pieceCount; i++)
+  {
+    squares[i] ^= mirror;
+  }
+
+  uint64_t index = static_cast<uint64_t>(sideToMove);
+  if (mPawns)
+  {
+    index = index * PAWN_KING_SQUARES + (squares[0] >> 3) * 4 + (squares[0] & 7);
+  }
+  else
+  {
+    if ((squares[0] >> 3) > (squares[0] & 7))
+    {
+      for (uint32_t i = 0; i < pieceCount; i++)
+      {
+        squares[i] = reflectSquare(squares[i]);
+      }
+    }
+    index = index * TRIANGLE_KING_SQUARES + static_cast<uint64_t>(getTriangleIndex(squares[0]));
+  }
+
+  index = index * 64 + squares[1];
+  for (uint32_t i = 2; i < pieceCount; i++)
+  {
+    PieceType pieceType = mPieceTypes[i];
+    if (pieceType == PieceType::WhitePawn || pieceType == PieceType::BlackPawn)
+    {
+      index = index * 48 + squares[i] - 8;
+    }
+    else
+    {
+      index = index * 64 + squares[i];
+    }
+  }
+
+  return index;
+}
+
+uint64_t EndgameTable::getMaterialKey(const std::string & signature)
+{
+  uint64_t materialKey = 0;
+  int side = 0;
+  for (size_t i = 0; i < signature.size(); i++)
+  {
+    char letter = signature[i];
+    if (letter == 'v')
+    {
+      if (side == 1)
+      {
+        return 0;
+      }
+      side = 1;
+      continue;
+    }
+
+    const char * position = std::strchr(PieceLetters, letter);
+    if (letter == '\0' || position == nullptr)
+    {
+      return 0;
+    }
+    materialKey += MaterialTable::getPieceKey(static_cast<PieceType>(side * 6 + (position - PieceLetters) + 1));
+  }
+
+  // Each side needs its king
+  if (side == 0 ||
+      MaterialTable::getPieceCount(materialKey, PieceType::WhiteKing) != 1 ||
+      MaterialTable::getPieceCount(materialKey, PieceType::BlackKing) != 1)
+  {
+    return 0;
+  }
+  return materialKey;
+}
+
+std::string EndgameTable::getSignature(uint64_t materialKey)
+{
+  std::string signature;
+  for (int side = 0; side < 2; side++)
+  {
+    if (side == 1)
+    {
+      signature += 'v';
+    }
+
+    for (PieceType pieceType : SignatureOrder)
+    {
+      PieceType sidePieceType = static_cast<PieceType>(static_cast<int>(pieceType) + side * 6);
+      uint32_t count = MaterialTable::getPieceCount(materialKey, sidePieceType);
+      signature.append(count, PieceLetters[static_cast<int>(pieceType) - 1]);
+    }
+  }
+
+  return signature;
+}
+
+void EndgameTable::getSquares(uint64_t index, uint8_t * squares, Color & sideToMove) const
+{
+  uint32_t pieceCount = getPieceCount();
+  for (uint32_t i = pieceCount - 1; i >= 2; i--)
+  {
+    PieceType pieceType = mPieceTypes[i];
+    if (pieceType == PieceType::WhitePawn || pieceType == PieceType::BlackPawn)
+    {
+      squares[i] = static_cast<uint8_t>(index % 48 + 8);
+      index /= 48;
+    }
+    else
+    {
+      squares[i] = static_cast<uint8_t>(index % 64);
+      index /= 64;
+    }
+  }
+
+  squares[1] = static_cast<uint8_t>(index % 64);
+  index /= 64;
+
+  if (mPawns)
+  {
+    uint64_t kingIndex = index % PAWN_KING_SQUARES;
+    squares[0] = static_cast<uint8_t>((kingIndex / 4) * 8 + kingIndex % 4);
+    index /= PAWN_KING_SQUARES;
+  }
+  else
+  {
+    squares[0] = getTriangleSquare(index % TRIANGLE_KING_SQUARES);
+    index /= TRIANGLE_KING_SQUARES;
+  }
+
+  sideToMove = static_cast<Color>(index);
+}
+
+bool EndgameTable::load(const std::string & fileName)
+{
+  unload();
+
+  if (!mFile.open(fileName) || mFile.getSize() < sizeof(FileHeader))
+  {
+    mFile.close();
+    return false;
+  }
+
+  FileHeader header;
+  std::memcpy(&header, mFile.getData(), sizeof(header));
+  if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || !setMaterial(header.materialKey) ||
+      header.entryCount != mEntryCount || mFile.getSize() != sizeof(header) + mEntryCount)
+  {
+    unload();
+    return false;
+  }
+
+  mEntries = mFile.getData() + sizeof(header);
+  return true;
+}
+
+bool EndgameTable::save(const std::string & fileName) const
+{
+  if (mEntries == nullptr)
+  {
+    return false;
+  }
+
+  std::ofstream outputStream(fileName, std::ios::binary);
+  if (!outputStream)
+  {
+    return false;
+  }
+
+  FileHeader header = { FILE_MAGIC, FILE_VERSION, mMaterialKey, mEntryCount, 0 };
+  outputStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  outputStream.write(reinterpret_cast<const char *>(mEntries), static_cast<std::streamsize>(mEntryCount));
+  return static_cast<bool>(outputStream);
+}
+
+bool EndgameTable::setMaterial(uint64_t materialKey)
+{
+  if (MaterialTable::getPieceCount(materialKey, PieceType::WhiteKing) != 1 ||
+      MaterialTable::getPieceCount(materialKey, PieceType::BlackKing) != 1)
+  {
+    return false;
+  }
+
+  mPieceTypes.clear();
+  mPieceTypes.push_back(PieceType::WhiteKing);
+  mPieceTypes.push_back(PieceType::BlackKing);
+  for (int i = 1; i <= 11; i++)
+  {
+    PieceType pieceType = static_cast<PieceType>(i);
+    if (pieceType != PieceType::WhiteKing)
+    {
+      mPieceTypes.insert(mPieceTypes.end(), MaterialTable::getPieceCount(materialKey, pieceType), pieceType);
+    }
+  }
+
+  if (mPieceTypes.size() > MAX_PIECES)
+  {
+    mPieceTypes.clear();
+    return false;
+  }
+
+  mPawns = (MaterialTable::getPieceCount(materialKey, PieceType::WhitePawn) != 0 ||
+            MaterialTable::getPieceCount(materialKey, PieceType::BlackPawn) != 0);
+  mEntryCount = 2 * (mPawns ? PAWN_KING_SQUARES : TRIANGLE_KING_SQUARES) * 64;
+  for (size_t i = 2; i < mPieceTypes.size(); i++)
+  {
+    bool pawn = (mPieceTypes[i] == PieceType::WhitePawn || mPieceTypes[i] == PieceType::BlackPawn);
+    mEntryCount *= pawn ? 48 : 64;
+  }
+
+  mMaterialKey = materialKey;
+  return true;
+}
+
+void EndgameTable::unload()
+{
+  mFile.close();
+  std::vector<uint8_t>().swap(mValues);
+  mEntries = nullptr;
+  mEntryCount = 0;
+  mMaterialKey = 0;
+  mPieceTypes.clear();
+  mPawns = false;
+}
+
+}
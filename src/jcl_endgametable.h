@@ -0,0 +1,339 @@
+/*!
+ * \file jcl_endgametable.h
+ *
+ * This file contains the interface for the EndgameTable object
+ */
+
+#ifndef JCL_ENDGAMETABLE_H
+#define JCL_ENDGAMETABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "jcl_mappedfile.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines the table of one material signature of a tablebase
+ *
+ * The EndgameTable object holds the result with perfect play of
+ * every position of one material signature, such as "KQvK" for a
+ * white king and queen against a black king. Each position has one
+ * byte, the distance to mate from the point of view of the side to
+ * move:
+ *
+ * - DRAW for a draw, or for a placement that is not a legal position.
+ * - 1 to 127 when the side to move mates in that many moves.
+ * - LOSS plus 0 to MAX_DISTANCE when the side to move is mated in
+ *   that many moves, LOSS itself being checkmate. Longer losses are
+ *   stored as the longest, so they remain losses.
+ *
+ * A position is indexed by the side to move and the squares of its
+ * pieces: the white king, the black king, then the other white and
+ * black pieces in PieceType order. Positions are mirrored so the
+ * white king stands on files a to d. Without pawns they are also
+ * mirrored and reflected so it stands in the a1-d1-d4 triangle,
+ * which leaves 10 king squares instead of 64. Pawns only stand on
+ * ranks 2 to 7, which leaves 48 squares instead of 64. Castling and
+ * en passant are not part of a position.
+ *
+ * A table is either created empty for the generator to fill (see
+ * \ref TablebaseGenerator) or loaded from a file that is mapped into
+ * memory, so loading is immediate and the pages are shared by every
+ * process using the same file. The file holds a header of the
+ * FILE_MAGIC and FILE_VERSION values, the material key of the table
+ * (see \ref MaterialTable) and the number of entries, followed by
+ * the entries in index order.
+ */
+class EndgameTable
+{
+public:
+  static constexpr uint32_t FILE_MAGIC = 0x424C434A;   /*!< The file header magic, "JCLB" */
+  static constexpr uint32_t FILE_VERSION = 1;          /*!< The file format version */
+  static constexpr uint32_t MAX_PIECES = 5;            /*!< The most pieces in a table, kings included */
+  static constexpr uint8_t DRAW = 0;                   /*!< The value of a drawn position */
+  static constexpr uint8_t LOSS = 128;                 /*!< The value of a checkmated position */
+  static constexpr uint8_t MAX_DISTANCE = 126;         /*!< The longest loss stored exactly, in moves */
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs an EndgameTable object without entries.
+   */
+  EndgameTable();
+
+  /*!
+   * \brief Destructor
+   *
+   * This function unmaps the table file, if one is loaded.
+   */
+  ~EndgameTable();
+
+  EndgameTable(const EndgameTable &) = delete;
+  EndgameTable & operator=(const EndgameTable &) = delete;
+
+  /*!
+   * \brief Creates an empty table
+   *
+   * This function unloads the table and allocates an entry for each
+   * position of the material signature, every entry being DRAW.
+   *
+   * \param materialKey The material key of the signature
+   *
+   * \return true if the signature has two kings and at most MAX_PIECES pieces, false otherwise
+   */
+  bool create(uint64_t materialKey);
+
+  /*!
+   * \brief Returns the material key with the colors exchanged
+   *
+   * \param materialKey The material key
+   *
+   * \return The material key of the same pieces with the other colors
+   */
+  static uint64_t flipMaterialKey(uint64_t materialKey);
+
+  /*!
+   * \brief Returns the distance to mate of a value
+   *
+   * \param value The value of an entry
+   *
+   * \return The number of moves to mate, zero for a draw or checkmate
+   */
+  static int32_t getDistance(uint8_t value);
+
+  /*!
+   * \brief Returns the number of entries
+   *
+   * \return The number of entries
+   */
+  uint64_t getEntryCount() const;
+
+  /*!
+   * \brief Returns the name of the loaded table file
+   *
+   * \return The file name, or an empty string if the table was not loaded from a file
+   */
+  const std::string & getFileName() const;
+
+  /*!
+   * \brief Returns the index of a position
+   *
+   * The pieces must match the material of the table, with the same
+   * colors.
+   *
+   * \param pieces The twelve piece bitboards, indexed by PieceType minus one
+   * \param sideToMove The side to move
+   *
+   * \return The index of the position
+   */
+  uint64_t getIndex(const uint64_t * pieces, Color sideToMove) const;
+
+  /*!
+   * \brief Returns the material key of a signature
+   *
+   * \param signature The signature, such as "KRPvKR", white pieces first
+   *
+   * \return The material key, or zero if the signature cannot be read
+   */
+  static uint64_t getMaterialKey(const std::string & signature);
+
+  /*!
+   * \brief Returns the material key of the table
+   *
+   * \return The material key
+   */
+  uint64_t getMaterialKey() const;
+
+  /*!
+   * \brief Returns the number of pieces of the table
+   *
+   * \return The number of pieces, kings included
+   */
+  uint32_t getPieceCount() const;
+
+  /*!
+   * \brief Returns the type of each piece in index order
+   *
+   * \return The piece types, starting with the white and black kings
+   */
+  const std::vector<PieceType> & getPieceTypes() const;
+
+  /*!
+   * \brief Returns the signature of a material key
+   *
+   * \param materialKey The material key
+   *
+   * \return The signature, such as "KRPvKR", white pieces first
+   */
+  static std::string getSignature(uint64_t materialKey);
+
+  /*!
+   * \brief Returns the squares of a position
+   *
+   * This function is the inverse of \ref getIndex. The squares are
+   * numbered row * 8 + column, in the order of \ref getPieceTypes.
+   * Some indexes place two pieces on the same square, which the
+   * caller is expected to skip.
+   *
+   * \param index The index of the position
+   * \param squares Holds the square of each piece
+   * \param sideToMove Holds the side to move
+   */
+  void getSquares(uint64_t index, uint8_t * squares, Color & sideToMove) const;
+
+  /*!
+   * \brief Returns the value of an entry
+   *
+   * \param index The index of the entry
+   *
+   * \return The value of the entry
+   */
+  uint8_t getValue(uint64_t index) const;
+
+  /*!
+   * \brief Returns whether the table has pawns
+   *
+   * A table without pawns keeps both reflections in the a1-h8
+   * diagonal of a position whose white king stands on the diagonal,
+   * each at its own index.
+   *
+   * \return true if either side has a pawn, false otherwise
+   */
+  bool hasPawns() const;
+
+  /*!
+   * \brief Returns whether a value is a loss for the side to move
+   *
+   * \param value The value of an entry
+   *
+   * \return true if the side to move is mated, false otherwise
+   */
+  static bool isLoss(uint8_t value);
+
+  /*!
+   * \brief Returns whether a value is a win for the side to move
+   *
+   * \param value The value of an entry
+   *
+   * \return true if the side to move mates, false otherwise
+   */
+  static bool isWin(uint8_t value);
+
+  /*!
+   * \brief Loads the table from a file
+   *
+   * This function maps the table file into memory. Any table already
+   * loaded or created is unloaded first, so the table is empty if
+   * the file cannot be mapped or does not have the expected header
+   * and size.
+   *
+   * \param fileName The name of the table file
+   *
+   * \return true if the table was loaded, false otherwise
+   */
+  bool load(const std::string & fileName);
+
+  /*!
+   * \brief Saves the table to a file
+   *
+   * \param fileName The name of the table file
+   *
+   * \return true if the table was saved, false otherwise
+   */
+  bool save(const std::string & fileName) const;
+
+  /*!
+   * \brief Sets the value of an entry of a created table
+   *
+   * \param index The index of the entry
+   * \param value The value of the entry
+   */
+  void setValue(uint64_t index, uint8_t value);
+
+  /*!
+   * \brief Unloads the table
+   */
+  void unload();
+
+private:
+
+  /*!
+   * \brief Sets up the piece types and entry count of a material key
+   *
+   * \param materialKey The material key
+   *
+   * \return true if the material can be tabled, false otherwise
+   */
+  bool setMaterial(uint64_t materialKey);
+
+  // Members
+  MappedFile mFile;                     // Mapped table file
+  std::vector<uint8_t> mValues;         // Entries of a created table
+  const uint8_t * mEntries;             // Entries, either created or mapped
+  uint64_t mEntryCount;                 // Number of entries
+  uint64_t mMaterialKey;                // Material key of the table
+  std::vector<PieceType> mPieceTypes;   // Piece types in index order
+  bool mPawns;                          // Whether the table has pawns, which limits the symmetry
+};
+
+inline uint64_t EndgameTable::getEntryCount() const
+{
+  return mEntryCount;
+}
+
+inline const std::string & EndgameTable::getFileName() const
+{
+  return mFile.getFileName();
+}
+
+inline uint64_t EndgameTable::getMaterialKey() const
+{
+  return mMaterialKey;
+}
+
+inline uint32_t EndgameTable::getPieceCount() const
+{
+  return static_cast<uint32_t>(mPieceTypes.size());
+}
+
+inline const std::vector<PieceType> & EndgameTable::getPieceTypes() const
+{
+  return mPieceTypes;
+}
+
+inline uint8_t EndgameTable::getValue(uint64_t index) const
+{
+  return mEntries[index];
+}
+
+inline bool EndgameTable::hasPawns() const
+{
+  return mPawns;
+}
+
+inline bool EndgameTable::isLoss(uint8_t value)
+{
+  return value >= LOSS;
+}
+
+inline bool EndgameTable::isWin(uint8_t value)
+{
+  return value != DRAW && value < LOSS;
+}
+
+inline void EndgameTable::setValue(uint64_t index, uint8_t value)
+{
+  mValues[index] = value;
+}
+
+}
+
+#endif // #ifndef JCL_ENDGAMETABLE_H
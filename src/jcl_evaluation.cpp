@@ -6,164 +6,582 @@
 
 #include "jcl_evaluation.h"
 
-#define getIndex(row,col) (((row)<<3)+(col))
-#define getRow(index) ( (index >> 3) )
-#define getCol(index) ( (index % 8) )
+#include <algorithm>
+
+#include "jcl_batchevaluation.h"
+#include "jcl_bitboard.h"
+#include "jcl_endgame.h"
+#include "jcl_network.h"
+#include "jcl_piecesquare.h"
+#include "jcl_zobrist.h"
 
 namespace jcl
 {
 
-constexpr int PAWN_WEIGHT = 100;
-constexpr int KNIGHT_WEIGHT = 300;
-constexpr int BISHOP_WEIGHT = 350;
-constexpr int ROOK_WEIGHT = 500;
-constexpr int QUEEN_WEIGHT = 950;
-constexpr int KING_WEIGHT = 60000;
+// Bitboards use bit zero for h1 and bit 63 for a8, as in BitBoard
+static const uint64_t FILE_A = 0x8080808080808080ULL;
+static const uint64_t FILE_H = 0x0101010101010101ULL;
+static const uint64_t RANK_1 = 0x00000000000000ffULL;
+
+// Penalties for weak pawns
+static const Score DoubledPawn = makeScore(-10, -20);
+static const Score IsolatedPawn = makeScore(-10, -15);
+static const Score BackwardPawn = makeScore(-8, -10);
 
-static const double PawnSquareValue[64] =
+// Passed pawn bonus by rank, counted from the side of the pawn
+static const Score PassedPawn[8] =
 {
-  90, 92, 94, 96, 96, 94, 92, 90,
-  80, 82, 84, 86, 86, 84, 82, 80,
-  60, 62, 64, 66, 66, 64, 62, 60,
-  60, 62, 64, 66, 66, 64, 62, 60,
-  30, 32, 34, 36, 36, 34, 32, 30,
-  10, 12, 14, 16, 16, 14, 12, 10,
-  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0
+  makeScore(0, 0), makeScore(5, 10), makeScore(10, 20), makeScore(20, 35),
+  makeScore(35, 60), makeScore(60, 100), makeScore(100, 150), makeScore(0, 0)
 };
 
-static const double BishopSquareValue[64] =
+// Material imbalance: the bishop pair, knights gaining and rooks losing
+// value with each pawn of their own side above five, and redundant rooks
+static const Score BishopPair = makeScore(30, 50);
+static const Score KnightPawnAdjustment = makeScore(6, 6);
+static const Score RookPawnAdjustment = makeScore(-12, -12);
+static const Score RookPair = makeScore(-10, -15);
+
+// King shelter bonus for each pawn one and two ranks in front of the king
+static const Score ShelterPawn[2] = { makeScore(12, 0), makeScore(6, 0) };
+
+// Knight mobility bonus by number of safe squares attacked
+static const Score KnightMobility[9] =
 {
-  0,  0,  0,  0,  0,  0,  0,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 50, 50, 30, 30,  0,
-  0, 30, 30, 50, 50, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0,  0,  0,  0,  0,  0,  0,  0
+  makeScore(-30, -40), makeScore(-20, -25), makeScore(-5, -10), makeScore(0, 0),
+  makeScore(5, 5), makeScore(10, 10), makeScore(15, 15), makeScore(20, 18),
+  makeScore(25, 20)
 };
 
-static const double RookSquareValue[64] =
+// Bishop mobility bonus by number of safe squares attacked
+static const Score BishopMobility[14] =
 {
-  0,  0,  0,  0,  0,  0,  0,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 50, 50, 30, 30,  0,
-  0, 30, 30, 50, 50, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0,  0,  0,  0,  0,  0,  0,  0
+  makeScore(-25, -35), makeScore(-10, -15), makeScore(0, -5), makeScore(5, 5),
+  makeScore(10, 10), makeScore(15, 15), makeScore(20, 20), makeScore(23, 25),
+  makeScore(26, 28), makeScore(28, 30), makeScore(30, 32), makeScore(32, 34),
+  makeScore(34, 35), makeScore(35, 36)
 };
 
-static const double KnightSquareValue[64] =
+// Rook mobility bonus by number of safe squares attacked
+static const Score RookMobility[15] =
 {
-  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  5, 10, 20, 20, 10,  5,  0,
-  0, 10, 20, 30, 30, 20, 10,  0,
-  0, 10, 20, 50, 50, 20, 10,  0,
-  0, 10, 20, 50, 50, 20, 10,  0,
-  0, 10, 20, 30, 30, 20, 10,  0,
-  0,  5, 10, 20, 20, 10,  5,  0,
-  0,  0,  0,  0,  0,  0,  0,  0
+  makeScore(-20, -40), makeScore(-12, -20), makeScore(-6, -10), makeScore(-2, 0),
+  makeScore(0, 8), makeScore(2, 14), makeScore(4, 20), makeScore(6, 25),
+  makeScore(8, 30), makeScore(10, 34), makeScore(11, 37), makeScore(12, 40),
+  makeScore(13, 42), makeScore(14, 44), makeScore(15, 45)
 };
 
-static const double QueenSquareValue[64] =
+// Queen mobility bonus by number of safe squares attacked
+static const Score QueenMobility[28] =
 {
-  0,  0,  0,  0,  0,  0,  0,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 50, 50, 30, 30,  0,
-  0, 30, 30, 50, 50, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0, 30, 30, 40, 40, 30, 30,  0,
-  0,  0,  0,  0,  0,  0,  0,  0
+  makeScore(-15, -25), makeScore(-10, -18), makeScore(-6, -12), makeScore(-4, -8),
+  makeScore(-2, -4), makeScore(0, 0), makeScore(1, 3), makeScore(2, 6),
+  makeScore(3, 9), makeScore(4, 12), makeScore(5, 14), makeScore(6, 16),
+  makeScore(7, 18), makeScore(8, 20), makeScore(9, 22), makeScore(10, 24),
+  makeScore(10, 25), makeScore(11, 26), makeScore(11, 27), makeScore(12, 28),
+  makeScore(12, 29), makeScore(13, 30), makeScore(13, 30), makeScore(14, 31),
+  makeScore(14, 31), makeScore(15, 32), makeScore(15, 32), makeScore(15, 32)
 };
 
-static const double KingSquareValue[64] =
+// Attack units for each square of the king zone attacked by a piece
+static const int32_t KnightAttackWeight = 2;
+static const int32_t BishopAttackWeight = 2;
+static const int32_t RookAttackWeight = 3;
+static const int32_t QueenAttackWeight = 5;
+
+// King danger by attack units on the king zone, growing faster than
+// linearly so that several attackers together weigh more than apart
+static const Score KingDanger[100] =
 {
-  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  5, 10, 20, 20, 10,  5,  0,
-  0, 10, 20, 30, 30, 20, 10,  0,
-  0, 10, 20, 50, 50, 20, 10,  0,
-  0, 10, 20, 50, 50, 20, 10,  0,
-  0, 10, 20, 30, 30, 20, 10,  0,
-  0,  5, 10, 20, 20, 10,  5,  0,
-  0,  0,  0,  0,  0,  0,  0,  0
+  makeScore(0, 0), makeScore(0, 0), makeScore(1, 0), makeScore(2, 0), makeScore(3, 0),
+  makeScore(5, 1), makeScore(7, 1), makeScore(9, 2), makeScore(12, 3), makeScore(15, 3),
+  makeScore(18, 4), makeScore(22, 5), makeScore(26, 6), makeScore(30, 7), makeScore(35, 8),
+  makeScore(39, 9), makeScore(44, 11), makeScore(50, 12), makeScore(56, 14), makeScore(62, 15),
+  makeScore(68, 17), makeScore(75, 18), makeScore(82, 20), makeScore(85, 21), makeScore(89, 22),
+  makeScore(97, 24), makeScore(105, 26), makeScore(113, 28), makeScore(122, 30), makeScore(131, 32),
+  makeScore(140, 35), makeScore(150, 37), makeScore(169, 42), makeScore(180, 45), makeScore(191, 47),
+  makeScore(202, 50), makeScore(213, 53), makeScore(225, 56), makeScore(237, 59), makeScore(248, 62),
+  makeScore(260, 65), makeScore(272, 68), makeScore(283, 70), makeScore(295, 73), makeScore(307, 76),
+  makeScore(319, 79), makeScore(330, 82), makeScore(342, 85), makeScore(354, 88), makeScore(366, 91),
+  makeScore(377, 94), makeScore(389, 97), makeScore(401, 100), makeScore(412, 103), makeScore(424, 106),
+  makeScore(436, 109), makeScore(448, 112), makeScore(459, 114), makeScore(471, 117), makeScore(483, 120),
+  makeScore(494, 123), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125),
+  makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125), makeScore(500, 125)
 };
 
+// Default lazy evaluation margins, bounding the terms that follow each stage
+static const int32_t MaterialMargin = 400;
+static const int32_t PawnStructureMargin = 300;
+
+// Blends the midgame and endgame values of a score by the game phase
+static int32_t blendScore(Score score, int32_t phase)
+{
+  phase = std::min(phase, PieceSquare::MAX_PHASE);
+  return (getMidgameValue(score) * phase + getEndgameValue(score) * (PieceSquare::MAX_PHASE - phase)) / PieceSquare::MAX_PHASE;
+}
+
+// Adds the attacks of a piece on the king zone to the attack counts
+static void countKingAttacks(uint64_t attacks, uint64_t kingZone, int32_t weight, int32_t & attackerCount, int32_t & attackUnits)
+{
+  uint64_t zoneAttacks = attacks & kingZone;
+  if (zoneAttacks != 0)
+  {
+    attackerCount++;
+    attackUnits += weight * static_cast<int32_t>(popCount(zoneAttacks));
+  }
+}
+
+// Returns the squares on the adjacent files of the supplied squares
+static uint64_t getAdjacentFiles(uint64_t bb)
+{
+  return ((bb & ~FILE_A) << 1) | ((bb & ~FILE_H) >> 1);
+}
+
+// Returns the supplied squares and all squares above them
+static uint64_t northFill(uint64_t bb)
+{
+  bb |= bb << 8;
+  bb |= bb << 16;
+  bb |= bb << 32;
+  return bb;
+}
+
+// Returns the supplied squares and all squares below them
+static uint64_t southFill(uint64_t bb)
+{
+  bb |= bb >> 8;
+  bb |= bb >> 16;
+  bb |= bb >> 32;
+  return bb;
+}
+
+// Returns whether a partial score is further outside a window than a margin
+static bool isOutsideWindow(int32_t score, int32_t alpha, int32_t beta, int32_t margin)
+{
+  return (static_cast<int64_t>(score) + margin < alpha || static_cast<int64_t>(score) - margin > beta);
+}
+
 Evaluation::Evaluation()
+  : mLazyEvaluations(0)
+{
+  mLazyMargins[static_cast<uint32_t>(Stage::Material)] = MaterialMargin;
+  mLazyMargins[static_cast<uint32_t>(Stage::PawnStructure)] = PawnStructureMargin;
+  mLazyMargins[static_cast<uint32_t>(Stage::Pieces)] = 0;
+  clearStatistics();
+}
+
+Evaluation::~Evaluation()
+{
+
+}
+
+void Evaluation::clearStatistics()
+{
+  for (uint32_t i = 0; i < STAGE_COUNT; i++)
+  {
+    mLazyCutoffs[i] = 0;
+  }
+  mLazyEvaluations = 0;
+}
+
+int32_t Evaluation::evaluateBoard(const Board * board)
+{
+  bool complete = true;
+  return evaluateStages(board, 0, 0, false, complete);
+}
+
+int32_t Evaluation::evaluateBoard(const Board * board, int32_t alpha, int32_t beta, bool & complete)
+{
+  mLazyEvaluations++;
+  return evaluateStages(board, alpha, beta, true, complete);
+}
+
+void Evaluation::evaluateMaterial(MaterialTable::Entry * entry)
+{
+  entry->phase = 0;
+  entry->imbalance = 0;
+  for (int side = 0; side < 2; side++)
+  {
+    int32_t counts[6];
+    for (int32_t i = 0; i < 6; i++)
+    {
+      PieceType pieceType = static_cast<PieceType>(side * 6 + i + 1);
+      counts[i] = static_cast<int32_t>(MaterialTable::getPieceCount(entry->key, pieceType));
+      entry->phase += counts[i] * PieceSquare::getPhase(pieceType);
+    }
+
+    Score imbalance = 0;
+    if (counts[BISHOPS] >= 2)
+    {
+      imbalance += BishopPair;
+    }
+    if (counts[ROOKS] >= 2)
+    {
+      imbalance += RookPair;
+    }
+    imbalance += counts[KNIGHTS] * (counts[PAWNS] - 5) * KnightPawnAdjustment;
+    imbalance += counts[ROOKS] * (counts[PAWNS] - 5) * RookPawnAdjustment;
+    entry->imbalance += (side == 0) ? imbalance : -imbalance;
+  }
+
+  Endgame::assign(entry);
+}
+
+Score Evaluation::evaluatePieces(const BitBoard * tables, const uint64_t * pieces, Color color)
+{
+  const uint64_t * own = getSideBitboards(pieces, color);
+  const uint64_t * enemy = getSideBitboards(pieces, !color);
+  uint64_t ownPieces = own[PAWNS] | own[ROOKS] | own[KNIGHTS] | own[BISHOPS] | own[QUEENS] | own[KINGS];
+  uint64_t enemyPieces = enemy[PAWNS] | enemy[ROOKS] | enemy[KNIGHTS] | enemy[BISHOPS] | enemy[QUEENS] | enemy[KINGS];
+
+  // Squares holding our own pieces or attacked by enemy pawns are not counted
+  uint64_t safe = ~(ownPieces | BitBoard::getPawnAttacks(enemy[PAWNS], !color));
+  uint64_t occupied = ownPieces | enemyPieces;
+
+  // The enemy king zone is the king square and the squares around it
+  uint64_t kingZone = 0;
+  if (enemy[KINGS] != 0)
+  {
+    kingZone = enemy[KINGS] | tables->getKingAttacks(bitScanForward(enemy[KINGS]));
+  }
+
+  // The attacks of each piece are generated once for both mobility and king safety
+  Score score = 0;
+  int32_t attackerCount = 0;
+  int32_t attackUnits = 0;
+  for (uint64_t knights = own[KNIGHTS]; knights != 0; knights &= knights - 1)
+  {
+    uint64_t attacks = tables->getKnightAttacks(bitScanForward(knights));
+    score += KnightMobility[popCount(attacks & safe)];
+    countKingAttacks(attacks, kingZone, KnightAttackWeight, attackerCount, attackUnits);
+  }
+
+  for (uint64_t bishops = own[BISHOPS]; bishops != 0; bishops &= bishops - 1)
+  {
+    uint64_t attacks = tables->getBishopAttacks(bitScanForward(bishops), occupied);
+    score += BishopMobility[popCount(attacks & safe)];
+    countKingAttacks(attacks, kingZone, BishopAttackWeight, attackerCount, attackUnits);
+  }
+
+  for (uint64_t rooks = own[ROOKS]; rooks != 0; rooks &= rooks - 1)
+  {
+    uint64_t attacks = tables->getRookAttacks(bitScanForward(rooks), occupied);
+    score += RookMobility[popCount(attacks & safe)];
+    countKingAttacks(attacks, kingZone, RookAttackWeight, attackerCount, attackUnits);
+  }
+
+  for (uint64_t queens = own[QUEENS]; queens != 0; queens &= queens - 1)
+  {
+    uint8_t square = bitScanForward(queens);
+    uint64_t attacks = tables->getBishopAttacks(square, occupied) | tables->getRookAttacks(square, occupied);
+    score += QueenMobility[popCount(attacks & safe)];
+    countKingAttacks(attacks, kingZone, QueenAttackWeight, attackerCount, attackUnits);
+  }
+
+  // A single attacker is rarely dangerous on its own
+  if (attackerCount >= 2)
+  {
+    score += KingDanger[std::min(attackUnits, 99)];
+  }
+
+  return score;
+}
+
+Score Evaluation::evaluatePawns(const Board * board)
+{
+  bool found = false;
+  PawnTable::Entry * entry = mPawnTable.probe(board->getPawnHashKey(), found);
+  if (!found)
+  {
+    // Boards without bitboards are scanned, which only happens when the pawns have changed
+    uint64_t scanned[12];
+    const uint64_t * pieces = board->getPieceBitboards(scanned);
+    entry->pawns[static_cast<int>(Color::White)] = pieces[static_cast<int>(PieceType::WhitePawn) - 1];
+    entry->pawns[static_cast<int>(Color::Black)] = pieces[static_cast<int>(PieceType::BlackPawn) - 1];
+    entry->key = board->getPawnHashKey();
+    evaluatePawnStructure(entry);
+  }
+
+  // The shelter depends on the king square, so it is not cached
+  Score score = entry->score;
+  score += evaluateShelter(entry->pawns[0], Color::White, board->getKingRow(Color::White), board->getKingColumn(Color::White));
+  score += evaluateShelter(entry->pawns[1], Color::Black, board->getKingRow(Color::Black), board->getKingColumn(Color::Black));
+  return score;
+}
+
+void Evaluation::evaluatePawnStructure(PawnTable::Entry * entry)
 {
+  uint64_t whitePawns = entry->pawns[static_cast<int>(Color::White)];
+  uint64_t blackPawns = entry->pawns[static_cast<int>(Color::Black)];
+  uint64_t whiteAttacks = BitBoard::getPawnAttacks(whitePawns, Color::White);
+  uint64_t blackAttacks = BitBoard::getPawnAttacks(blackPawns, Color::Black);
 
+  // Squares in front of the pawns of each side, on their own and the adjacent files
+  uint64_t whiteFront = northFill(whitePawns << 8);
+  uint64_t blackFront = southFill(blackPawns >> 8);
+  uint64_t whiteSpan = whiteFront | getAdjacentFiles(whiteFront);
+  uint64_t blackSpan = blackFront | getAdjacentFiles(blackFront);
+
+  // A pawn is passed when no enemy pawn can block or capture it on its way
+  uint64_t whitePassed = whitePawns & ~blackSpan;
+  uint64_t blackPassed = blackPawns & ~whiteSpan;
+
+  // A doubled pawn has a pawn of its own side in front of it
+  uint64_t whiteDoubled = whitePawns & southFill(whitePawns >> 8);
+  uint64_t blackDoubled = blackPawns & northFill(blackPawns << 8);
+
+  // An isolated pawn has no pawns of its own side on the adjacent files
+  uint64_t whiteIsolated = whitePawns & ~getAdjacentFiles(northFill(whitePawns) | southFill(whitePawns));
+  uint64_t blackIsolated = blackPawns & ~getAdjacentFiles(northFill(blackPawns) | southFill(blackPawns));
+
+  // A backward pawn cannot advance safely and no pawn of its own side can come to defend it
+  uint64_t whiteBackward = ((whitePawns << 8) & blackAttacks & ~northFill(whiteAttacks)) >> 8;
+  uint64_t blackBackward = ((blackPawns >> 8) & whiteAttacks & ~southFill(blackAttacks)) << 8;
+
+  Score score = 0;
+  score += (static_cast<int32_t>(popCount(whiteDoubled)) - static_cast<int32_t>(popCount(blackDoubled))) * DoubledPawn;
+  score += (static_cast<int32_t>(popCount(whiteIsolated)) - static_cast<int32_t>(popCount(blackIsolated))) * IsolatedPawn;
+  score += (static_cast<int32_t>(popCount(whiteBackward)) - static_cast<int32_t>(popCount(blackBackward))) * BackwardPawn;
+
+  for (uint64_t passed = whitePassed; passed != 0; passed &= passed - 1)
+  {
+    score += PassedPawn[bitScanForward(passed) >> 3];
+  }
+
+  for (uint64_t passed = blackPassed; passed != 0; passed &= passed - 1)
+  {
+    score -= PassedPawn[7 - (bitScanForward(passed) >> 3)];
+  }
+
+  entry->passed[static_cast<int>(Color::White)] = whitePassed;
+  entry->passed[static_cast<int>(Color::Black)] = blackPassed;
+  entry->score = score;
 }
 
-double Evaluation::evaluateBoard(const Board * board)
+int32_t Evaluation::evaluatePosition(const PackedPosition & position, const Network * network)
 {
-  double score = 0.0;
-  for (uint8_t i = 0; i < 8; i++)
+  // Unpacking gathers the terms a board would maintain as moves are made
+  uint64_t pieces[12] = { 0 };
+  PieceType pieceTypes[32];
+  uint8_t squares[32];
+  uint32_t pieceCount = 0;
+  int32_t kingRow[2] = { 8, 8 };
+  int32_t kingColumn[2] = { 8, 8 };
+  Score score = 0;
+  uint64_t materialKey = 0;
+  uint64_t pawnHashKey = 0;
+  uint32_t index = 0;
+  for (uint64_t occupied = position.occupied; occupied != 0 && index < 32; occupied &= occupied - 1)
   {
-    for (uint8_t j = 0; j < 8; j++)
+    uint8_t bit = bitScanForward(occupied);
+    PieceType pieceType = position.getPieceType(index++);
+    if (pieceType == PieceType::None || pieceType > PieceType::BlackKing)
     {
-      uint8_t index = getIndex(i, j);
+      continue;
+    }
 
-      PieceType pieceType = board->getPieceType(i, j);
-      switch (pieceType)
+    uint8_t row = bit >> 3;
+    uint8_t col = 7 - (bit & 7);
+    pieces[static_cast<int>(pieceType) - 1] |= 1ULL << bit;
+    pieceTypes[pieceCount] = pieceType;
+    squares[pieceCount++] = (row << 3) + col;
+    score += PieceSquare::getValue(pieceType, row, col);
+    materialKey += MaterialTable::getPieceKey(pieceType);
+    if (pieceType == PieceType::WhitePawn || pieceType == PieceType::BlackPawn)
+    {
+      pawnHashKey ^= Zobrist::getPieceKey(pieceType, row, col);
+    }
+    else if (pieceType == PieceType::WhiteKing || pieceType == PieceType::BlackKing)
+    {
+      int side = (pieceType == PieceType::WhiteKing) ? 0 : 1;
+      kingRow[side] = row;
+      kingColumn[side] = col;
+    }
+  }
+
+  Color sideToMove = static_cast<Color>(position.sideToMove);
+  if (network != nullptr)
+  {
+    Network::Accumulator accumulator;
+    for (int side = 0; side < 2; side++)
+    {
+      Color perspective = static_cast<Color>(side);
+      uint8_t kingSquare = static_cast<uint8_t>(kingRow[side] * 8 + kingColumn[side]);
+      network->resetAccumulator(accumulator, perspective);
+      for (uint32_t i = 0; i < pieceCount; i++)
       {
-      case PieceType::WhitePawn:
-        score += PAWN_WEIGHT;
-        score += PawnSquareValue[index];
-        break;
-      case PieceType::WhiteRook:
-        score += ROOK_WEIGHT;
-        score += RookSquareValue[index];
-        break;
-      case PieceType::WhiteKnight:
-        score += KNIGHT_WEIGHT;
-        score += KnightSquareValue[index];
-        break;
-      case PieceType::WhiteBishop:
-        score += BISHOP_WEIGHT;
-        score += BishopSquareValue[index];
-        break;
-      case PieceType::WhiteQueen:
-        score += QUEEN_WEIGHT;
-        score += QueenSquareValue[index];
-        break;
-      case PieceType::WhiteKing:
-        score += KING_WEIGHT;
-        score += KingSquareValue[index];
-        break;
-      case PieceType::BlackPawn:
-        score -= PAWN_WEIGHT;
-        score -= PawnSquareValue[index];
-        break;
-      case PieceType::BlackRook:
-        score -= ROOK_WEIGHT;
-        score -= RookSquareValue[index];
-        break;
-      case PieceType::BlackKnight:
-        score -= KNIGHT_WEIGHT;
-        score -= KnightSquareValue[index];
-        break;
-      case PieceType::BlackBishop:
-        score -= BISHOP_WEIGHT;
-        score -= BishopSquareValue[index];
-        break;
-      case PieceType::BlackQueen:
-        score -= QUEEN_WEIGHT;
-        score -= QueenSquareValue[index];
-        break;
-      case PieceType::BlackKing:
-        score -= KING_WEIGHT;
-        score -= KingSquareValue[index];
-        break;
-      default:
-        break;
+        network->updateAccumulator(accumulator, perspective, kingSquare, pieceTypes[i], squares[i], 1);
       }
     }
+
+    int32_t networkScore = network->evaluate(accumulator, sideToMove);
+    return (sideToMove == Color::White) ? networkScore : -networkScore;
   }
 
-  return score;
+  bool found = false;
+  MaterialTable::Entry * material = mMaterialTable.probe(materialKey, found);
+  if (!found)
+  {
+    material->key = materialKey;
+    evaluateMaterial(material);
+  }
+
+  if (material->evaluate != nullptr)
+  {
+    return evaluateScaled(material, pieces, score, sideToMove);
+  }
+  score += material->imbalance;
+
+  // The attack tables are only needed for packed positions
+  if (!mAttackTables)
+  {
+    mAttackTables.reset(new BitBoard);
+  }
+  score += evaluatePieces(mAttackTables.get(), pieces, Color::White) - evaluatePieces(mAttackTables.get(), pieces, Color::Black);
+
+  PawnTable::Entry * entry = mPawnTable.probe(pawnHashKey, found);
+  if (!found)
+  {
+    entry->key = pawnHashKey;
+    entry->pawns[0] = pieces[static_cast<int>(PieceType::WhitePawn) - 1];
+    entry->pawns[1] = pieces[static_cast<int>(PieceType::BlackPawn) - 1];
+    evaluatePawnStructure(entry);
+  }
+  score += entry->score;
+  score += evaluateShelter(entry->pawns[0], Color::White, kingRow[0], kingColumn[0]);
+  score += evaluateShelter(entry->pawns[1], Color::Black, kingRow[1], kingColumn[1]);
+
+  return evaluateScaled(material, pieces, score, sideToMove);
+}
+
+int32_t Evaluation::evaluateStages(const Board * board, int32_t alpha, int32_t beta, bool lazy, bool & complete)
+{
+  complete = true;
+
+  // A network set on the board replaces the hand-written terms
+  const Network * network = board->getNetwork();
+  if (network != nullptr)
+  {
+    int32_t score = network->evaluate(board->getAccumulator(), board->getSideToMove());
+    return (board->getSideToMove() == Color::White) ? score : -score;
+  }
+
+  // The material configuration decides the phase, imbalance and endgame knowledge
+  bool found = false;
+  MaterialTable::Entry * material = mMaterialTable.probe(board->getMaterialKey(), found);
+  if (!found)
+  {
+    material->key = board->getMaterialKey();
+    evaluateMaterial(material);
+  }
+
+  // Only the specialized functions need the pieces of boards without bitboards
+  const BitBoard * bitBoard = board->getBitBoard();
+  uint64_t scanned[12];
+  const uint64_t * pieces = (bitBoard != nullptr) ? bitBoard->getBitboards() : nullptr;
+  if (pieces == nullptr && (material->evaluate != nullptr || material->scale != nullptr))
+  {
+    pieces = board->getPieceBitboards(scanned);
+  }
+
+  if (material->evaluate != nullptr)
+  {
+    return evaluateScaled(material, pieces, 0, board->getSideToMove());
+  }
+
+  // Scaled endgames are worth less than their partial scores suggest, so they are not cut
+  lazy = lazy && material->scale == nullptr && material->factor[0] == MaterialTable::SCALE_NORMAL &&
+         material->factor[1] == MaterialTable::SCALE_NORMAL;
+
+  // Material and piece-square values are kept up to date by the board
+  Score score = board->getPieceSquareScore() + material->imbalance;
+  int32_t phase = material->phase;
+  if (lazy)
+  {
+    int32_t partial = blendScore(score, phase);
+    if (isOutsideWindow(partial, alpha, beta, mLazyMargins[static_cast<uint32_t>(Stage::Material)]))
+    {
+      mLazyCutoffs[static_cast<uint32_t>(Stage::Material)]++;
+      complete = false;
+      return partial;
+    }
+  }
+
+  // Most pawn structures are cached, so they come before the pieces
+  score += evaluatePawns(board);
+  if (lazy)
+  {
+    int32_t partial = blendScore(score, phase);
+    if (isOutsideWindow(partial, alpha, beta, mLazyMargins[static_cast<uint32_t>(Stage::PawnStructure)]))
+    {
+      mLazyCutoffs[static_cast<uint32_t>(Stage::PawnStructure)]++;
+      complete = false;
+      return partial;
+    }
+  }
+
+  // Mobility and king safety need attack bitboards, which only the bitboard representation has
+  if (bitBoard != nullptr)
+  {
+    score += evaluatePieces(bitBoard, pieces, Color::White) - evaluatePieces(bitBoard, pieces, Color::Black);
+  }
+
+  // The midgame and endgame values are blended by the material left
+  return evaluateScaled(material, pieces, score, board->getSideToMove());
+}
+
+int32_t Evaluation::evaluateScaled(const MaterialTable::Entry * entry, const uint64_t * pieces, Score score, Color sideToMove)
+{
+  if (entry->evaluate != nullptr)
+  {
+    int32_t value = entry->evaluate(pieces, entry->strongSide, sideToMove);
+    return (entry->strongSide == Color::White) ? value : -value;
+  }
+
+  // The factor belongs to the side ahead in the endgame
+  Color side = (getEndgameValue(score) > 0) ? Color::White : Color::Black;
+  int32_t factor = entry->factor[static_cast<int>(side)];
+  if (entry->scale != nullptr)
+  {
+    factor = std::min(factor, entry->scale(pieces, entry->strongSide));
+  }
+
+  if (factor != MaterialTable::SCALE_NORMAL)
+  {
+    score = makeScore(getMidgameValue(score), getEndgameValue(score) * factor / MaterialTable::SCALE_NORMAL);
+  }
+  return blendScore(score, entry->phase);
+}
+
+Score Evaluation::evaluateShelter(uint64_t pawns, Color color, int32_t kingRow, int32_t kingColumn)
+{
+  // A side without a king has nothing to shelter
+  if (kingRow >= 8)
+  {
+    return 0;
+  }
+
+  uint64_t files = FILE_H << (7 - kingColumn);
+  files |= getAdjacentFiles(files);
+
+  Score shelter = 0;
+  for (int32_t distance = 1; distance <= 2; distance++)
+  {
+    int32_t row = (color == Color::White) ? kingRow + distance : kingRow - distance;
+    if (row >= 0 && row < 8)
+    {
+      uint64_t shield = pawns & files & (RANK_1 << (row << 3));
+      shelter += static_cast<int32_t>(popCount(shield)) * ShelterPawn[distance - 1];
+    }
+  }
+
+  return (color == Color::White) ? shelter : -shelter;
 }
 
 }
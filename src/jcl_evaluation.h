@@ -7,11 +7,20 @@
 #ifndef JCL_EVALUATION_H
 #define JCL_EVALUATION_H
 
+#include <memory>
+
 #include "jcl_board.h"
+#include "jcl_materialtable.h"
+#include "jcl_pawntable.h"
+#include "jcl_types.h"
 
 namespace jcl
 {
 
+class BitBoard;
+class Network;
+struct PackedPosition;
+
 /*!
  * \brief Defines the Evaluation class
  *
@@ -22,9 +31,80 @@ namespace jcl
  * board position from the standpoint of the white player.
  * Positive scores mean that white has a better position
  * while negative scores mean the black has a better position.
+ *
+ * The material and piece-square terms are maintained by the
+ * board as moves are made and unmade (see \ref PieceSquare),
+ * so they cost a single load rather than a scan of the board.
+ *
+ * Evaluation terms are integers that pack a midgame and an
+ * endgame value (see \ref Score). The two values are
+ * interpolated once at the end by the game phase, so that a
+ * term can weigh differently as the pieces come off the board.
+ * Scores are in centipawns.
+ *
+ * When the board is a \ref BitBoard the evaluation also scores
+ * the mobility of knights, bishops, rooks and queens. Mobility is
+ * the number of squares a piece attacks that are neither occupied
+ * by its own pieces nor attacked by enemy pawns, counted from the
+ * attack bitboards without generating moves.
+ *
+ * The same attack bitboards score king safety. Each piece attacking
+ * the zone around the enemy king adds attack units for every zone
+ * square it attacks, weighted by the kind of piece. With at least two
+ * attackers the units index a danger table that grows faster than
+ * linearly, since a coordinated attack is worth more than its parts.
+ *
+ * Pawn structure (passed, isolated, doubled and backward pawns) is
+ * evaluated with bitboard fills and cached in a \ref PawnTable
+ * keyed by the pawn hash key of the board, so it is only computed
+ * when the pawns have changed. The shelter the pawns give each
+ * king depends on where the king stands, so it is computed from the
+ * cached pawn bitboards on every call.
+ *
+ * The game phase, the material imbalance and the endgame knowledge
+ * depend only on the number of pieces of each kind, so they are
+ * cached in a \ref MaterialTable keyed by the material key of the
+ * board and computed once for each material configuration. Endgames
+ * with a specialized evaluation (see \ref Endgame) are scored by it
+ * in place of the general terms, and the endgame value of drawish
+ * material is scaled down before it is blended.
+ *
+ * When a \ref Network is set on the board, the network evaluates
+ * the position instead of the terms above, from the accumulator the
+ * board maintains as moves are made.
+ *
+ * Given a search window, the hand-written terms are evaluated in
+ * stages, cheapest first: material and piece-square values, then
+ * pawn structure, then mobility and king safety. After each stage
+ * the evaluation stops if the partial score is further outside the
+ * window than the margin of the stage, which bounds what the later
+ * stages can add, since the search would cut off either way. The
+ * evaluations stopped at each stage are counted.
+ *
+ * The evaluatePosition function scores a \ref PackedPosition
+ * without a board, for scoring large numbers of positions (see
+ * \ref BatchEvaluation). It gathers the material, material key and
+ * pawn key a board would maintain while unpacking the pieces, and evaluates
+ * the same terms with attack tables owned by the evaluation, so it
+ * gives the same score as evaluateBoard on a \ref BitBoard without
+ * any virtual calls.
  */
 class Evaluation
 {
+public:
+
+  /*!
+   * \brief Defines the stages of a lazy evaluation, in the order evaluated
+   */
+  enum class Stage : uint32_t
+  {
+    Material = 0,      /*!< Material and piece-square values */
+    PawnStructure = 1, /*!< Pawn structure and king shelter */
+    Pieces = 2         /*!< Mobility and king safety, which completes the score */
+  };
+
+  static constexpr uint32_t STAGE_COUNT = 3; /*!< The number of stages */
+
 public:
 
   /*!
@@ -34,6 +114,14 @@ public:
    */
   Evaluation();
 
+  /*!
+   * \brief Destructor
+   */
+  ~Evaluation();
+
+  Evaluation(const Evaluation &) = delete;
+  Evaluation & operator=(const Evaluation &) = delete;
+
   /*!
    * \brief Evaluates the board
    *
@@ -44,10 +132,243 @@ public:
    *
    * \param board The board to evaluate
    *
-   * \return The score for the board position
+   * \return The score for the board position in centipawns
+   */
+  int32_t evaluateBoard(const Board * board);
+
+  /*!
+   * \brief Evaluates the board lazily within a window
+   *
+   * This function evaluates the stages in order and stops after a
+   * stage when the partial score is below alpha or above beta by
+   * more than the margin of the stage. The partial score is then
+   * returned, and is only known to lie on the same side of the
+   * window as the full score.
+   *
+   * \param board The board to evaluate
+   * \param alpha The lower bound of the window from the point of view of white
+   * \param beta The upper bound of the window from the point of view of white
+   * \param complete Holds whether every stage was evaluated
+   *
+   * \return The score for the board position in centipawns
+   */
+  int32_t evaluateBoard(const Board * board, int32_t alpha, int32_t beta, bool & complete);
+
+  /*!
+   * \brief Evaluates a packed position
+   *
+   * This function provides the same score as \ref evaluateBoard
+   * for a \ref BitBoard holding the position, without a board.
+   *
+   * \param position The position to evaluate
+   * \param network The network to evaluate with, or nullptr for the hand-written terms
+   *
+   * \return The score for the position in centipawns from the point of view of white
+   */
+  int32_t evaluatePosition(const PackedPosition & position, const Network * network = nullptr);
+
+  /*!
+   * \brief Clears the lazy evaluation counts
+   */
+  void clearStatistics();
+
+  /*!
+   * \brief Returns the number of lazy evaluations stopped after a stage
+   *
+   * \param stage The stage
+   *
+   * \return The number of evaluations stopped after the stage
+   */
+  uint64_t getLazyCutoffs(Stage stage) const;
+
+  /*!
+   * \brief Returns the number of lazy evaluations
+   *
+   * \return The number of evaluations given a window
+   */
+  uint64_t getLazyEvaluations() const;
+
+  /*!
+   * \brief Returns the margin of a stage
+   *
+   * \param stage The stage
+   *
+   * \return The margin in centipawns
+   */
+  int32_t getLazyMargin(Stage stage) const;
+
+  /*!
+   * \brief Returns the material table
+   *
+   * \return The material table
+   */
+  MaterialTable & getMaterialTable();
+
+  /*!
+   * \brief Returns the material table
+   *
+   * \return The material table
+   */
+  const MaterialTable & getMaterialTable() const;
+
+  /*!
+   * \brief Returns the pawn structure table
+   *
+   * \return The pawn structure table
+   */
+  PawnTable & getPawnTable();
+
+  /*!
+   * \brief Returns the pawn structure table
+   *
+   * \return The pawn structure table
+   */
+  const PawnTable & getPawnTable() const;
+
+  /*!
+   * \brief Sets the margin of a stage
+   *
+   * The margin of a stage should bound the terms of the stages that
+   * follow it. Larger margins stop fewer evaluations and make fewer
+   * mistakes. The score is complete after the last stage, so its
+   * margin is not used.
+   *
+   * \param stage The stage
+   * \param margin The margin in centipawns
+   */
+  void setLazyMargin(Stage stage, int32_t margin);
+
+private:
+
+  /*!
+   * \brief Evaluates the hand-written terms in stages
+   *
+   * \param board The board to evaluate
+   * \param alpha The lower bound of the window from the point of view of white
+   * \param beta The upper bound of the window from the point of view of white
+   * \param lazy Whether to stop early outside the window
+   * \param complete Holds whether every stage was evaluated
+   *
+   * \return The score for the board position in centipawns
+   */
+  int32_t evaluateStages(const Board * board, int32_t alpha, int32_t beta, bool lazy, bool & complete);
+
+  /*!
+   * \brief Evaluates a material configuration
+   *
+   * This function fills in the phase and imbalance of an entry from
+   * the piece counts of its key and chooses its endgame functions.
+   *
+   * \param entry The material table entry
+   */
+  static void evaluateMaterial(MaterialTable::Entry * entry);
+
+  /*!
+   * \brief Evaluates the mobility of one side and its attacks on the enemy king
+   *
+   * \param tables The bitboard providing the attack tables
+   * \param pieces The twelve piece bitboards, indexed by PieceType minus one
+   * \param color The side to evaluate
+   *
+   * \return The packed mobility and king attack score for the side
+   */
+  static Score evaluatePieces(const BitBoard * tables, const uint64_t * pieces, Color color);
+
+  /*!
+   * \brief Evaluates the pawn structure and king shelter
+   *
+   * \param board The board to evaluate
+   *
+   * \return The packed pawn score from the point of view of white
+   */
+  Score evaluatePawns(const Board * board);
+
+  /*!
+   * \brief Evaluates a pawn structure
+   *
+   * This function fills in the score and passed pawns of an entry
+   * from its pawn bitboards.
+   *
+   * \param entry The pawn table entry
+   */
+  static void evaluatePawnStructure(PawnTable::Entry * entry);
+
+  /*!
+   * \brief Evaluates the endgame knowledge of a material configuration
+   *
+   * This function scores a position with the specialized evaluation of
+   * the entry if it has one, otherwise it scales the endgame value of
+   * the score by the side ahead and blends it by the phase.
+   *
+   * \param entry The material table entry
+   * \param pieces The twelve piece bitboards, indexed by PieceType minus one
+   * \param score The packed score from the point of view of white
+   * \param sideToMove The side to move
+   *
+   * \return The score for the position in centipawns
+   */
+  static int32_t evaluateScaled(const MaterialTable::Entry * entry, const uint64_t * pieces, Score score, Color sideToMove);
+
+  /*!
+   * \brief Evaluates the shelter the pawns give a king
+   *
+   * \param pawns The pawns of the side of the king
+   * \param color The side of the king
+   * \param kingRow The row of the king, 8 if there is none
+   * \param kingColumn The column of the king
+   *
+   * \return The packed shelter score from the point of view of white
    */
-  double evaluateBoard(const Board * board);
+  static Score evaluateShelter(uint64_t pawns, Color color, int32_t kingRow, int32_t kingColumn);
+
+private:
+  std::unique_ptr<BitBoard> mAttackTables; // Attack tables for packed positions, created on first use
+  MaterialTable mMaterialTable;
+  PawnTable mPawnTable;
+  int32_t mLazyMargins[STAGE_COUNT];       // Margin of each stage
+  uint64_t mLazyCutoffs[STAGE_COUNT];      // Lazy evaluations stopped after each stage
+  uint64_t mLazyEvaluations;               // Evaluations given a window
 };
 
+inline uint64_t Evaluation::getLazyCutoffs(Stage stage) const
+{
+  return mLazyCutoffs[static_cast<uint32_t>(stage)];
+}
+
+inline uint64_t Evaluation::getLazyEvaluations() const
+{
+  return mLazyEvaluations;
+}
+
+inline int32_t Evaluation::getLazyMargin(Stage stage) const
+{
+  return mLazyMargins[static_cast<uint32_t>(stage)];
+}
+
+inline MaterialTable & Evaluation::getMaterialTable()
+{
+  return mMaterialTable;
+}
+
+inline const MaterialTable & Evaluation::getMaterialTable() const
+{
+  return mMaterialTable;
+}
+
+inline PawnTable & Evaluation::getPawnTable()
+{
+  return mPawnTable;
+}
+
+inline const PawnTable & Evaluation::getPawnTable() const
+{
+  return mPawnTable;
+}
+
+inline void Evaluation::setLazyMargin(Stage stage, int32_t margin)
+{
+  mLazyMargins[static_cast<uint32_t>(stage)] = margin;
+}
+
 }
 #endif // #ifndef JCL_EVALUATION_H
@@ -0,0 +1,43 @@
+/*!
+ * \file jcl_evaluationcache.cpp
+ *
+ * This file contains the implementation for the EvaluationCache object
+ */
+
+#include "jcl_evaluationcache.h"
+
+namespace jcl
+{
+
+EvaluationCache::EvaluationCache(size_t megabytes)
+  : mEntryCount(0)
+  , mSize(0)
+{
+  resize(megabytes);
+}
+
+void EvaluationCache::clear()
+{
+  for (size_t i = 0; i < mEntryCount; i++)
+  {
+    mEntries[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void EvaluationCache::resize(size_t megabytes)
+{
+  // The entry count is a power of two so the index is a mask of the key
+  size_t bytes = ((megabytes > 0) ? megabytes : 1) * 1024 * 1024;
+  size_t entryCount = 1;
+  while (entryCount * 2 * sizeof(std::atomic<uint64_t>) <= bytes)
+  {
+    entryCount *= 2;
+  }
+
+  mEntries.reset(new std::atomic<uint64_t>[entryCount]);
+  mEntryCount = entryCount;
+  mSize = megabytes;
+  clear();
+}
+
+}
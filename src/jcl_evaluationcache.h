@@ -0,0 +1,144 @@
+/*!
+ * \file jcl_evaluationcache.h
+ *
+ * This file contains the interface for the EvaluationCache object
+ */
+
+#ifndef JCL_EVALUATIONCACHE_H
+#define JCL_EVALUATIONCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines a table of static evaluations indexed by position hash
+ *
+ * The EvaluationCache object stores the static evaluation of
+ * positions, so that a position reached again through a
+ * transposition, a re-search or the stand-pat of a quiescence search
+ * is not evaluated again. It is sized independently of the
+ * \ref TranspositionTable, since its entries are much smaller.
+ *
+ * The table is direct mapped. Each entry is a single 64-bit word
+ * holding the upper 48 bits of the hash key and a 16-bit score, so
+ * it can be shared by searches on different threads without locking:
+ * a word is always read and written whole and an entry can never hold
+ * the score of one position with the key of another.
+ *
+ * The table does not count its probes, since counters shared by
+ * several threads would be written on every evaluation. Each
+ * \ref Search counts the probes and hits it makes instead.
+ */
+class EvaluationCache
+{
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs an EvaluationCache object of the
+   * specified size.
+   *
+   * \param megabytes The size of the table in megabytes
+   */
+  EvaluationCache(size_t megabytes = 4);
+
+  /*!
+   * \brief Clears the table
+   */
+  void clear();
+
+  /*!
+   * \brief Returns the number of entries
+   *
+   * \return The number of entries
+   */
+  size_t getEntryCount() const;
+
+  /*!
+   * \brief Returns the size of the table
+   *
+   * \return The size of the table in megabytes
+   */
+  size_t getSize() const;
+
+  /*!
+   * \brief Looks up the score of a position
+   *
+   * \param key The hash key of the position
+   * \param score Holds the stored score if the position was found
+   *
+   * \return true if the position was found, false otherwise
+   */
+  bool probe(uint64_t key, int32_t & score) const;
+
+  /*!
+   * \brief Resizes the table
+   *
+   * This function reallocates the table with the specified size,
+   * which discards all entries. The table must not be in use by a
+   * search.
+   *
+   * \param megabytes The size of the table in megabytes
+   */
+  void resize(size_t megabytes);
+
+  /*!
+   * \brief Stores the score of a position
+   *
+   * The entry always replaces the one stored at its index. Scores
+   * that do not fit in 16 bits are not stored.
+   *
+   * \param key The hash key of the position
+   * \param score The score of the position
+   */
+  void store(uint64_t key, int32_t score);
+
+private:
+  static constexpr uint64_t KEY_MASK = ~0xffffULL; // Key bits stored above the 16-bit score
+
+private:
+  size_t mEntryCount;
+  size_t mSize;
+  std::unique_ptr<std::atomic<uint64_t>[]> mEntries;
+};
+
+inline size_t EvaluationCache::getEntryCount() const
+{
+  return mEntryCount;
+}
+
+inline size_t EvaluationCache::getSize() const
+{
+  return mSize;
+}
+
+inline bool EvaluationCache::probe(uint64_t key, int32_t & score) const
+{
+  uint64_t entry = mEntries[key & (mEntryCount - 1)].load(std::memory_order_relaxed);
+  if (entry == 0 || ((entry ^ key) & KEY_MASK) != 0)
+  {
+    return false;
+  }
+
+  score = static_cast<int16_t>(entry & 0xffff);
+  return true;
+}
+
+inline void EvaluationCache::store(uint64_t key, int32_t score)
+{
+  if (score >= INT16_MIN && score <= INT16_MAX)
+  {
+    uint64_t entry = (key & KEY_MASK) | static_cast<uint16_t>(score);
+    mEntries[key & (mEntryCount - 1)].store(entry, std::memory_order_relaxed);
+  }
+}
+
+}
+
+#endif // #ifndef JCL_EVALUATIONCACHE_H
@@ -106,6 +106,59 @@ inline bool FastBoard8x8::checkSlidingAttacks(uint8_t index,
   return false;
 }
 
+bool FastBoard8x8::doGenerateCaptures(MoveList & moveList) const
+{
+  Color sideToMove = this->getSideToMove();
+
+  for (uint8_t index = 0; index < 64; index++)
+  {
+    Piece piece = mPieces[index];
+    if (piece == Piece::None || mColors[index] != sideToMove)
+    {
+      continue;
+    }
+
+    switch (piece)
+    {
+    case Piece::Pawn:
+      generatePawnCaptures(index, sideToMove, moveList);
+      break;
+    case Piece::Knight:
+      generateNonSliderCaptures(index, piece, mKnightMoves, moveList);
+      break;
+    case Piece::King:
+      generateNonSliderCaptures(index, piece, mKingMoves, moveList);
+      break;
+    case Piece::Bishop:
+      generateSliderCaptures(index, piece, mNorthEastMoves, moveList);
+      generateSliderCaptures(index, piece, mNorthWestMoves, moveList);
+      generateSliderCaptures(index, piece, mSouthEastMoves, moveList);
+      generateSliderCaptures(index, piece, mSouthWestMoves, moveList);
+      break;
+    case Piece::Rook:
+      generateSliderCaptures(index, piece, mNorthMoves, moveList);
+      generateSliderCaptures(index, piece, mSouthMoves, moveList);
+      generateSliderCaptures(index, piece, mEastMoves, moveList);
+      generateSliderCaptures(index, piece, mWestMoves, moveList);
+      break;
+    case Piece::Queen:
+      generateSliderCaptures(index, piece, mNorthMoves, moveList);
+      generateSliderCaptures(index, piece, mSouthMoves, moveList);
+      generateSliderCaptures(index, piece, mEastMoves, moveList);
+      generateSliderCaptures(index, piece, mWestMoves, moveList);
+      generateSliderCaptures(index, piece, mNorthEastMoves, moveList);
+      generateSliderCaptures(index, piece, mNorthWestMoves, moveList);
+      generateSliderCaptures(index, piece, mSouthEastMoves, moveList);
+      generateSliderCaptures(index, piece, mSouthWestMoves, moveList);
+      break;
+    default:
+      break;
+    }
+  }
+
+  return true;
+}
+
 bool FastBoard8x8::doGenerateMoves(MoveList & moveList) const
 {
   generateCastlingMoves(moveList);
@@ -136,6 +189,12 @@ bool FastBoard8x8::doMakeMove(const Move * move)
 {
   //mMakeMoveTimer.start();
 
+  // Null moves do not change any squares
+  if (move->isNull())
+  {
+    return true;
+  }
+
   Color side = this->getSideToMove();
   uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
   uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
@@ -403,6 +462,12 @@ bool FastBoard8x8::doUnmakeMove(const Move * move)
 {
   // mUnmakeMoveTimer.start();
 
+  // Null moves do not change any squares
+  if (move->isNull())
+  {
+    return true;
+  }
+
   Color side = this->getSideToMove();
   uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
   uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
@@ -687,6 +752,46 @@ void FastBoard8x8::generateNonSliderMoves(uint8_t index, Piece piece, const uint
   //mNonSliderTimer.stop();
 }
 
+void FastBoard8x8::generateNonSliderCaptures(uint8_t index, Piece piece, const uint8_t attackVector[][8], MoveList & moveList) const
+{
+  Color otherSide = !this->getSideToMove();
+
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    uint8_t destIndex = attackVector[index][i];
+    if (destIndex != INVALID_SQUARE && mPieces[destIndex] != Piece::None && mColors[destIndex] == otherSide)
+    {
+      pushMove(index, destIndex, piece, mPieces[destIndex], Piece::None, Move::Type::Capture, moveList);
+    }
+  }
+}
+
+void FastBoard8x8::generateSliderCaptures(uint8_t index, Piece piece, const uint8_t attackVector[][8], MoveList & moveList) const
+{
+  Color otherSide = !this->getSideToMove();
+
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    uint8_t destIndex = attackVector[index][i];
+
+    // Valid slider attacks are always at the beginning of the array
+    if (destIndex == INVALID_SQUARE)
+    {
+      break;
+    }
+
+    // Only the first occupied square along the ray can be captured
+    if (mPieces[destIndex] != Piece::None)
+    {
+      if (mColors[destIndex] == otherSide)
+      {
+        pushMove(index, destIndex, piece, mPieces[destIndex], Piece::None, Move::Type::Capture, moveList);
+      }
+      break;
+    }
+  }
+}
+
 void FastBoard8x8::generateSliderMoves(uint8_t index, Piece piece, const uint8_t attackVector[][8], MoveList & moveList) const
 {
   //mSliderTimer.start();
@@ -821,6 +926,68 @@ void FastBoard8x8::generatePawnMoves(uint8_t index,
   //mPawnTimer.stop();
 }
 
+void FastBoard8x8::generatePawnCaptures(uint8_t index,
+                                        Color sideToMove,
+                                        MoveList & moveList) const
+{
+  Color otherSide = !sideToMove;
+  int8_t row = getRow(index);
+  int8_t col = getCol(index);
+  int8_t rowIncr = (sideToMove == Color::White) ? +1 : -1;
+  int8_t destRow = row + rowIncr;
+
+  if (destRow < 0 || destRow > 7)
+  {
+    return;
+  }
+
+  bool promotion = (destRow == 0 || destRow == 7);
+
+  // Generate promotions from a standard push
+  uint8_t destIndex = getIndex(destRow, col);
+  if (promotion && mPieces[destIndex] == Piece::None)
+  {
+    pushMove(index, destIndex, Piece::Pawn, Piece::None, Piece::Queen, Move::Type::Promotion, moveList);
+    pushMove(index, destIndex, Piece::Pawn, Piece::None, Piece::Rook, Move::Type::Promotion, moveList);
+    pushMove(index, destIndex, Piece::Pawn, Piece::None, Piece::Bishop, Move::Type::Promotion, moveList);
+    pushMove(index, destIndex, Piece::Pawn, Piece::None, Piece::Knight, Move::Type::Promotion, moveList);
+  }
+
+  // Generate capture moves
+  int8_t enPassantColumn = getEnpassantColumn();
+  int8_t enPassantRow = (sideToMove == Color::White) ? 5 : 2;
+  constexpr int8_t dirs[] = {EAST, WEST};
+  for (int8_t i = 0; i < 2; i++)
+  {
+    int8_t destCol = col + dirs[i];
+    if (destCol < 0 || destCol > 7)
+    {
+      continue;
+    }
+
+    destIndex = getIndex(destRow, destCol);
+    Piece capturePiece = mPieces[destIndex];
+    if (capturePiece != Piece::None && mColors[destIndex] == otherSide)
+    {
+      if (promotion)
+      {
+        pushMove(index, destIndex, Piece::Pawn, capturePiece, Piece::Queen, Move::Type::PromotionCapture, moveList);
+        pushMove(index, destIndex, Piece::Pawn, capturePiece, Piece::Rook, Move::Type::PromotionCapture, moveList);
+        pushMove(index, destIndex, Piece::Pawn, capturePiece, Piece::Bishop, Move::Type::PromotionCapture, moveList);
+        pushMove(index, destIndex, Piece::Pawn, capturePiece, Piece::Knight, Move::Type::PromotionCapture, moveList);
+      }
+      else
+      {
+        pushMove(index, destIndex, Piece::Pawn, capturePiece, Piece::None, Move::Type::Capture, moveList);
+      }
+    }
+    else if (destRow == enPassantRow && destCol == enPassantColumn)
+    {
+      pushMove(index, destIndex, Piece::Pawn, Piece::Pawn, Piece::Pawn, Move::Type::EpCapture, moveList);
+    }
+  }
+}
+
 PieceType FastBoard8x8::doGetPieceType(uint8_t row,
                                      uint8_t col) const
 {
@@ -863,7 +1030,7 @@ void FastBoard8x8::initBoard()
     mColors[i] = Color::None;
   }
 
-  for (uint8_t i = A1; i <= H1; i++)
+  for (uint8_t i = A2; i <= H2; i++)
   {
     mPieces[i] = Piece::Pawn;
     mColors[i] = Color::White;
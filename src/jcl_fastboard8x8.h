@@ -49,6 +49,7 @@ public:
 protected:
 
   // Overrides
+  bool doGenerateCaptures(MoveList & moveList) const override;
   bool doGenerateMoves(MoveList & moveList) const override;
   bool doGenerateMoves(uint8_t row, uint8_t col, MoveList & moveList) const override;
   PieceType doGetPieceType(uint8_t row, uint8_t col) const override;
@@ -78,6 +79,55 @@ private:
                               Piece piece,
                               const uint8_t attackVector[][8]) const;
 
+  /*!
+   * \brief Generates the captures for a non-sliding piece
+   *
+   * This function generates all capture moves for the non-sliding
+   * piece (king, knight) at the specified index. Only destination
+   * squares occupied by an opposing piece are considered.
+   *
+   * \param index The index of the piece
+   * \param piece The piece that is moving
+   * \param attackVector The precomputed destination squares for the piece
+   * \param moveList The move list to hold the moves
+   */
+  void generateNonSliderCaptures(uint8_t index,
+                                 Piece piece,
+                                 const uint8_t attackVector[][8],
+                                 MoveList & moveList) const;
+
+  /*!
+   * \brief Generates the captures and promotions for a pawn
+   *
+   * This function generates all capture moves, including enpassant
+   * captures, and all promotions for the pawn located at the
+   * specified index.
+   *
+   * \param index The index of the pawn
+   * \param sideToMove The color of the pawn
+   * \param moveList The move list to hold the moves
+   */
+  void generatePawnCaptures(uint8_t index,
+                            Color sideToMove,
+                            MoveList & moveList) const;
+
+  /*!
+   * \brief Generates the captures for a sliding piece
+   *
+   * This function follows a single ray from the specified index
+   * to the first occupied square and generates a capture if that
+   * square holds an opposing piece.
+   *
+   * \param index The index of the piece
+   * \param piece The piece that is moving
+   * \param attackVector The precomputed ray of squares for the piece
+   * \param moveList The move list to hold the moves
+   */
+  void generateSliderCaptures(uint8_t index,
+                              Piece piece,
+                              const uint8_t attackVector[][8],
+                              MoveList & moveList) const;
+
   /*!
    * \brief Generates the castling moves
    *
@@ -0,0 +1,106 @@
+/*!
+ * \file jcl_mappedfile.cpp
+ *
+ * This file contains the implementation for the MappedFile object
+ */
+
+#include "jcl_mappedfile.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jcl
+{
+
+MappedFile::MappedFile()
+  : mData(nullptr)
+  , mSize(0)
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+void MappedFile::close()
+{
+  if (mData != nullptr)
+  {
+#if defined(_WIN32)
+    UnmapViewOfFile(mData);
+#else
+    munmap(mData, mSize);
+#endif
+  }
+
+  mFileName.clear();
+  mData = nullptr;
+  mSize = 0;
+}
+
+bool MappedFile::open(const std::string & fileName)
+{
+  close();
+
+  void * data = nullptr;
+  size_t size = 0;
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  // The view keeps the mapping open after its handles are closed
+  LARGE_INTEGER fileSize;
+  if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+  {
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+    {
+      data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      size = static_cast<size_t>(fileSize.QuadPart);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  int file = ::open(fileName.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    return false;
+  }
+
+  // The mapping stays valid after the file is closed
+  struct stat status;
+  if (fstat(file, &status) == 0 && status.st_size > 0)
+  {
+    size = static_cast<size_t>(status.st_size);
+    data = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    data = (data == MAP_FAILED) ? nullptr : data;
+  }
+  ::close(file);
+#endif
+
+  if (data == nullptr)
+  {
+    return false;
+  }
+
+  mFileName = fileName;
+  mData = data;
+  mSize = size;
+  return true;
+}
+
+}
@@ -0,0 +1,121 @@
+/*!
+ * \file jcl_mappedfile.h
+ *
+ * This file contains the interface for the MappedFile object
+ */
+
+#ifndef JCL_MAPPEDFILE_H
+#define JCL_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines a read-only file mapped into memory
+ *
+ * The MappedFile object maps a whole file into memory, so opening it
+ * takes no time, only the pages that are read are loaded and the
+ * pages are shared by every process mapping the same file. The
+ * mapping stays valid after the file itself is closed, until \ref
+ * close is called or the object is destroyed. The opening book, the
+ * network weights and the endgame tables are all read this way.
+ */
+class MappedFile
+{
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a MappedFile object with no file mapped.
+   */
+  MappedFile();
+
+  /*!
+   * \brief Destructor
+   *
+   * This function unmaps the file, if one is mapped.
+   */
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  /*!
+   * \brief Unmaps the file
+   */
+  void close();
+
+  /*!
+   * \brief Returns the start of the mapped file
+   *
+   * \return The first byte of the file, or nullptr if no file is mapped
+   */
+  const uint8_t * getData() const;
+
+  /*!
+   * \brief Returns the name of the mapped file
+   *
+   * \return The file name, or an empty string if no file is mapped
+   */
+  const std::string & getFileName() const;
+
+  /*!
+   * \brief Returns the size of the mapped file
+   *
+   * \return The size in bytes, or zero if no file is mapped
+   */
+  size_t getSize() const;
+
+  /*!
+   * \brief Returns whether a file is mapped
+   *
+   * \return true if a file is mapped, false otherwise
+   */
+  bool isOpen() const;
+
+  /*!
+   * \brief Maps a file into memory
+   *
+   * This function unmaps the file already mapped, if any, and maps
+   * the whole of the specified file.
+   *
+   * \param fileName The name of the file
+   *
+   * \return true if the file was mapped, false if it cannot be opened or is empty
+   */
+  bool open(const std::string & fileName);
+
+private:
+  std::string mFileName;           // Name of the mapped file
+  void * mData;                    // Start of the mapped file
+  size_t mSize;                    // Size of the mapped file
+};
+
+inline const uint8_t * MappedFile::getData() const
+{
+  return static_cast<const uint8_t *>(mData);
+}
+
+inline const std::string & MappedFile::getFileName() const
+{
+  return mFileName;
+}
+
+inline size_t MappedFile::getSize() const
+{
+  return mSize;
+}
+
+inline bool MappedFile::isOpen() const
+{
+  return mData != nullptr;
+}
+
+}
+
+#endif // #ifndef JCL_MAPPEDFILE_H
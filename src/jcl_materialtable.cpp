@@ -0,0 +1,49 @@
+/*!
+ * \file jcl_materialtable.cpp
+ *
+ * This file contains the implementation for the MaterialTable object
+ */
+
+#include "jcl_materialtable.h"
+
+namespace jcl
+{
+
+MaterialTable::MaterialTable(size_t entryCount)
+  : mEntryCount(1)
+  , mHits(0)
+  , mProbes(0)
+{
+  // The entry count is a power of two so the index is a mask of the mixed key
+  while (mEntryCount * 2 <= entryCount)
+  {
+    mEntryCount *= 2;
+  }
+
+  mEntries.reset(new Entry[mEntryCount]);
+  clear();
+}
+
+void MaterialTable::clear()
+{
+  // No position has fifteen pieces of every type, so an empty entry never matches
+  for (size_t i = 0; i < mEntryCount; i++)
+  {
+    mEntries[i] = Entry();
+    mEntries[i].key = ~0ULL;
+  }
+  clearStatistics();
+}
+
+void MaterialTable::clearStatistics()
+{
+  mHits = 0;
+  mProbes = 0;
+}
+
+double MaterialTable::getHitRate() const
+{
+  return (mProbes == 0) ? 0.0 : (100.0 * static_cast<double>(mHits) / static_cast<double>(mProbes));
+}
+
+}
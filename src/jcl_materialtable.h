@@ -0,0 +1,210 @@
+/*!
+ * \file jcl_materialtable.h
+ *
+ * This file contains the interface for the MaterialTable object
+ */
+
+#ifndef JCL_MATERIALTABLE_H
+#define JCL_MATERIALTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines a table of material configuration evaluations
+ *
+ * The MaterialTable object caches the terms that depend only on the
+ * number of pieces of each kind, indexed by the material key of the
+ * board. The key packs the count of each piece type into four bits,
+ * so it identifies the material exactly and the counts can be read
+ * back from it (see \ref getPieceCount). The material changes only
+ * on captures and promotions, so almost every position visited by a
+ * search finds its entry already computed.
+ *
+ * Each entry holds the game phase, the material imbalance and the
+ * largest share of its advantage each side can convert, along with
+ * a specialized evaluation function for endgames the general terms
+ * misjudge, or a scaling function for endgames that tend to be
+ * drawn (see \ref Endgame).
+ *
+ * The table counts probes and hits to measure its hit rate. It is
+ * not shared between threads, each evaluation owns its own table.
+ */
+class MaterialTable
+{
+public:
+
+  /*!
+   * \brief Defines a specialized endgame evaluation
+   *
+   * The function receives the piece bitboards, indexed by PieceType
+   * minus one, the side the function was chosen for and the side to
+   * move, and returns the score in centipawns from the point of view
+   * of the strong side.
+   */
+  typedef int32_t (*EndgameFunction)(const uint64_t * pieces, Color strongSide, Color sideToMove);
+
+  /*!
+   * \brief Defines an endgame scaling function
+   *
+   * The function receives the piece bitboards, indexed by PieceType
+   * minus one, and the side the function was chosen for, and returns
+   * the factor applied to the endgame value, from zero for a draw to
+   * SCALE_NORMAL.
+   */
+  typedef int32_t (*ScaleFunction)(const uint64_t * pieces, Color strongSide);
+
+  static constexpr int32_t SCALE_NORMAL = 64; /*!< The scale factor that leaves a score unchanged */
+
+  /*!
+   * \brief Defines the contents of an entry
+   */
+  struct Entry
+  {
+    uint64_t key;                    /*!< The material key */
+    Score imbalance;                 /*!< The material imbalance from the point of view of white */
+    int32_t phase;                   /*!< The game phase */
+    int32_t factor[2];               /*!< The scale factor of an advantage for each color, indexed by Color */
+    Color strongSide;                /*!< The side the functions were chosen for */
+    EndgameFunction evaluate;        /*!< The specialized evaluation, or nullptr */
+    ScaleFunction scale;             /*!< The scaling function, or nullptr */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a MaterialTable object with the
+   * specified number of entries, rounded down to a power of two.
+   *
+   * \param entryCount The number of entries
+   */
+  MaterialTable(size_t entryCount = 8192);
+
+  /*!
+   * \brief Clears the table and its statistics
+   */
+  void clear();
+
+  /*!
+   * \brief Clears the probe and hit counts
+   */
+  void clearStatistics();
+
+  /*!
+   * \brief Returns the number of entries
+   *
+   * \return The number of entries
+   */
+  size_t getEntryCount() const;
+
+  /*!
+   * \brief Returns the number of probes that found their material
+   *
+   * \return The number of hits
+   */
+  uint64_t getHits() const;
+
+  /*!
+   * \brief Returns the hit rate
+   *
+   * \return The percentage of probes that were hits, or zero if there were no probes
+   */
+  double getHitRate() const;
+
+  /*!
+   * \brief Returns the number of pieces of a type in a material key
+   *
+   * \param key The material key
+   * \param pieceType The type of piece, other than PieceType::None
+   *
+   * \return The number of pieces
+   */
+  static uint32_t getPieceCount(uint64_t key, PieceType pieceType);
+
+  /*!
+   * \brief Returns the material key of a single piece
+   *
+   * The material key of a position is the sum of the keys of its
+   * pieces, so it is updated by adding or subtracting the key of a
+   * piece. The key for PieceType::None is zero.
+   *
+   * \param pieceType The type of piece
+   *
+   * \return The material key of the piece
+   */
+  static uint64_t getPieceKey(PieceType pieceType);
+
+  /*!
+   * \brief Returns the number of probes
+   *
+   * \return The number of probes
+   */
+  uint64_t getProbes() const;
+
+  /*!
+   * \brief Looks up a material configuration
+   *
+   * This function returns the entry for the material key. When the
+   * entry holds a different configuration the caller is expected to
+   * evaluate the material and fill in the entry, including its key.
+   *
+   * \param key The material key
+   * \param found Set to true if the entry holds the configuration, false otherwise
+   *
+   * \return The entry for the key
+   */
+  Entry * probe(uint64_t key, bool & found);
+
+private:
+  size_t mEntryCount;
+  uint64_t mHits;
+  uint64_t mProbes;
+  std::unique_ptr<Entry[]> mEntries;
+};
+
+inline size_t MaterialTable::getEntryCount() const
+{
+  return mEntryCount;
+}
+
+inline uint64_t MaterialTable::getHits() const
+{
+  return mHits;
+}
+
+inline uint32_t MaterialTable::getPieceCount(uint64_t key, PieceType pieceType)
+{
+  return static_cast<uint32_t>(key >> ((static_cast<int>(pieceType) - 1) << 2)) & 0x0f;
+}
+
+inline uint64_t MaterialTable::getPieceKey(PieceType pieceType)
+{
+  return (pieceType == PieceType::None) ? 0 : (1ULL << ((static_cast<int>(pieceType) - 1) << 2));
+}
+
+inline uint64_t MaterialTable::getProbes() const
+{
+  return mProbes;
+}
+
+inline MaterialTable::Entry * MaterialTable::probe(uint64_t key, bool & found)
+{
+  // The counts sit in the low bits of the key, so it is mixed before indexing
+  Entry * entry = &mEntries[((key * 0x9E3779B97F4A7C15ULL) >> 32) & (mEntryCount - 1)];
+  found = (entry->key == key);
+  mProbes++;
+  mHits += found ? 1 : 0;
+  return entry;
+}
+
+}
+
+#endif // #ifndef JCL_MATERIALTABLE_H
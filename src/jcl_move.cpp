@@ -11,6 +11,11 @@
 namespace jcl
 {
 
+Move::Move()
+  : Move(0, 0, 0, 0, 0, 0, 0, 0, Piece::None)
+{
+}
+
 Move::Move(uint8_t sourceRow,
            uint8_t sourceCol,
            uint8_t destRow,
@@ -72,6 +72,15 @@ public:
     Null = 7              /*!< Defines a NULL move, where a player does not move at all */
   };
 
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs an empty move. The move has no piece
+   * associated with it and \ref isValid will return false until
+   * it is assigned from a valid move.
+   */
+  Move();
+
   /*!
    * \brief Constructor
    *
@@ -284,6 +293,17 @@ public:
    */
   bool isEnPassantCapture() const;
 
+  /*!
+   * \brief Returns whether this move is a null move
+   *
+   * A null move passes the turn to the opponent without
+   * moving any piece. Null moves are not legal chess moves
+   * but are used by engines to prune the search.
+   *
+   * \return true if this move is a null move, false otherwise
+   */
+  bool isNull() const;
+
   /*!
    * \brief Returns whether this move is a quiet move
    *
@@ -414,6 +434,11 @@ inline bool Move::isEnPassantCapture() const
   return (mType == Type::EpCapture);
 }
 
+inline bool Move::isNull() const
+{
+  return (mType == Type::Null);
+}
+
 inline bool Move::isQuiet() const
 {
   return (mType == Type::Quiet);
@@ -0,0 +1,386 @@
+/*!
+ * \file jcl_network.cpp
+ *
+ * This file contains the implementation for the Network object
+ */
+
+#include "jcl_network.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The AVX2 kernels are compiled for AVX2 one function at a time, so the
+// rest of the library runs on any x86-64 processor and the kernels are
+// only called when the processor supports them
+#if defined(JCL_USE_AVX2) && (defined(__x86_64__) || defined(_M_X64))
+#define JCL_NETWORK_AVX2
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define JCL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#include <intrin.h>
+#define JCL_TARGET_AVX2
+#endif
+#endif
+
+#include "jcl_board.h"
+
+namespace jcl
+{
+
+// Dense layer sums are scaled down by this shift before clipping
+static const int32_t WEIGHT_SHIFT = 6;
+
+// The network output is divided by this scale to give centipawns
+static const int32_t OUTPUT_SCALE = 16;
+
+#if defined(JCL_NETWORK_AVX2)
+
+// Returns whether the processor and the operating system support AVX2
+static bool detectAvx2()
+{
+#if defined(__GNUC__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+  {
+    return false;
+  }
+
+  // The operating system must save the 256-bit registers
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+  {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+static const bool HAS_AVX2 = detectAvx2();
+static bool useAvx2 = HAS_AVX2;
+
+// Clips accumulator values to [0, 127] as inputs of the first dense layer
+JCL_TARGET_AVX2 static void clipAccumulatorAvx2(const int16_t * values, uint8_t * output)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  for (uint32_t i = 0; i < Network::HIDDEN_SIZE; i += 32)
+  {
+    __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+    __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i + 16));
+
+    // Packing saturates to [-128, 127] and interleaves the 128-bit lanes,
+    // the permute puts the lanes back in order
+    __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(low, high), zero);
+    packed = _mm256_permute4x64_epi64(packed, 0xD8);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(output + i), packed);
+  }
+}
+
+// Returns the dot product of clipped inputs and 8-bit weights, size a multiple of 32
+JCL_TARGET_AVX2 static int32_t dotProductAvx2(const uint8_t * input, const int8_t * weights, uint32_t size)
+{
+  // Each product pair fits in 16 bits since inputs are at most 127
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (uint32_t i = 0; i < size; i += 32)
+  {
+    __m256i in = _mm256_load_si256(reinterpret_cast<const __m256i *>(input + i));
+    __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+    __m256i product = _mm256_maddubs_epi16(in, weight);
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+  }
+
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+  sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+  return _mm_cvtsi128_si32(sum128);
+}
+
+// Computes the sums of four outputs of a dense layer
+JCL_TARGET_AVX2 static void propagateAvx2(const uint8_t * input, uint32_t inputSize, const int8_t * rows, int32_t * sums)
+{
+  // Four outputs at a time share each input load and the final horizontal sums
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum0 = _mm256_setzero_si256();
+  __m256i sum1 = _mm256_setzero_si256();
+  __m256i sum2 = _mm256_setzero_si256();
+  __m256i sum3 = _mm256_setzero_si256();
+  for (uint32_t j = 0; j < inputSize; j += 32)
+  {
+    __m256i in = _mm256_load_si256(reinterpret_cast<const __m256i *>(input + j));
+    const int8_t * row = rows + j;
+    sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_maddubs_epi16(in, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row))), ones));
+    row += inputSize;
+    sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_maddubs_epi16(in, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row))), ones));
+    row += inputSize;
+    sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_maddubs_epi16(in, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row))), ones));
+    row += inputSize;
+    sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(_mm256_maddubs_epi16(in, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row))), ones));
+  }
+
+  __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), sum128);
+}
+
+// Adds or subtracts a row of feature weights from accumulator values
+JCL_TARGET_AVX2 static void updateValuesAvx2(int16_t * values, const int16_t * weights, int32_t sign)
+{
+  for (uint32_t i = 0; i < Network::HIDDEN_SIZE; i += 16)
+  {
+    __m256i value = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+    __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+    value = (sign > 0) ? _mm256_add_epi16(value, weight) : _mm256_sub_epi16(value, weight);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(values + i), value);
+  }
+}
+
+#endif
+
+// Clips accumulator values to [0, 127] as inputs of the first dense layer
+static void clipAccumulator(const int16_t * values, uint8_t * output)
+{
+#if defined(JCL_NETWORK_AVX2)
+  if (useAvx2)
+  {
+    clipAccumulatorAvx2(values, output);
+    return;
+  }
+#endif
+  for (uint32_t i = 0; i < Network::HIDDEN_SIZE; i++)
+  {
+    output[i] = static_cast<uint8_t>(std::min<int16_t>(std::max<int16_t>(values[i], 0), 127));
+  }
+}
+
+// Returns the dot product of clipped inputs and 8-bit weights, size a multiple of 32
+static int32_t dotProduct(const uint8_t * input, const int8_t * weights, uint32_t size)
+{
+#if defined(JCL_NETWORK_AVX2)
+  if (useAvx2)
+  {
+    return dotProductAvx2(input, weights, size);
+  }
+#endif
+  int32_t sum = 0;
+  for (uint32_t i = 0; i < size; i++)
+  {
+    sum += static_cast<int32_t>(input[i]) * static_cast<int32_t>(weights[i]);
+  }
+  return sum;
+}
+
+// Computes a dense layer and clips its outputs to [0, 127], output size a multiple of 4
+static void propagate(const uint8_t * input, uint32_t inputSize, const int8_t * weights, const int32_t * biases,
+                      uint32_t outputSize, uint8_t * output)
+{
+  for (uint32_t i = 0; i < outputSize; i += 4)
+  {
+    int32_t sums[4];
+#if defined(JCL_NETWORK_AVX2)
+    if (useAvx2)
+    {
+      propagateAvx2(input, inputSize, weights + i * inputSize, sums);
+    }
+    else
+#endif
+    {
+      for (uint32_t k = 0; k < 4; k++)
+      {
+        sums[k] = dotProduct(input, weights + (i + k) * inputSize, inputSize);
+      }
+    }
+
+    for (uint32_t k = 0; k < 4; k++)
+    {
+      int32_t sum = biases[i + k] + sums[k];
+      output[i + k] = static_cast<uint8_t>(std::min(std::max(sum >> WEIGHT_SHIFT, 0), 127));
+    }
+  }
+}
+
+// Adds or subtracts a row of feature weights from accumulator values
+static void updateValues(int16_t * values, const int16_t * weights, int32_t sign)
+{
+#if defined(JCL_NETWORK_AVX2)
+  if (useAvx2)
+  {
+    updateValuesAvx2(values, weights, sign);
+    return;
+  }
+#endif
+  for (uint32_t i = 0; i < Network::HIDDEN_SIZE; i++)
+  {
+    values[i] = static_cast<int16_t>(values[i] + sign * weights[i]);
+  }
+}
+
+Network::Network()
+  : mFeatureBiases(nullptr)
+  , mFeatureWeights(nullptr)
+  , mLayer1Biases(nullptr)
+  , mLayer1Weights(nullptr)
+  , mLayer2Biases(nullptr)
+  , mLayer2Weights(nullptr)
+  , mOutputBias(nullptr)
+  , mOutputWeights(nullptr)
+{
+}
+
+Network::~Network()
+{
+  unload();
+}
+
+int32_t Network::evaluate(const Accumulator & accumulator, Color sideToMove) const
+{
+  alignas(32) uint8_t input[2 * HIDDEN_SIZE];
+  alignas(32) uint8_t hidden1[LAYER1_SIZE];
+  alignas(32) uint8_t hidden2[LAYER2_SIZE];
+
+  // The side to move comes first, so the network sees the position from its side
+  clipAccumulator(accumulator.values[static_cast<int>(sideToMove)], input);
+  clipAccumulator(accumulator.values[static_cast<int>(!sideToMove)], input + HIDDEN_SIZE);
+  propagate(input, 2 * HIDDEN_SIZE, mLayer1Weights, mLayer1Biases, LAYER1_SIZE, hidden1);
+  propagate(hidden1, LAYER1_SIZE, mLayer2Weights, mLayer2Biases, LAYER2_SIZE, hidden2);
+
+  int32_t output = *mOutputBias + dotProduct(hidden2, mOutputWeights, LAYER2_SIZE);
+  return output / OUTPUT_SCALE;
+}
+
+uint32_t Network::getFeatureIndex(Color perspective, uint8_t kingSquare, PieceType pieceType, uint8_t square)
+{
+  // Pawns to queens of the perspective side come before those of the other side
+  int32_t type = static_cast<int32_t>(pieceType);
+  bool white = (type < static_cast<int32_t>(PieceType::BlackPawn));
+  uint32_t piece = static_cast<uint32_t>(white ? (type - 1) : (type - 7));
+  if (white != (perspective == Color::White))
+  {
+    piece += 5;
+  }
+
+  if (perspective == Color::Black)
+  {
+    kingSquare ^= 56;
+    square ^= 56;
+  }
+
+  return kingSquare * PIECE_FEATURES + piece * 64 + square;
+}
+
+size_t Network::getFileSize()
+{
+  return 2 * sizeof(uint32_t)
+      + HIDDEN_SIZE * sizeof(int16_t)
+      + static_cast<size_t>(INPUT_SIZE) * HIDDEN_SIZE * sizeof(int16_t)
+      + LAYER1_SIZE * sizeof(int32_t)
+      + LAYER1_SIZE * 2 * HIDDEN_SIZE * sizeof(int8_t)
+      + LAYER2_SIZE * sizeof(int32_t)
+      + LAYER2_SIZE * LAYER1_SIZE * sizeof(int8_t)
+      + sizeof(int32_t)
+      + LAYER2_SIZE * sizeof(int8_t);
+}
+
+bool Network::isAvx2Enabled()
+{
+#if defined(JCL_NETWORK_AVX2)
+  return useAvx2;
+#else
+  return false;
+#endif
+}
+
+bool Network::load(const std::string & fileName)
+{
+  unload();
+
+  if (!mFile.open(fileName) || mFile.getSize() != getFileSize())
+  {
+    mFile.close();
+    return false;
+  }
+
+  uint32_t header[2];
+  std::memcpy(header, mFile.getData(), sizeof(header));
+  if (header[0] != FILE_MAGIC || header[1] != FILE_VERSION)
+  {
+    unload();
+    return false;
+  }
+
+  // The sections follow the header in order, each aligned to its element size
+  const uint8_t * section = mFile.getData() + sizeof(header);
+  mFeatureBiases = reinterpret_cast<const int16_t *>(section);
+  section += HIDDEN_SIZE * sizeof(int16_t);
+  mFeatureWeights = reinterpret_cast<const int16_t *>(section);
+  section += static_cast<size_t>(INPUT_SIZE) * HIDDEN_SIZE * sizeof(int16_t);
+  mLayer1Biases = reinterpret_cast<const int32_t *>(section);
+  section += LAYER1_SIZE * sizeof(int32_t);
+  mLayer1Weights = reinterpret_cast<const int8_t *>(section);
+  section += LAYER1_SIZE * 2 * HIDDEN_SIZE * sizeof(int8_t);
+  mLayer2Biases = reinterpret_cast<const int32_t *>(section);
+  section += LAYER2_SIZE * sizeof(int32_t);
+  mLayer2Weights = reinterpret_cast<const int8_t *>(section);
+  section += LAYER2_SIZE * LAYER1_SIZE * sizeof(int8_t);
+  mOutputBias = reinterpret_cast<const int32_t *>(section);
+  section += sizeof(int32_t);
+  mOutputWeights = reinterpret_cast<const int8_t *>(section);
+  return true;
+}
+
+void Network::refreshAccumulator(const Board * board, Color perspective, Accumulator & accumulator) const
+{
+  resetAccumulator(accumulator, perspective);
+
+  // A board without a king reports it off the board, leaving only the biases
+  uint8_t kingSquare = static_cast<uint8_t>(board->getKingRow(perspective) * 8 + board->getKingColumn(perspective));
+  for (uint8_t square = 0; square < 64; square++)
+  {
+    updateAccumulator(accumulator, perspective, kingSquare, board->getPieceType(square >> 3, square & 7), square, 1);
+  }
+}
+
+void Network::resetAccumulator(Accumulator & accumulator, Color perspective) const
+{
+  std::memcpy(accumulator.values[static_cast<int>(perspective)], mFeatureBiases, HIDDEN_SIZE * sizeof(int16_t));
+}
+
+bool Network::setAvx2Enabled(bool enabled)
+{
+#if defined(JCL_NETWORK_AVX2)
+  useAvx2 = enabled && HAS_AVX2;
+  return useAvx2;
+#else
+  (void)enabled;
+  return false;
+#endif
+}
+
+void Network::unload()
+{
+  mFile.close();
+  mFeatureBiases = mFeatureWeights = nullptr;
+  mLayer1Biases = mLayer2Biases = mOutputBias = nullptr;
+  mLayer1Weights = mLayer2Weights = mOutputWeights = nullptr;
+}
+
+void Network::updateAccumulator(Accumulator & accumulator, Color perspective, uint8_t kingSquare,
+                                PieceType pieceType, uint8_t square, int32_t sign) const
+{
+  // Kings are not features, and without a king there are no features at all
+  if (pieceType == PieceType::None || pieceType == PieceType::WhiteKing || pieceType == PieceType::BlackKing || kingSquare >= 64)
+  {
+    return;
+  }
+
+  uint32_t index = getFeatureIndex(perspective, kingSquare, pieceType, square);
+  updateValues(accumulator.values[static_cast<int>(perspective)], mFeatureWeights + static_cast<size_t>(index) * HIDDEN_SIZE, sign);
+}
+
+}
@@ -0,0 +1,246 @@
+/*!
+ * \file jcl_network.h
+ *
+ * This file contains the interface for the Network object
+ */
+
+#ifndef JCL_NETWORK_H
+#define JCL_NETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "jcl_mappedfile.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+class Board;
+
+/*!
+ * \brief Defines an efficiently updatable neural network evaluation
+ *
+ * The Network object evaluates a position with a small neural
+ * network in the HalfKP layout. Each input feature is the square
+ * of a piece other than a king, relative to the square of the king
+ * of one side, giving one set of features for each side. The first
+ * layer transforms the active features of each side into an
+ * \ref Accumulator of HIDDEN_SIZE values.
+ *
+ * A move changes only a few features, so the accumulator is not
+ * recomputed for every position. The board keeps a stack of
+ * accumulators, one for each move made, and adds or subtracts the
+ * weights of the pieces a move changes. Only a king move changes
+ * every feature of its own side and requires a refresh.
+ *
+ * The accumulators of the side to move and of the other side are
+ * clipped to [0, 127] and fed through two dense layers of 8-bit
+ * weights and a single output. The dense layers and the accumulator
+ * updates use AVX2 instructions when the library is built with
+ * JCL_USE_AVX2 and the processor supports them, which is checked
+ * once at startup, and portable loops otherwise. Both give the same
+ * result.
+ *
+ * The weights are loaded from a binary file that is mapped into
+ * memory rather than read, so loading is immediate and the pages
+ * are shared by every process using the same file. The file holds
+ * a header of the FILE_MAGIC and FILE_VERSION values followed by
+ * the little endian weights and biases of each layer in order:
+ *
+ * - int16 feature biases [HIDDEN_SIZE]
+ * - int16 feature weights [INPUT_SIZE][HIDDEN_SIZE]
+ * - int32 layer 1 biases [LAYER1_SIZE]
+ * - int8 layer 1 weights [LAYER1_SIZE][2 * HIDDEN_SIZE]
+ * - int32 layer 2 biases [LAYER2_SIZE]
+ * - int8 layer 2 weights [LAYER2_SIZE][LAYER1_SIZE]
+ * - int32 output bias
+ * - int8 output weights [LAYER2_SIZE]
+ */
+class Network
+{
+public:
+  static constexpr uint32_t FILE_MAGIC = 0x4E4C434A;        /*!< The file header magic, "JCLN" */
+  static constexpr uint32_t FILE_VERSION = 1;               /*!< The file format version */
+  static constexpr uint32_t PIECE_FEATURES = 10 * 64;       /*!< Features for each king square */
+  static constexpr uint32_t INPUT_SIZE = 64 * PIECE_FEATURES; /*!< Features for each side */
+  static constexpr uint32_t HIDDEN_SIZE = 128;              /*!< Accumulator values for each side */
+  static constexpr uint32_t LAYER1_SIZE = 32;               /*!< Outputs of the first dense layer */
+  static constexpr uint32_t LAYER2_SIZE = 32;               /*!< Outputs of the second dense layer */
+
+  /*!
+   * \brief Defines the feature transformer outputs for both sides
+   */
+  struct Accumulator
+  {
+    alignas(32) int16_t values[2][HIDDEN_SIZE]; /*!< The outputs for each side, indexed by Color */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a Network object without weights.
+   */
+  Network();
+
+  /*!
+   * \brief Destructor
+   *
+   * This function unmaps the weights file, if one is loaded.
+   */
+  ~Network();
+
+  Network(const Network &) = delete;
+  Network & operator=(const Network &) = delete;
+
+  /*!
+   * \brief Evaluates a position
+   *
+   * \param accumulator The accumulator of the position
+   * \param sideToMove The side to move in the position
+   *
+   * \return The score in centipawns from the point of view of the side to move
+   */
+  int32_t evaluate(const Accumulator & accumulator, Color sideToMove) const;
+
+  /*!
+   * \brief Returns the name of the loaded weights file
+   *
+   * \return The file name, or an empty string if no weights are loaded
+   */
+  const std::string & getFileName() const;
+
+  /*!
+   * \brief Returns the size of a weights file
+   *
+   * \return The size of a weights file in bytes
+   */
+  static size_t getFileSize();
+
+  /*!
+   * \brief Returns whether the AVX2 kernels are used
+   *
+   * \return true if the AVX2 kernels are used, false if the portable loops are
+   */
+  static bool isAvx2Enabled();
+
+  /*!
+   * \brief Returns whether weights are loaded
+   *
+   * \return true if weights are loaded, false otherwise
+   */
+  bool isLoaded() const;
+
+  /*!
+   * \brief Loads the weights from a file
+   *
+   * This function maps the weights file into memory. Any weights
+   * already loaded are unloaded first, so no weights are loaded if
+   * the file cannot be mapped or does not have the expected header
+   * and size.
+   *
+   * \param fileName The name of the weights file
+   *
+   * \return true if the weights were loaded, false otherwise
+   */
+  bool load(const std::string & fileName);
+
+  /*!
+   * \brief Computes the accumulator of one side from scratch
+   *
+   * \param board The board
+   * \param perspective The side whose accumulator is computed
+   * \param accumulator The accumulator to update
+   */
+  void refreshAccumulator(const Board * board, Color perspective, Accumulator & accumulator) const;
+
+  /*!
+   * \brief Sets the accumulator of one side to the feature biases
+   *
+   * This function empties the accumulator of one side, so that the
+   * pieces of a position can be added with \ref updateAccumulator.
+   *
+   * \param accumulator The accumulator to update
+   * \param perspective The side whose accumulator is reset
+   */
+  void resetAccumulator(Accumulator & accumulator, Color perspective) const;
+
+  /*!
+   * \brief Selects the AVX2 kernels or the portable loops
+   *
+   * The AVX2 kernels are enabled by default when they are available.
+   * This function must not be called while positions are evaluated.
+   *
+   * \param enabled true to use the AVX2 kernels, false to use the portable loops
+   *
+   * \return true if the AVX2 kernels are used, which requires a library built
+   *         with JCL_USE_AVX2 and a processor that supports them
+   */
+  static bool setAvx2Enabled(bool enabled);
+
+  /*!
+   * \brief Unloads the weights
+   */
+  void unload();
+
+  /*!
+   * \brief Adds or removes a piece from the accumulator of one side
+   *
+   * Kings are not features, so adding or removing a king leaves
+   * the accumulator unchanged.
+   *
+   * \param accumulator The accumulator to update
+   * \param perspective The side whose accumulator is updated
+   * \param kingSquare The square of the king of the perspective side, as row * 8 + column
+   * \param pieceType The type of piece
+   * \param square The square of the piece, as row * 8 + column
+   * \param sign 1 to add the piece, -1 to remove it
+   */
+  void updateAccumulator(Accumulator & accumulator, Color perspective, uint8_t kingSquare,
+                         PieceType pieceType, uint8_t square, int32_t sign) const;
+
+private:
+
+  /*!
+   * \brief Returns the index of a feature
+   *
+   * Squares are mirrored vertically for black, so that both sides
+   * see the board from their own side and share the same weights.
+   *
+   * \param perspective The side the feature belongs to
+   * \param kingSquare The square of the king of the perspective side
+   * \param pieceType The type of piece, other than a king
+   * \param square The square of the piece
+   *
+   * \return The feature index
+   */
+  static uint32_t getFeatureIndex(Color perspective, uint8_t kingSquare, PieceType pieceType, uint8_t square);
+
+  // Members
+  MappedFile mFile;                   // Mapped weights file
+  const int16_t * mFeatureBiases;     // Feature transformer biases
+  const int16_t * mFeatureWeights;    // Feature transformer weights
+  const int32_t * mLayer1Biases;      // First dense layer biases
+  const int8_t * mLayer1Weights;      // First dense layer weights
+  const int32_t * mLayer2Biases;      // Second dense layer biases
+  const int8_t * mLayer2Weights;      // Second dense layer weights
+  const int32_t * mOutputBias;        // Output bias
+  const int8_t * mOutputWeights;      // Output weights
+};
+
+inline const std::string & Network::getFileName() const
+{
+  return mFile.getFileName();
+}
+
+inline bool Network::isLoaded() const
+{
+  return mFile.isOpen();
+}
+
+}
+
+#endif // #ifndef JCL_NETWORK_H
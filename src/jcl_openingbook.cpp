@@ -0,0 +1,208 @@
+/*!
+ * \file jcl_openingbook.cpp
+ *
+ * This file contains the implementation for the OpeningBook object
+ */
+
+#include "jcl_openingbook.h"
+
+#include "jcl_board.h"
+#include "jcl_movelist.h"
+
+namespace jcl
+{
+
+// Returns a big endian value of the specified number of bytes
+static uint64_t readBigEndian(const uint8_t * data, size_t size)
+{
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; i++)
+  {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+OpeningBook::OpeningBook()
+  : mEntries(nullptr)
+  , mEntryCount(0)
+{
+
+}
+
+OpeningBook::~OpeningBook()
+{
+  unload();
+}
+
+uint16_t OpeningBook::encodeMove(const Move * move)
+{
+  uint32_t destinationColumn = move->getDestinationColumn();
+
+  // The king moves onto its own rook when castling
+  if (move->isCastle())
+  {
+    destinationColumn = (destinationColumn > move->getSourceColumn()) ? 7 : 0;
+  }
+
+  uint32_t promotion = 0;
+  switch (move->getPromotedPiece())
+  {
+  case Piece::Knight:
+    promotion = 1;
+    break;
+  case Piece::Bishop:
+    promotion = 2;
+    break;
+  case Piece::Rook:
+    promotion = 3;
+    break;
+  case Piece::Queen:
+    promotion = 4;
+    break;
+  default:
+    break;
+  }
+
+  return static_cast<uint16_t>(destinationColumn | (move->getDestinationRow() << 3) |
+                               (move->getSourceColumn() << 6) | (move->getSourceRow() << 9) | (promotion << 12));
+}
+
+size_t OpeningBook::findEntries(uint64_t key, std::vector<Entry> & entries) const
+{
+  entries.clear();
+
+  // The first entry whose key is not less than the key
+  size_t first = 0;
+  size_t count = mEntryCount;
+  while (count > 0)
+  {
+    size_t half = count / 2;
+    if (readBigEndian(mEntries + (first + half) * ENTRY_SIZE, 8) < key)
+    {
+      first += half + 1;
+      count -= half + 1;
+    }
+    else
+    {
+      count = half;
+    }
+  }
+
+  for (size_t i = first; i < mEntryCount; i++)
+  {
+    Entry entry = getEntry(i);
+    if (entry.key != key)
+    {
+      break;
+    }
+    entries.push_back(entry);
+  }
+
+  return entries.size();
+}
+
+size_t OpeningBook::findMoves(Board * board, std::vector<Move> & moves, std::vector<uint16_t> & weights) const
+{
+  moves.clear();
+  weights.clear();
+
+  std::vector<Entry> entries;
+  if (findEntries(board->getPolyglotKey(), entries) == 0)
+  {
+    return 0;
+  }
+
+  // Only legal moves of the board are returned, which guards against key collisions
+  MoveList moveList;
+  board->generateMoves(moveList);
+  Color sideToMove = board->getSideToMove();
+  for (const Entry & entry : entries)
+  {
+    for (uint32_t i = 0; i < moveList.size(); i++)
+    {
+      const Move * move = moveList[i];
+      if (entry.weight == 0 || encodeMove(move) != entry.move)
+      {
+        continue;
+      }
+
+      board->makeMove(move);
+      bool legal = !board->isCellAttacked(board->getKingRow(sideToMove), board->getKingColumn(sideToMove), !sideToMove);
+      board->unmakeMove(move);
+      if (legal)
+      {
+        moves.push_back(*move);
+        weights.push_back(entry.weight);
+      }
+      break;
+    }
+  }
+
+  return moves.size();
+}
+
+OpeningBook::Entry OpeningBook::getEntry(size_t index) const
+{
+  const uint8_t * data = mEntries + index * ENTRY_SIZE;
+  Entry entry;
+  entry.key = readBigEndian(data, 8);
+  entry.move = static_cast<uint16_t>(readBigEndian(data + 8, 2));
+  entry.weight = static_cast<uint16_t>(readBigEndian(data + 10, 2));
+  entry.learn = static_cast<uint32_t>(readBigEndian(data + 12, 4));
+  return entry;
+}
+
+bool OpeningBook::load(const std::string & fileName)
+{
+  unload();
+
+  if (!mFile.open(fileName) || mFile.getSize() % ENTRY_SIZE != 0)
+  {
+    mFile.close();
+    return false;
+  }
+
+  mEntries = mFile.getData();
+  mEntryCount = mFile.getSize() / ENTRY_SIZE;
+  return true;
+}
+
+bool OpeningBook::selectMove(Board * board, uint64_t random, Move & move) const
+{
+  std::vector<Move> moves;
+  std::vector<uint16_t> weights;
+  if (findMoves(board, moves, weights) == 0)
+  {
+    return false;
+  }
+
+  uint64_t totalWeight = 0;
+  for (uint16_t weight : weights)
+  {
+    totalWeight += weight;
+  }
+
+  // Each move covers a range of the total weight as wide as its own
+  uint64_t choice = random % totalWeight;
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    if (choice < weights[i])
+    {
+      move = moves[i];
+      return true;
+    }
+    choice -= weights[i];
+  }
+
+  return false;
+}
+
+void OpeningBook::unload()
+{
+  mFile.close();
+  mEntries = nullptr;
+  mEntryCount = 0;
+}
+
+}
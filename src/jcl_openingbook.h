@@ -0,0 +1,190 @@
+/*!
+ * \file jcl_openingbook.h
+ *
+ * This file contains the interface for the OpeningBook object
+ */
+
+#ifndef JCL_OPENINGBOOK_H
+#define JCL_OPENINGBOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "jcl_mappedfile.h"
+#include "jcl_move.h"
+
+namespace jcl
+{
+
+class Board;
+
+/*!
+ * \brief Defines an opening book
+ *
+ * The OpeningBook object reads book files in the Polyglot layout: a
+ * sequence of 16 byte entries sorted by key, each holding the key of
+ * a position, a move, a weight and a learning value, all stored big
+ * endian. The key of a position is its Polyglot key from \ref
+ * Board::getPolyglotKey, which every board maintains incrementally, so
+ * looking up the current position costs nothing to compute and books
+ * written by other Polyglot compatible programs can be read.
+ *
+ * A move is packed in 16 bits: the destination column and row in bits
+ * 0 to 5, the source column and row in bits 6 to 11 and the promoted
+ * piece in bits 12 to 14, from 1 for a knight to 4 for a queen.
+ * Castling is stored as the king capturing its own rook.
+ *
+ * The file is memory-mapped rather than read, so opening a book takes
+ * no time and only the pages visited by the lookups are loaded. The
+ * entries of a position are found by a binary search on the key, so
+ * a lookup visits a few dozen entries whatever the size of the book.
+ * A loaded book is read-only and may be probed from several threads.
+ */
+class OpeningBook
+{
+public:
+  static constexpr size_t ENTRY_SIZE = 16; /*!< The size of an entry in the file */
+
+  /*!
+   * \brief Defines an entry of the book
+   */
+  struct Entry
+  {
+    uint64_t key;    /*!< The key of the position */
+    uint16_t move;   /*!< The move, packed as described above */
+    uint16_t weight; /*!< The weight of the move, zero if it is not played */
+    uint32_t learn;  /*!< The learning value, unused */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs an OpeningBook object with no file loaded.
+   */
+  OpeningBook();
+
+  /*!
+   * \brief Destructor
+   */
+  ~OpeningBook();
+
+  OpeningBook(const OpeningBook &) = delete;
+  OpeningBook & operator=(const OpeningBook &) = delete;
+
+  /*!
+   * \brief Packs a move into its book representation
+   *
+   * \param move The move
+   *
+   * \return The packed move
+   */
+  static uint16_t encodeMove(const Move * move);
+
+  /*!
+   * \brief Finds the entries of a key
+   *
+   * \param key The key of the position
+   * \param entries Receives the entries of the key, in file order
+   *
+   * \return The number of entries found
+   */
+  size_t findEntries(uint64_t key, std::vector<Entry> & entries) const;
+
+  /*!
+   * \brief Finds the legal book moves of a position
+   *
+   * \param board The board, which is restored before returning
+   * \param moves Receives the legal moves with a weight, in file order
+   * \param weights Receives the weight of each move
+   *
+   * \return The number of moves found
+   */
+  size_t findMoves(Board * board, std::vector<Move> & moves, std::vector<uint16_t> & weights) const;
+
+  /*!
+   * \brief Returns an entry
+   *
+   * \param index The index of the entry, less than \ref getEntryCount
+   *
+   * \return The entry
+   */
+  Entry getEntry(size_t index) const;
+
+  /*!
+   * \brief Returns the number of entries
+   *
+   * \return The number of entries, zero if no file is loaded
+   */
+  size_t getEntryCount() const;
+
+  /*!
+   * \brief Returns the name of the loaded file
+   *
+   * \return The file name, or an empty string if no file is loaded
+   */
+  const std::string & getFileName() const;
+
+  /*!
+   * \brief Returns whether a file is loaded
+   *
+   * \return true if a file is loaded, false otherwise
+   */
+  bool isLoaded() const;
+
+  /*!
+   * \brief Loads a book file
+   *
+   * This function maps the file into memory, replacing the file
+   * previously loaded. The entries are not checked for order.
+   *
+   * \param fileName The name of the file
+   *
+   * \return true if the file was loaded, false if it cannot be mapped
+   *         or its size is not a whole number of entries
+   */
+  bool load(const std::string & fileName);
+
+  /*!
+   * \brief Selects a book move at random, in proportion to the weights
+   *
+   * \param board The board, which is restored before returning
+   * \param random A uniformly distributed number, such as from std::mt19937_64
+   * \param move Receives the move selected
+   *
+   * \return true if a move was selected, false if the position has no weighted move
+   */
+  bool selectMove(Board * board, uint64_t random, Move & move) const;
+
+  /*!
+   * \brief Unloads the book file
+   */
+  void unload();
+
+private:
+  MappedFile mFile;                // Mapped book file
+  const uint8_t * mEntries;        // First entry
+  size_t mEntryCount;              // Number of entries
+};
+
+inline size_t OpeningBook::getEntryCount() const
+{
+  return mEntryCount;
+}
+
+inline const std::string & OpeningBook::getFileName() const
+{
+  return mFile.getFileName();
+}
+
+inline bool OpeningBook::isLoaded() const
+{
+  return mFile.isOpen();
+}
+
+}
+
+#endif // #ifndef JCL_OPENINGBOOK_H
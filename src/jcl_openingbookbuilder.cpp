@@ -0,0 +1,292 @@
+/*!
+ * \file jcl_openingbookbuilder.cpp
+ *
+ * This file contains the implementation for the OpeningBookBuilder object
+ */
+
+#include "jcl_openingbookbuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "jcl_board.h"
+#include "jcl_movelist.h"
+#include "jcl_openingbook.h"
+
+namespace jcl
+{
+
+// Returns the piece of a letter of standard algebraic notation, or None
+static Piece getPiece(char letter)
+{
+  switch (letter)
+  {
+  case 'K':
+    return Piece::King;
+  case 'Q':
+    return Piece::Queen;
+  case 'R':
+    return Piece::Rook;
+  case 'B':
+    return Piece::Bishop;
+  case 'N':
+    return Piece::Knight;
+  default:
+    return Piece::None;
+  }
+}
+
+// Writes a value big endian in the specified number of bytes
+static void writeBigEndian(char * data, uint64_t value, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    data[i] = static_cast<char>((value >> (8 * (size - 1 - i))) & 0xff);
+  }
+}
+
+OpeningBookBuilder::OpeningBookBuilder(uint32_t maxPlies, size_t shardCount)
+  : mMaxPlies(maxPlies)
+{
+  shardCount = std::max<size_t>(shardCount, 1);
+  for (size_t i = 0; i < shardCount; i++)
+  {
+    mShards.emplace_back(new Shard);
+  }
+}
+
+uint32_t OpeningBookBuilder::addGame(Board * board, const std::vector<std::string> & moves, GameResult result)
+{
+  uint32_t ply = 0;
+  for (; ply < mMaxPlies && ply < moves.size(); ply++)
+  {
+    Move move;
+    if (!findMove(board, moves[ply], move))
+    {
+      break;
+    }
+
+    // The shard is chosen by the upper bits, the map inside it uses the lower ones
+    Key key = { board->getPolyglotKey(), OpeningBook::encodeMove(&move) };
+    Shard & shard = *mShards[(key.hashKey >> 32) % mShards.size()];
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      Counts & counts = shard.counts[key];
+      if (result == GameResult::Draw)
+      {
+        counts.draws++;
+      }
+      else if ((result == GameResult::WhiteWin) == (board->getSideToMove() == Color::White))
+      {
+        counts.wins++;
+      }
+      else
+      {
+        counts.losses++;
+      }
+    }
+
+    board->makeMove(&move);
+  }
+
+  return ply;
+}
+
+void OpeningBookBuilder::clear()
+{
+  for (auto & shard : mShards)
+  {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->counts.clear();
+  }
+}
+
+bool OpeningBookBuilder::findMove(Board * board, const std::string & text, Move & move)
+{
+  // Check, mate and annotation marks
+  size_t length = text.size();
+  while (length > 0 && std::strchr("+#!?", text[length - 1]) != nullptr)
+  {
+    length--;
+  }
+  std::string san = text.substr(0, length);
+
+  bool castle = (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0");
+  Piece piece = Piece::Pawn;
+  Piece promotedPiece = Piece::None;
+  int32_t sourceRow = -1;
+  int32_t sourceColumn = -1;
+  int32_t destinationRow = -1;
+  int32_t destinationColumn = -1;
+  if (castle)
+  {
+    piece = Piece::King;
+    destinationColumn = (san.size() == 3) ? 6 : 2;
+  }
+  else
+  {
+    size_t equals = san.find('=');
+    if (equals != std::string::npos && equals + 1 < san.size())
+    {
+      promotedPiece = getPiece(san[equals + 1]);
+      san.erase(equals);
+    }
+    else if (san.size() > 2 && san[0] >= 'a' && san[0] <= 'h' && getPiece(san.back()) != Piece::None)
+    {
+      promotedPiece = getPiece(san.back());
+      san.pop_back();
+    }
+
+    if (!san.empty() && getPiece(san[0]) != Piece::None)
+    {
+      piece = getPiece(san[0]);
+      san.erase(0, 1);
+    }
+
+    // The destination comes last, anything before it tells the source apart
+    if (san.size() < 2 || san[san.size() - 2] < 'a' || san[san.size() - 2] > 'h' ||
+        san.back() < '1' || san.back() > '8')
+    {
+      return false;
+    }
+    destinationColumn = san[san.size() - 2] - 'a';
+    destinationRow = san.back() - '1';
+    for (size_t i = 0; i + 2 < san.size(); i++)
+    {
+      if (san[i] >= 'a' && san[i] <= 'h')
+      {
+        sourceColumn = san[i] - 'a';
+      }
+      else if (san[i] >= '1' && san[i] <= '8')
+      {
+        sourceRow = san[i] - '1';
+      }
+      else if (san[i] != 'x' && san[i] != '-')
+      {
+        return false;
+      }
+    }
+  }
+
+  // A move that needs telling apart from another legal move is not read
+  MoveList moveList;
+  board->generateMoves(moveList);
+  Color sideToMove = board->getSideToMove();
+  uint32_t matches = 0;
+  for (uint32_t i = 0; i < moveList.size() && matches < 2; i++)
+  {
+    // Only promotions carry a promoted piece, en passant captures store a pawn
+    const Move * candidate = moveList[i];
+    bool promotion = candidate->isPromotion() || candidate->isPromotionCapture();
+    if (candidate->getPiece() != piece || candidate->isCastle() != castle ||
+        candidate->getDestinationColumn() != destinationColumn ||
+        (destinationRow >= 0 && candidate->getDestinationRow() != destinationRow) ||
+        (sourceRow >= 0 && candidate->getSourceRow() != sourceRow) ||
+        (sourceColumn >= 0 && candidate->getSourceColumn() != sourceColumn) ||
+        (promotion ? candidate->getPromotedPiece() : Piece::None) != promotedPiece)
+    {
+      continue;
+    }
+
+    board->makeMove(candidate);
+    bool legal = !board->isCellAttacked(board->getKingRow(sideToMove), board->getKingColumn(sideToMove), !sideToMove);
+    board->unmakeMove(candidate);
+    if (legal)
+    {
+      move = *candidate;
+      matches++;
+    }
+  }
+
+  return matches == 1;
+}
+
+size_t OpeningBookBuilder::getEntryCount() const
+{
+  size_t count = 0;
+  for (const auto & shard : mShards)
+  {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    count += shard->counts.size();
+  }
+  return count;
+}
+
+size_t OpeningBookBuilder::save(const std::string & fileName, uint32_t minGames) const
+{
+  struct Record
+  {
+    uint64_t hashKey;
+    uint16_t move;
+    uint64_t weight;
+  };
+
+  std::vector<Record> records;
+  for (const auto & shard : mShards)
+  {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    for (const auto & item : shard->counts)
+    {
+      const Counts & counts = item.second;
+      uint64_t weight = 2 * static_cast<uint64_t>(counts.wins) + counts.draws;
+      if (counts.wins + counts.draws + counts.losses >= minGames && weight > 0)
+      {
+        records.push_back({ item.first.hashKey, item.first.move, weight });
+      }
+    }
+  }
+
+  // Sorted by key for the binary search, the best move of a position first
+  std::sort(records.begin(), records.end(), [](const Record & first, const Record & second)
+  {
+    if (first.hashKey != second.hashKey)
+    {
+      return first.hashKey < second.hashKey;
+    }
+    return (first.weight != second.weight) ? first.weight > second.weight : first.move < second.move;
+  });
+
+  std::ofstream outputStream(fileName, std::ios::binary);
+  if (!outputStream)
+  {
+    return 0;
+  }
+
+  std::vector<char> buffer;
+  buffer.reserve(OpeningBook::ENTRY_SIZE * 4096);
+  for (size_t first = 0; first < records.size(); )
+  {
+    // The best move of the position has the largest weight
+    uint64_t maxWeight = records[first].weight;
+    size_t last = first;
+    for (; last < records.size() && records[last].hashKey == records[first].hashKey; last++)
+    {
+      // A scaled weight never drops to zero
+      uint64_t weight = records[last].weight;
+      if (maxWeight > UINT16_MAX)
+      {
+        weight = std::max<uint64_t>(weight * UINT16_MAX / maxWeight, 1);
+      }
+
+      char entry[OpeningBook::ENTRY_SIZE];
+      writeBigEndian(entry, records[last].hashKey, 8);
+      writeBigEndian(entry + 8, records[last].move, 2);
+      writeBigEndian(entry + 10, weight, 2);
+      writeBigEndian(entry + 12, 0, 4);
+      buffer.insert(buffer.end(), entry, entry + sizeof(entry));
+    }
+    first = last;
+
+    if (buffer.size() >= OpeningBook::ENTRY_SIZE * 4096)
+    {
+      outputStream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      buffer.clear();
+    }
+  }
+  outputStream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+  return outputStream ? records.size() : 0;
+}
+
+}
@@ -0,0 +1,185 @@
+/*!
+ * \file jcl_openingbookbuilder.h
+ *
+ * This file contains the interface for the OpeningBookBuilder object
+ */
+
+#ifndef JCL_OPENINGBOOKBUILDER_H
+#define JCL_OPENINGBOOKBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jcl_move.h"
+
+namespace jcl
+{
+
+class Board;
+
+/*!
+ * \brief Defines the building of an opening book from games
+ *
+ * The OpeningBookBuilder object plays the moves of games on a board
+ * and counts, for each position and move, the games the side to move
+ * won, drew and lost. Only the first plies of each game are counted,
+ * where the book is used. Moves are read in standard algebraic
+ * notation, as found in PGN files.
+ *
+ * The counts are kept in a hash map split into shards by the key of
+ * the position, each with its own lock, so several threads can add
+ * games at once, each with its own board, and rarely wait for each
+ * other.
+ *
+ * The book is saved in the format read by the \ref OpeningBook, sorted
+ * by key. The weight of a move is twice its wins plus its draws, so
+ * the book plays moves in proportion to the points they scored.
+ */
+class OpeningBookBuilder
+{
+public:
+
+  /*!
+   * \brief Defines the result of a game
+   */
+  enum class GameResult
+  {
+    WhiteWin = 0, /*!< Defines a win for white */
+    Draw = 1,     /*!< Defines a draw */
+    BlackWin = 2  /*!< Defines a win for black */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs an empty OpeningBookBuilder object.
+   *
+   * \param maxPlies The number of plies counted from each game
+   * \param shardCount The number of shards of the hash map
+   */
+  OpeningBookBuilder(uint32_t maxPlies = 24, size_t shardCount = 256);
+
+  OpeningBookBuilder(const OpeningBookBuilder &) = delete;
+  OpeningBookBuilder & operator=(const OpeningBookBuilder &) = delete;
+
+  /*!
+   * \brief Adds the moves of a game
+   *
+   * The moves are played from the position on the board, up to the
+   * number of plies counted or the first move that cannot be read or
+   * is not legal. This function may be called from several threads,
+   * each with its own board.
+   *
+   * \param board The board, holding the starting position of the game
+   * \param moves The moves of the game, in standard algebraic notation
+   * \param result The result of the game
+   *
+   * \return The number of plies counted
+   */
+  uint32_t addGame(Board * board, const std::vector<std::string> & moves, GameResult result);
+
+  /*!
+   * \brief Removes all counts
+   */
+  void clear();
+
+  /*!
+   * \brief Finds the legal move written in standard algebraic notation
+   *
+   * Check, mate and annotation marks are ignored, and castling may be
+   * written with letters or zeros.
+   *
+   * \param board The board, which is restored before returning
+   * \param text The move, such as "Nbd7", "exd8=Q+" or "O-O"
+   * \param move Receives the move
+   *
+   * \return true if the text is a legal move, false if it is not or is ambiguous
+   */
+  static bool findMove(Board * board, const std::string & text, Move & move);
+
+  /*!
+   * \brief Returns the number of distinct positions and moves counted
+   *
+   * \return The number of positions and moves
+   */
+  size_t getEntryCount() const;
+
+  /*!
+   * \brief Returns the number of plies counted from each game
+   *
+   * \return The number of plies
+   */
+  uint32_t getMaxPlies() const;
+
+  /*!
+   * \brief Saves the book
+   *
+   * Moves with fewer games than the minimum, or that scored no
+   * points, are left out. The weights of a position are scaled down
+   * together when the largest does not fit in 16 bits.
+   *
+   * \param fileName The name of the file
+   * \param minGames The minimum number of games of a move
+   *
+   * \return The number of entries saved, or zero if the file cannot be written
+   */
+  size_t save(const std::string & fileName, uint32_t minGames = 1) const;
+
+private:
+
+  // A position and a move
+  struct Key
+  {
+    uint64_t hashKey;
+    uint16_t move;
+
+    bool operator==(const Key & other) const
+    {
+      return hashKey == other.hashKey && move == other.move;
+    }
+  };
+
+  // Hashes a key, the position key being random already
+  struct KeyHash
+  {
+    size_t operator()(const Key & key) const
+    {
+      return static_cast<size_t>(key.hashKey ^ (static_cast<uint64_t>(key.move) * 0x9e3779b97f4a7c15ULL));
+    }
+  };
+
+  // Games won, drawn and lost by the side to move
+  struct Counts
+  {
+    uint32_t wins = 0;
+    uint32_t draws = 0;
+    uint32_t losses = 0;
+  };
+
+  // A part of the hash map with its lock
+  struct Shard
+  {
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Counts, KeyHash> counts;
+  };
+
+private:
+  uint32_t mMaxPlies;                           // Plies counted from each game
+  std::vector<std::unique_ptr<Shard>> mShards;  // Counts, split by position key
+};
+
+inline uint32_t OpeningBookBuilder::getMaxPlies() const
+{
+  return mMaxPlies;
+}
+
+}
+
+#endif // #ifndef JCL_OPENINGBOOKBUILDER_H
@@ -0,0 +1,49 @@
+/*!
+ * \file jcl_pawntable.cpp
+ *
+ * This file contains the implementation for the PawnTable object
+ */
+
+#include "jcl_pawntable.h"
+
+namespace jcl
+{
+
+PawnTable::PawnTable(size_t entryCount)
+  : mEntryCount(1)
+  , mHits(0)
+  , mProbes(0)
+{
+  // The entry count is a power of two so the index is a mask of the key
+  while (mEntryCount * 2 <= entryCount)
+  {
+    mEntryCount *= 2;
+  }
+
+  mEntries.reset(new Entry[mEntryCount]);
+  clear();
+}
+
+void PawnTable::clear()
+{
+  // An empty entry matches the key of a board without pawns, which
+  // is correct since such a board has no pawns and no pawn score
+  for (size_t i = 0; i < mEntryCount; i++)
+  {
+    mEntries[i] = Entry();
+  }
+  clearStatistics();
+}
+
+void PawnTable::clearStatistics()
+{
+  mHits = 0;
+  mProbes = 0;
+}
+
+double PawnTable::getHitRate() const
+{
+  return (mProbes == 0) ? 0.0 : (100.0 * static_cast<double>(mHits) / static_cast<double>(mProbes));
+}
+
+}
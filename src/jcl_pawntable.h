@@ -0,0 +1,147 @@
+/*!
+ * \file jcl_pawntable.h
+ *
+ * This file contains the interface for the PawnTable object
+ */
+
+#ifndef JCL_PAWNTABLE_H
+#define JCL_PAWNTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines a table of pawn structure evaluations
+ *
+ * The PawnTable object caches the evaluation of pawn structures,
+ * indexed by the pawn hash key of the board. Pawns move rarely
+ * compared to the other pieces, so most positions visited by a
+ * search share their pawn structure with a position evaluated
+ * earlier and the cached result can be reused.
+ *
+ * Each entry also keeps the pawn bitboards, so that terms that
+ * depend on other pieces, such as king shelter, can be computed
+ * from the cached entry without scanning the board.
+ *
+ * The table counts probes and hits to measure its hit rate. It is
+ * not shared between threads, each evaluation owns its own table.
+ */
+class PawnTable
+{
+public:
+
+  /*!
+   * \brief Defines the contents of an entry
+   */
+  struct Entry
+  {
+    uint64_t key;         /*!< The pawn hash key */
+    uint64_t pawns[2];    /*!< The pawns of each color, indexed by Color */
+    uint64_t passed[2];   /*!< The passed pawns of each color, indexed by Color */
+    Score score;          /*!< The pawn structure score from the point of view of white */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a PawnTable object with the specified
+   * number of entries, rounded down to a power of two.
+   *
+   * \param entryCount The number of entries
+   */
+  PawnTable(size_t entryCount = 16384);
+
+  /*!
+   * \brief Clears the table and its statistics
+   */
+  void clear();
+
+  /*!
+   * \brief Clears the probe and hit counts
+   */
+  void clearStatistics();
+
+  /*!
+   * \brief Returns the number of entries
+   *
+   * \return The number of entries
+   */
+  size_t getEntryCount() const;
+
+  /*!
+   * \brief Returns the number of probes that found their pawn structure
+   *
+   * \return The number of hits
+   */
+  uint64_t getHits() const;
+
+  /*!
+   * \brief Returns the hit rate
+   *
+   * \return The percentage of probes that were hits, or zero if there were no probes
+   */
+  double getHitRate() const;
+
+  /*!
+   * \brief Returns the number of probes
+   *
+   * \return The number of probes
+   */
+  uint64_t getProbes() const;
+
+  /*!
+   * \brief Looks up a pawn structure
+   *
+   * This function returns the entry for the pawn hash key. When the
+   * entry holds a different pawn structure the caller is expected
+   * to evaluate the pawns and fill in the entry, including its key.
+   *
+   * \param key The pawn hash key
+   * \param found Set to true if the entry holds the pawn structure, false otherwise
+   *
+   * \return The entry for the key
+   */
+  Entry * probe(uint64_t key, bool & found);
+
+private:
+  size_t mEntryCount;
+  uint64_t mHits;
+  uint64_t mProbes;
+  std::unique_ptr<Entry[]> mEntries;
+};
+
+inline size_t PawnTable::getEntryCount() const
+{
+  return mEntryCount;
+}
+
+inline uint64_t PawnTable::getHits() const
+{
+  return mHits;
+}
+
+inline uint64_t PawnTable::getProbes() const
+{
+  return mProbes;
+}
+
+inline PawnTable::Entry * PawnTable::probe(uint64_t key, bool & found)
+{
+  Entry * entry = &mEntries[key & (mEntryCount - 1)];
+  found = (entry->key == key);
+  mProbes++;
+  mHits += found ? 1 : 0;
+  return entry;
+}
+
+}
+
+#endif // #ifndef JCL_PAWNTABLE_H
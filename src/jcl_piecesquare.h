@@ -0,0 +1,279 @@
+/*!
+ * \file jcl_piecesquare.h
+ *
+ * This file contains the interface for the PieceSquare object
+ */
+
+#ifndef JCL_PIECESQUARE_H
+#define JCL_PIECESQUARE_H
+
+#include <cstdint>
+
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines the table of piece-square values
+ *
+ * Each value packs a midgame and an endgame score (see \ref Score)
+ * made of the material weight of a piece plus the bonus for the
+ * square it stands on. Values are signed so that white pieces count
+ * positively and black pieces negatively. The square tables are laid
+ * out as seen from white, with the eighth rank first, and are
+ * mirrored for black. The king has no material weight since both
+ * kings are always on the board.
+ *
+ * Each piece also has a phase weight. The sum of the weights of the
+ * pieces on the board measures how far the game is from the endgame.
+ */
+struct PieceSquareValues
+{
+  static constexpr int32_t PAWN_WEIGHT_MG = 100;
+  static constexpr int32_t PAWN_WEIGHT_EG = 120;
+  static constexpr int32_t KNIGHT_WEIGHT_MG = 300;
+  static constexpr int32_t KNIGHT_WEIGHT_EG = 290;
+  static constexpr int32_t BISHOP_WEIGHT_MG = 350;
+  static constexpr int32_t BISHOP_WEIGHT_EG = 340;
+  static constexpr int32_t ROOK_WEIGHT_MG = 500;
+  static constexpr int32_t ROOK_WEIGHT_EG = 530;
+  static constexpr int32_t QUEEN_WEIGHT_MG = 950;
+  static constexpr int32_t QUEEN_WEIGHT_EG = 960;
+
+  static constexpr int32_t PawnMidgameValue[64] =
+  {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     20,  20,  25,  30,  30,  25,  20,  20,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   5,  20,  20,   5,   0,   0,
+      5,   0,   0,   5,   5,   0,   0,   5,
+      5,  10,  10, -15, -15,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+  };
+
+  static constexpr int32_t PawnEndgameValue[64] =
+  {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     90,  90,  90,  90,  90,  90,  90,  90,
+     60,  60,  60,  60,  60,  60,  60,  60,
+     35,  35,  35,  35,  35,  35,  35,  35,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0
+  };
+
+  static constexpr int32_t KnightMidgameValue[64] =
+  {
+    -40, -30, -20, -20, -20, -20, -30, -40,
+    -30, -10,   0,   5,   5,   0, -10, -30,
+    -20,   5,  15,  20,  20,  15,   5, -20,
+    -20,   5,  20,  30,  30,  20,   5, -20,
+    -20,   0,  20,  30,  30,  20,   0, -20,
+    -20,   0,  10,  15,  15,  10,   0, -20,
+    -30, -10,   0,   0,   0,   0, -10, -30,
+    -40, -30, -20, -20, -20, -20, -30, -40
+  };
+
+  static constexpr int32_t KnightEndgameValue[64] =
+  {
+    -40, -30, -20, -20, -20, -20, -30, -40,
+    -30, -10,   0,   0,   0,   0, -10, -30,
+    -20,   0,  10,  15,  15,  10,   0, -20,
+    -20,   0,  15,  20,  20,  15,   0, -20,
+    -20,   0,  15,  20,  20,  15,   0, -20,
+    -20,   0,  10,  15,  15,  10,   0, -20,
+    -30, -10,   0,   0,   0,   0, -10, -30,
+    -40, -30, -20, -20, -20, -20, -30, -40
+  };
+
+  static constexpr int32_t BishopMidgameValue[64] =
+  {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+  };
+
+  static constexpr int32_t BishopEndgameValue[64] =
+  {
+    -15, -10, -10, -10, -10, -10, -10, -15,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -15, -10, -10, -10, -10, -10, -10, -15
+  };
+
+  static constexpr int32_t RookMidgameValue[64] =
+  {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     10,  20,  20,  20,  20,  20,  20,  10,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+  };
+
+  static constexpr int32_t RookEndgameValue[64] =
+  {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0
+  };
+
+  static constexpr int32_t QueenMidgameValue[64] =
+  {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+  };
+
+  static constexpr int32_t QueenEndgameValue[64] =
+  {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+    -10,   5,  10,  10,  10,  10,   5, -10,
+     -5,   5,  10,  15,  15,  10,   5,  -5,
+     -5,   5,  10,  15,  15,  10,   5,  -5,
+    -10,   5,  10,  10,  10,  10,   5, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+  };
+
+  static constexpr int32_t KingMidgameValue[64] =
+  {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+  };
+
+  static constexpr int32_t KingEndgameValue[64] =
+  {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+  };
+
+  Score values[13][64];  // Values indexed by PieceType and square index
+  int32_t phases[13];    // Phase weights indexed by PieceType
+
+  constexpr PieceSquareValues()
+    : values()
+    , phases()
+  {
+    for (int j = 0; j < 64; j++)
+    {
+      // Square indexes count from the first rank, the tables from the eighth
+      int k = j ^ 56;
+      values[static_cast<int>(PieceType::WhitePawn)][j] = makeScore(PAWN_WEIGHT_MG + PawnMidgameValue[k], PAWN_WEIGHT_EG + PawnEndgameValue[k]);
+      values[static_cast<int>(PieceType::WhiteRook)][j] = makeScore(ROOK_WEIGHT_MG + RookMidgameValue[k], ROOK_WEIGHT_EG + RookEndgameValue[k]);
+      values[static_cast<int>(PieceType::WhiteKnight)][j] = makeScore(KNIGHT_WEIGHT_MG + KnightMidgameValue[k], KNIGHT_WEIGHT_EG + KnightEndgameValue[k]);
+      values[static_cast<int>(PieceType::WhiteBishop)][j] = makeScore(BISHOP_WEIGHT_MG + BishopMidgameValue[k], BISHOP_WEIGHT_EG + BishopEndgameValue[k]);
+      values[static_cast<int>(PieceType::WhiteQueen)][j] = makeScore(QUEEN_WEIGHT_MG + QueenMidgameValue[k], QUEEN_WEIGHT_EG + QueenEndgameValue[k]);
+      values[static_cast<int>(PieceType::WhiteKing)][j] = makeScore(KingMidgameValue[k], KingEndgameValue[k]);
+    }
+
+    // Black pieces use the mirrored square with the opposite sign
+    for (int i = 1; i <= 6; i++)
+    {
+      for (int j = 0; j < 64; j++)
+      {
+        values[i + 6][j] = -values[i][j ^ 56];
+      }
+    }
+
+    phases[static_cast<int>(PieceType::WhiteKnight)] = phases[static_cast<int>(PieceType::BlackKnight)] = 1;
+    phases[static_cast<int>(PieceType::WhiteBishop)] = phases[static_cast<int>(PieceType::BlackBishop)] = 1;
+    phases[static_cast<int>(PieceType::WhiteRook)] = phases[static_cast<int>(PieceType::BlackRook)] = 2;
+    phases[static_cast<int>(PieceType::WhiteQueen)] = phases[static_cast<int>(PieceType::BlackQueen)] = 4;
+  }
+};
+
+/*!
+ * \brief Defines an object for looking up piece-square values
+ *
+ * The PieceSquare object provides the combined material and
+ * piece-square value of a piece on a square, and its phase weight.
+ * The board keeps the sums of these for all its pieces up to date
+ * as moves are made and unmade, in the same way as its hash key, so
+ * the evaluation does not need to visit every square.
+ */
+class PieceSquare
+{
+public:
+
+  /*!
+   * \brief The phase of the starting position
+   *
+   * The phase of a position can exceed this value after promotions.
+   */
+  static constexpr int32_t MAX_PHASE = 24;
+
+  /*!
+   * \brief Returns the phase weight of a piece
+   *
+   * \param pieceType The type of piece
+   *
+   * \return The phase weight, zero for pawns and kings
+   */
+  static int32_t getPhase(PieceType pieceType);
+
+  /*!
+   * \brief Returns the value of a piece on a square
+   *
+   * \param pieceType The type of piece, PieceType::None has no value
+   * \param row The row of the square
+   * \param col The column of the square
+   *
+   * \return The packed value of the piece, positive for white and negative for black
+   */
+  static Score getValue(PieceType pieceType, uint8_t row, uint8_t col);
+
+private:
+  static constexpr PieceSquareValues mValues{};
+};
+
+inline int32_t PieceSquare::getPhase(PieceType pieceType)
+{
+  return mValues.phases[static_cast<int>(pieceType)];
+}
+
+inline Score PieceSquare::getValue(PieceType pieceType, uint8_t row, uint8_t col)
+{
+  return mValues.values[static_cast<int>(pieceType)][(row << 3) + col];
+}
+
+}
+
+#endif // #ifndef JCL_PIECESQUARE_H
@@ -0,0 +1,103 @@
+/*!
+ * \file jcl_polyglot.h
+ *
+ * This file contains the interface for the Polyglot object
+ */
+
+#ifndef JCL_POLYGLOT_H
+#define JCL_POLYGLOT_H
+
+#include <cstdint>
+
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines the Polyglot opening book keys
+ *
+ * The Polyglot object provides the fixed random keys of the Polyglot
+ * book format, so positions are keyed the same way as in the books
+ * written by other programs. The key of a position is composed like
+ * the Zobrist hash, with two differences: the side key is included
+ * when white is to move, and the en-passant key is only included
+ * when a pawn of the side to move can capture en-passant.
+ */
+class Polyglot
+{
+public:
+
+  static constexpr uint32_t KEY_COUNT = 781;  /*!< The number of keys in the Polyglot random table */
+
+  /*!
+   * \brief Returns the key for a set of castling rights
+   *
+   * \param castlingRights The castling rights
+   *
+   * \return The key for the castling rights
+   */
+  static uint64_t getCastlingKey(uint8_t castlingRights);
+
+  /*!
+   * \brief Returns the key for an en-passant column
+   *
+   * The key for Board::INVALID_ENPASSANT_COLUMN is zero. The
+   * caller decides whether the capture is possible.
+   *
+   * \param column The en-passant column
+   *
+   * \return The key for the en-passant column
+   */
+  static uint64_t getEnPassantKey(uint8_t column);
+
+  /*!
+   * \brief Returns the key for a piece on a square
+   *
+   * The key for PieceType::None is zero.
+   *
+   * \param pieceType The piece type
+   * \param row The row of the square
+   * \param col The column of the square
+   *
+   * \return The key for the piece on the square
+   */
+  static uint64_t getPieceKey(PieceType pieceType, uint8_t row, uint8_t col);
+
+  /*!
+   * \brief Returns the side to move key
+   *
+   * This key is included in the key when white is to move.
+   *
+   * \return The side to move key
+   */
+  static uint64_t getSideKey();
+
+private:
+  static const uint64_t mRandom[KEY_COUNT];  // The Polyglot random table
+  static const uint32_t mPieceOffsets[13];   // Offset of the keys for each PieceType
+};
+
+inline uint64_t Polyglot::getEnPassantKey(uint8_t column)
+{
+  return (column < 8) ? mRandom[772 + column] : 0;
+}
+
+inline uint64_t Polyglot::getPieceKey(PieceType pieceType, uint8_t row, uint8_t col)
+{
+  if (pieceType == PieceType::None)
+  {
+    return 0;
+  }
+
+  return mRandom[mPieceOffsets[static_cast<int>(pieceType)] + (row << 3) + col];
+}
+
+inline uint64_t Polyglot::getSideKey()
+{
+  return mRandom[780];
+}
+
+}
+
+#endif // #ifndef JCL_POLYGLOT_H
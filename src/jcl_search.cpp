@@ -0,0 +1,806 @@
+/*!
+ * \file jcl_search.cpp
+ *
+ * This file contains the implementation for the Search object
+ */
+
+#include "jcl_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "jcl_bitboard.h"
+#include "jcl_evaluationcache.h"
+#include "jcl_materialtable.h"
+#include "jcl_movelist.h"
+#include "jcl_tablebase.h"
+#include "jcl_timemanager.h"
+#include "jcl_transpositiontable.h"
+
+namespace jcl
+{
+
+#define getIndex(row,col) (((row)<<3)+(col))
+
+// History scores are halved when any score exceeds this value
+constexpr int32_t MAX_HISTORY = 16384;
+
+// Returns whether two moves have the same squares and promotion
+static bool isSameMove(const Move * move1, const Move * move2)
+{
+  return (move1->getSourceRow() == move2->getSourceRow() &&
+          move1->getSourceColumn() == move2->getSourceColumn() &&
+          move1->getDestinationRow() == move2->getDestinationRow() &&
+          move1->getDestinationColumn() == move2->getDestinationColumn() &&
+          move1->getPromotedPiece() == move2->getPromotedPiece());
+}
+
+// Piece values used for move ordering, indexed by Piece
+static const int32_t OrderValue[] =
+{
+  0,      // None
+  10000,  // King
+  900,    // Queen
+  500,    // Rook
+  330,    // Bishop
+  320,    // Knight
+  100     // Pawn
+};
+
+Search::Search(Board * board, Evaluation * evaluation)
+  : mFollowPv(false)
+  , mLazyEvaluation(true)
+  , mNullMove(true)
+  , mQuietChecks(false)
+  , mStopped(false)
+  , mCheckCountdown(0)
+  , mSelectiveDepth(0)
+  , mMultiPv(1)
+  , mPreviousPvLength(0)
+  , mRootPly(0)
+  , mNodes(0)
+  , mNodeLimit(0)
+  , mQuiescenceNodes(0)
+  , mStopFlag(nullptr)
+  , mBoard(board)
+  , mBitBoard(board->getBitBoard())
+  , mEvaluation(evaluation)
+  , mEvaluationCache(nullptr)
+  , mEvaluationCacheHits(0)
+  , mEvaluationCacheProbes(0)
+  , mTablebase(nullptr)
+  , mTablebaseHits(0)
+  , mTimeManager(nullptr)
+  , mTranspositionTable(nullptr)
+{
+  std::memset(mHistory, 0, sizeof(mHistory));
+  initReductions();
+}
+
+void Search::addRootLine(const Move * move, int32_t score)
+{
+  Line line;
+  line.score = score;
+  line.moves[0] = *move;
+  line.length = std::max(mPvLength[1], 1);
+  std::copy(mPvTable[1] + 1, mPvTable[1] + line.length, line.moves + 1);
+
+  // The lines are kept sorted, best first, and trimmed to the number searched
+  auto position = std::upper_bound(mRootLines.begin(), mRootLines.end(), score,
+                                   [](int32_t value, const Line & other) { return value > other.score; });
+  mRootLines.insert(position, line);
+  if (mRootLines.size() > mMultiPv)
+  {
+    mRootLines.pop_back();
+  }
+}
+
+int32_t Search::alphaBeta(int32_t depth, int32_t ply, int32_t alpha, int32_t beta, bool allowNull)
+{
+  mPvLength[ply] = ply;
+  if (depth <= 0 || ply >= MAX_PLY)
+  {
+    return quiesce(0, ply, alpha, beta);
+  }
+
+  countNode(ply);
+  if (isStopRequested())
+  {
+    return 0;
+  }
+
+  // Draws by repetition or the fifty-move rule end the line
+  if (ply > 0 && (mBoard->isDrawByRepetition(mRootPly) || mBoard->isDrawByFiftyMove()))
+  {
+    return 0;
+  }
+
+  // Positions in the tablebase are scored as mates at their distance
+  uint8_t tablebaseValue = 0;
+  if (ply > 0 && mTablebase != nullptr && mTablebase->probe(mBoard, tablebaseValue))
+  {
+    mTablebaseHits++;
+    int32_t distance = EndgameTable::getDistance(tablebaseValue);
+    if (EndgameTable::isWin(tablebaseValue))
+    {
+      return MATE_SCORE - ply - (2 * distance - 1);
+    }
+    return EndgameTable::isLoss(tablebaseValue) ? -MATE_SCORE + ply + 2 * distance : 0;
+  }
+
+  // Stored results cut null window nodes, the principal variation is always searched
+  TranspositionTable::Data hashData;
+  bool hashHit = (mTranspositionTable != nullptr && mTranspositionTable->probe(mBoard->getHashKey(), hashData));
+  if (hashHit && ply > 0 && beta - alpha == 1 && hashData.depth >= depth)
+  {
+    int32_t score = scoreFromTable(hashData.score, ply);
+    if (hashData.bound == TranspositionTable::Bound::Exact ||
+        (hashData.bound == TranspositionTable::Bound::Lower && score >= beta) ||
+        (hashData.bound == TranspositionTable::Bound::Upper && score <= alpha))
+    {
+      return score;
+    }
+  }
+
+  bool inCheck = isInCheck();
+
+  // Null-move pruning, with a larger reduction at higher depths
+  if (mNullMove && allowNull && ply > 0 && !inCheck && depth >= 2 &&
+      beta < MATE_SCORE - MAX_PLY && hasNonPawnMaterial())
+  {
+    int32_t reduction = (depth > 6) ? 3 : 2;
+    bool followPv = mFollowPv;
+    Move nullMove = mBoard->getNullMove();
+    mBoard->makeMove(&nullMove);
+    mFollowPv = false;
+    int32_t score = -alphaBeta(depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+    mFollowPv = followPv;
+    mBoard->unmakeMove(&nullMove);
+    if (mStopped)
+    {
+      return 0;
+    }
+
+    // Mate scores found after passing are not trusted
+    if (score >= beta)
+    {
+      return (score >= MATE_SCORE - MAX_PLY) ? beta : score;
+    }
+  }
+
+  MoveList moveList;
+  mBoard->generateMoves(moveList);
+
+  // Search the principal variation of the previous iteration first, otherwise the stored move
+  const Move * firstMove = nullptr;
+  bool followPv = mFollowPv;
+  mFollowPv = false;
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    const Move * move = moveList[i];
+    if (followPv && ply < mPreviousPvLength && isSameMove(move, &mPreviousPv[ply]))
+    {
+      firstMove = move;
+      mFollowPv = true;
+      break;
+    }
+
+    if (hashHit && hashData.hasMove && firstMove == nullptr &&
+        move->getSourceRow() == hashData.sourceRow && move->getSourceColumn() == hashData.sourceColumn &&
+        move->getDestinationRow() == hashData.destinationRow && move->getDestinationColumn() == hashData.destinationColumn &&
+        move->getPromotedPiece() == hashData.promotedPiece)
+    {
+      firstMove = move;
+    }
+  }
+
+  uint8_t order[256];
+  orderMoves(moveList, order, firstMove);
+
+  int32_t originalAlpha = alpha;
+  int32_t bestScore = -INFINITE_SCORE;
+  const Move * bestMove = nullptr;
+  uint32_t legalMoves = 0;
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    const Move * move = moveList[order[i]];
+
+    bool quiet = !move->isCapture() && !move->isPromotion();
+    bool goodHistory = quiet && getHistory(move) >= mParameters.historyThreshold;
+
+    mBoard->makeMove(move);
+    if (isLastMoveIllegal())
+    {
+      mBoard->unmakeMove(move);
+      continue;
+    }
+
+    legalMoves++;
+    bool givesCheck = isInCheck();
+    bool lateQuiet = quiet && !inCheck && !givesCheck && !goodHistory && ply > 0;
+
+    // Late move pruning, once a line that avoids mate has been found
+    if (lateQuiet && mParameters.lmpEnabled && depth <= mParameters.lmpMaxDepth &&
+        static_cast<int32_t>(legalMoves) > mParameters.lmpBase + depth * depth &&
+        bestScore > -MATE_SCORE + MAX_PLY)
+    {
+      mBoard->unmakeMove(move);
+      continue;
+    }
+
+    // Late move reductions, with a full depth search if the reduced search beats alpha
+    int32_t score = 0;
+    int32_t reduction = 0;
+    if (lateQuiet && mParameters.lmrEnabled && depth >= mParameters.lmrMinDepth &&
+        static_cast<int32_t>(legalMoves) > mParameters.lmrMinMoves)
+    {
+      reduction = mReductions[std::min(depth, 63)][std::min(legalMoves, 63u)];
+      reduction = std::max(0, std::min(reduction, depth - 2));
+    }
+
+    // Principal variation search, later moves are searched with a null window
+    if (legalMoves == 1)
+    {
+      score = -alphaBeta(depth - 1, ply + 1, -beta, -alpha, true);
+    }
+    else
+    {
+      score = -alphaBeta(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, true);
+      if (score > alpha && reduction > 0)
+      {
+        score = -alphaBeta(depth - 1, ply + 1, -alpha - 1, -alpha, true);
+      }
+
+      if (score > alpha && score < beta)
+      {
+        score = -alphaBeta(depth - 1, ply + 1, -beta, -alpha, true);
+      }
+    }
+    mBoard->unmakeMove(move);
+
+    // The score of an aborted search is not used
+    if (mStopped)
+    {
+      return 0;
+    }
+
+    // With several lines alpha is the score of the worst line kept, so
+    // every root move that enters the lines gets an exact score
+    if (ply == 0 && mMultiPv > 1)
+    {
+      if (score > alpha)
+      {
+        addRootLine(move, score);
+        if (mRootLines.size() >= mMultiPv)
+        {
+          alpha = std::max(alpha, mRootLines.back().score);
+        }
+      }
+
+      if (score > bestScore)
+      {
+        bestScore = score;
+        bestMove = move;
+        updatePrincipalVariation(move, ply);
+      }
+      continue;
+    }
+
+    if (score > bestScore)
+    {
+      bestScore = score;
+      if (score > alpha)
+      {
+        alpha = score;
+        bestMove = move;
+        updatePrincipalVariation(move, ply);
+        if (alpha >= beta)
+        {
+          if (quiet)
+          {
+            updateHistory(move, depth);
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  if (legalMoves == 0)
+  {
+    return inCheck ? -MATE_SCORE + ply : 0;
+  }
+
+  if (mTranspositionTable != nullptr)
+  {
+    TranspositionTable::Bound bound = TranspositionTable::Bound::Exact;
+    if (bestScore <= originalAlpha)
+    {
+      bound = TranspositionTable::Bound::Upper;
+    }
+    else if (bestScore >= beta)
+    {
+      bound = TranspositionTable::Bound::Lower;
+    }
+    mTranspositionTable->store(mBoard->getHashKey(), depth, scoreToTable(bestScore, ply), bound, bestMove);
+  }
+
+  return bestScore;
+}
+
+int32_t Search::aspirationSearch(int32_t depth, int32_t previousScore, bool useWindow)
+{
+  // Aspiration window around the previous score, widened after each failure
+  int32_t delta = mParameters.aspirationWindow;
+  int32_t alpha = -INFINITE_SCORE;
+  int32_t beta = INFINITE_SCORE;
+  if (useWindow && delta > 0 && std::abs(previousScore) < MATE_SCORE - MAX_PLY)
+  {
+    alpha = std::max(previousScore - delta, -INFINITE_SCORE);
+    beta = std::min(previousScore + delta, INFINITE_SCORE);
+  }
+
+  for (;;)
+  {
+    mFollowPv = true;
+    int32_t score = alphaBeta(depth, 0, alpha, beta, false);
+    if (mStopped)
+    {
+      return 0;
+    }
+
+    if (score <= alpha && alpha > -INFINITE_SCORE)
+    {
+      alpha = std::max(score - delta, -INFINITE_SCORE);
+    }
+    else if (score >= beta && beta < INFINITE_SCORE)
+    {
+      beta = std::min(score + delta, INFINITE_SCORE);
+    }
+    else
+    {
+      return score;
+    }
+    delta *= 2;
+  }
+}
+
+void Search::clearStatistics()
+{
+  mNodes.store(0, std::memory_order_relaxed);
+  mQuiescenceNodes = 0;
+  mSelectiveDepth = 0;
+  mEvaluationCacheHits = 0;
+  mEvaluationCacheProbes = 0;
+  mTablebaseHits = 0;
+}
+
+int32_t Search::evaluate(int32_t alpha, int32_t beta)
+{
+  // The cache holds complete scores from the point of view of white, as evaluated
+  bool white = (mBoard->getSideToMove() == Color::White);
+  int32_t score = 0;
+  if (mEvaluationCache != nullptr)
+  {
+    mEvaluationCacheProbes++;
+    if (mEvaluationCache->probe(mBoard->getHashKey(), score))
+    {
+      mEvaluationCacheHits++;
+      return white ? score : -score;
+    }
+  }
+
+  bool complete = true;
+  if (mLazyEvaluation && (alpha > -INFINITE_SCORE || beta < INFINITE_SCORE))
+  {
+    score = white ? mEvaluation->evaluateBoard(mBoard, alpha, beta, complete)
+                  : mEvaluation->evaluateBoard(mBoard, -beta, -alpha, complete);
+  }
+  else
+  {
+    score = mEvaluation->evaluateBoard(mBoard);
+  }
+
+  if (mEvaluationCache != nullptr && complete)
+  {
+    mEvaluationCache->store(mBoard->getHashKey(), score);
+  }
+
+  return white ? score : -score;
+}
+
+int32_t Search::execute(int32_t depth)
+{
+  clearStatistics();
+  mRootPly = mBoard->getHistorySize();
+  mStopped = false;
+  mCheckCountdown = mParameters.timeCheckInterval;
+  mBestMove = Move();
+  mLines.clear();
+  std::memset(mHistory, 0, sizeof(mHistory));
+
+  int32_t bestScore = 0;
+  for (int32_t currentDepth = 1; currentDepth <= depth; currentDepth++)
+  {
+    // An iteration that cannot complete within the soft limit is not started
+    if (mTimeManager != nullptr && currentDepth > 1 && !mTimeManager->shouldStartIteration())
+    {
+      break;
+    }
+
+    // Several lines need the full window, since their scores are spread out
+    mPreviousPvLength = mLines.empty() ? 0 : mLines[0].length;
+    for (int32_t i = 0; i < mPreviousPvLength; i++)
+    {
+      mPreviousPv[i] = mLines[0].moves[i];
+    }
+    mRootLines.clear();
+    int32_t score = aspirationSearch(currentDepth, bestScore, currentDepth > 1 && mMultiPv == 1);
+
+    // The results of the last completed iteration are kept
+    if (mStopped)
+    {
+      break;
+    }
+
+    bestScore = score;
+    if (mMultiPv == 1 || mRootLines.empty())
+    {
+      Line line;
+      line.score = score;
+      line.length = mPvLength[0];
+      std::copy(mPvTable[0], mPvTable[0] + mPvLength[0], line.moves);
+      mRootLines.assign(1, line);
+    }
+    mLines = mRootLines;
+    if (mLines[0].length > 0)
+    {
+      mBestMove = mLines[0].moves[0];
+    }
+
+    if (mIterationCallback)
+    {
+      mIterationCallback(currentDepth, bestScore);
+    }
+
+    if (mTimeManager != nullptr)
+    {
+      mTimeManager->update(currentDepth, bestScore, mBestMove);
+    }
+  }
+
+  return bestScore;
+}
+
+int32_t Search::getHistory(const Move * move) const
+{
+  uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
+  uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
+  return mHistory[static_cast<int>(mBoard->getSideToMove())][fromSquare][toSquare];
+}
+
+int32_t Search::getLineScore(uint32_t line) const
+{
+  return (line < mLines.size()) ? mLines[line].score : 0;
+}
+
+void Search::getPrincipalVariation(MoveList & moveList, uint32_t line) const
+{
+  moveList.clear();
+  if (line < mLines.size())
+  {
+    for (int32_t i = 0; i < mLines[line].length; i++)
+    {
+      moveList.addMove(mLines[line].moves[i]);
+    }
+  }
+}
+
+bool Search::hasNonPawnMaterial() const
+{
+  uint64_t materialKey = mBoard->getMaterialKey();
+  if (mBoard->getSideToMove() == Color::White)
+  {
+    return MaterialTable::getPieceCount(materialKey, PieceType::WhiteKnight) +
+           MaterialTable::getPieceCount(materialKey, PieceType::WhiteBishop) +
+           MaterialTable::getPieceCount(materialKey, PieceType::WhiteRook) +
+           MaterialTable::getPieceCount(materialKey, PieceType::WhiteQueen) > 0;
+  }
+
+  return MaterialTable::getPieceCount(materialKey, PieceType::BlackKnight) +
+         MaterialTable::getPieceCount(materialKey, PieceType::BlackBishop) +
+         MaterialTable::getPieceCount(materialKey, PieceType::BlackRook) +
+         MaterialTable::getPieceCount(materialKey, PieceType::BlackQueen) > 0;
+}
+
+void Search::initReductions()
+{
+  for (int32_t depth = 0; depth < 64; depth++)
+  {
+    for (int32_t moveNumber = 0; moveNumber < 64; moveNumber++)
+    {
+      double reduction = 0.0;
+      if (depth > 0 && moveNumber > 0)
+      {
+        reduction = mParameters.lmrBase + std::log(depth) * std::log(moveNumber) / mParameters.lmrDivisor;
+      }
+      mReductions[depth][moveNumber] = static_cast<uint8_t>(std::max(0.0, reduction));
+    }
+  }
+}
+
+bool Search::isInCheck() const
+{
+  Color side = mBoard->getSideToMove();
+  return mBoard->isCellAttacked(mBoard->getKingRow(side), mBoard->getKingColumn(side), !side);
+}
+
+bool Search::isLastMoveIllegal() const
+{
+  Color side = mBoard->getSideToMove();
+  return mBoard->isCellAttacked(mBoard->getKingRow(!side), mBoard->getKingColumn(!side), side);
+}
+
+bool Search::isStopRequested()
+{
+  if (mStopped)
+  {
+    return true;
+  }
+
+  // The search is never stopped before a best move is known
+  if (!mLines.empty())
+  {
+    if (mStopFlag != nullptr && mStopFlag->load(std::memory_order_relaxed))
+    {
+      mStopped = true;
+    }
+
+    if (mNodeLimit > 0 && getNodes() >= mNodeLimit)
+    {
+      mStopped = true;
+    }
+
+    // The clock is only read every few nodes
+    if (mTimeManager != nullptr && --mCheckCountdown <= 0)
+    {
+      mCheckCountdown = mParameters.timeCheckInterval;
+      mStopped = mStopped || mTimeManager->shouldStopSearch();
+    }
+  }
+
+  return mStopped;
+}
+
+void Search::orderMoves(const MoveList & moveList, uint8_t * order, const Move * firstMove) const
+{
+  int32_t scores[256];
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    const Move * move = moveList[i];
+    int32_t score = 0;
+    if (move->isCapture())
+    {
+      score += OrderValue[static_cast<int>(move->getCapturedPiece())] * 16;
+      score -= OrderValue[static_cast<int>(move->getPiece())] / 10;
+      score += 100000;
+    }
+
+    if (move->isPromotion() || move->isPromotionCapture())
+    {
+      score += OrderValue[static_cast<int>(move->getPromotedPiece())] * 16;
+      score += 100000;
+    }
+
+    if (score == 0)
+    {
+      score = getHistory(move);
+    }
+
+    if (move == firstMove)
+    {
+      score = INFINITE_SCORE;
+    }
+
+    scores[i] = score;
+    order[i] = static_cast<uint8_t>(i);
+  }
+
+  // Insertion sort, the lists are short and mostly quiet
+  for (uint32_t i = 1; i < moveList.size(); i++)
+  {
+    int32_t score = scores[i];
+    uint8_t index = order[i];
+    uint32_t j = i;
+    while (j > 0 && scores[j-1] < score)
+    {
+      scores[j] = scores[j-1];
+      order[j] = order[j-1];
+      j--;
+    }
+    scores[j] = score;
+    order[j] = index;
+  }
+}
+
+int32_t Search::quiesce(int32_t qply, int32_t ply, int32_t alpha, int32_t beta)
+{
+  countNode(ply);
+  mQuiescenceNodes++;
+  if (isStopRequested())
+  {
+    return 0;
+  }
+
+  if (ply >= MAX_PLY)
+  {
+    return evaluate();
+  }
+
+  // When in check standing pat is not an option, so all evasions are searched
+  bool inCheck = isInCheck();
+  bool quietChecks = (!inCheck && mQuietChecks && qply == 0);
+
+  int32_t bestScore = -INFINITE_SCORE;
+  if (!inCheck)
+  {
+    bestScore = evaluate(alpha, beta);
+    if (bestScore >= beta)
+    {
+      return bestScore;
+    }
+
+    if (bestScore > alpha)
+    {
+      alpha = bestScore;
+    }
+  }
+
+  MoveList moveList;
+  if (inCheck || quietChecks)
+  {
+    mBoard->generateMoves(moveList);
+  }
+  else
+  {
+    mBoard->generateCaptures(moveList);
+  }
+
+  uint8_t order[256];
+  orderMoves(moveList, order, nullptr);
+
+  uint32_t legalMoves = 0;
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    const Move * move = moveList[order[i]];
+    bool tactical = (move->isCapture() || move->isPromotion());
+
+    // Losing captures cannot raise the score above stand pat
+    if (!inCheck && mBitBoard != nullptr && tactical && !mBitBoard->seeGE(move, 0))
+    {
+      continue;
+    }
+
+    mBoard->makeMove(move);
+    if (isLastMoveIllegal())
+    {
+      mBoard->unmakeMove(move);
+      continue;
+    }
+
+    legalMoves++;
+    if (quietChecks && !tactical && !isInCheck())
+    {
+      mBoard->unmakeMove(move);
+      continue;
+    }
+
+    int32_t score = -quiesce(qply + 1, ply + 1, -beta, -alpha);
+    mBoard->unmakeMove(move);
+    if (mStopped)
+    {
+      return 0;
+    }
+
+    if (score > bestScore)
+    {
+      bestScore = score;
+      if (score > alpha)
+      {
+        alpha = score;
+        if (alpha >= beta)
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  if (inCheck && legalMoves == 0)
+  {
+    return -MATE_SCORE + ply;
+  }
+
+  return bestScore;
+}
+
+int32_t Search::scoreFromTable(int32_t score, int32_t ply)
+{
+  if (score >= MATE_SCORE - MAX_PLY)
+  {
+    return score - ply;
+  }
+
+  if (score <= -MATE_SCORE + MAX_PLY)
+  {
+    return score + ply;
+  }
+
+  return score;
+}
+
+int32_t Search::scoreToTable(int32_t score, int32_t ply)
+{
+  // Mate scores are stored relative to the position rather than the root
+  if (score >= MATE_SCORE - MAX_PLY)
+  {
+    return score + ply;
+  }
+
+  if (score <= -MATE_SCORE + MAX_PLY)
+  {
+    return score - ply;
+  }
+
+  return score;
+}
+
+bool Search::setParameters(const Parameters & parameters)
+{
+  // A reduced search must still leave at least one ply
+  if (parameters.lmrMinDepth < 2)
+  {
+    return false;
+  }
+
+  mParameters = parameters;
+  initReductions();
+  return true;
+}
+
+void Search::updateHistory(const Move * move, int32_t depth)
+{
+  uint8_t fromSquare = getIndex(move->getSourceRow(), move->getSourceColumn());
+  uint8_t toSquare = getIndex(move->getDestinationRow(), move->getDestinationColumn());
+  int32_t & history = mHistory[static_cast<int>(mBoard->getSideToMove())][fromSquare][toSquare];
+  history += depth * depth;
+
+  // Age all scores so recent cutoffs outweigh old ones
+  if (history > MAX_HISTORY)
+  {
+    for (int32_t i = 0; i < 2; i++)
+    {
+      for (int32_t j = 0; j < 64; j++)
+      {
+        for (int32_t k = 0; k < 64; k++)
+        {
+          mHistory[i][j][k] /= 2;
+        }
+      }
+    }
+  }
+}
+
+void Search::updatePrincipalVariation(const Move * move, int32_t ply)
+{
+  mPvTable[ply][ply] = *move;
+  for (int32_t i = ply + 1; i < mPvLength[ply + 1]; i++)
+  {
+    mPvTable[ply][i] = mPvTable[ply + 1][i];
+  }
+  mPvLength[ply] = mPvLength[ply + 1];
+}
+
+}
@@ -0,0 +1,797 @@
+/*!
+ * \file jcl_search.h
+ *
+ * This file contains the interface for the Search object
+ */
+
+#ifndef JCL_SEARCH_H
+#define JCL_SEARCH_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "jcl_board.h"
+#include "jcl_evaluation.h"
+#include "jcl_move.h"
+
+namespace jcl
+{
+
+class BitBoard;
+class EvaluationCache;
+class MoveList;
+class Tablebase;
+class TimeManager;
+class TranspositionTable;
+
+/*!
+ * \brief Defines an object for searching a chess position
+ *
+ * The Search object performs an iterative deepening negamax
+ * alpha-beta search over the board to find the best move for the
+ * player whose turn it is to move.
+ *
+ * The first move at each node is searched with the full window and
+ * later moves with a null window around alpha, which is enough to
+ * prove they are no better (principal variation search). A move that
+ * fails high is searched again with the full window. Each iteration
+ * after the first starts with an aspiration window around the score
+ * of the previous iteration, which is widened whenever the score
+ * falls outside it. The principal variation is collected in a
+ * triangular table and is available from \ref getPrincipalVariation.
+ * It is searched first in the next iteration.
+ *
+ * When the nominal search depth is exhausted the search continues
+ * with a quiescence search that only considers captures and
+ * promotions, as generated by \ref Board::generateCaptures. The
+ * side to move may always decline to capture and accept the static
+ * evaluation of the position (stand pat), so that the quiescence
+ * search only resolves tactical sequences and does not suffer from
+ * the horizon effect of stopping in the middle of an exchange.
+ *
+ * Quiet moves that give check can optionally be searched at the
+ * first ply of the quiescence search as well.
+ *
+ * Null-move pruning is used to cut nodes where passing the turn to
+ * the opponent still leaves a score above beta. The search depth for
+ * the null move is reduced by two plies, or three plies when the
+ * remaining depth is large (adaptive null-move pruning). Null moves
+ * are not tried when in check, twice in a row, or when the side to
+ * move only has pawns left, where zugzwang is likely.
+ *
+ * Quiet moves searched late in the move list are rarely best. Late
+ * move reductions (LMR) search them to a reduced depth first, taking
+ * the reduction from a table indexed by depth and move number, and
+ * only search them to full depth when they beat alpha. At shallow
+ * depths late quiet moves are skipped altogether (late move pruning).
+ * Neither applies when in check, to captures, promotions or checking
+ * moves, or to quiet moves with a good history score. The parameters
+ * for both can be changed at runtime with \ref setParameters.
+ *
+ * A position that repeats one reached earlier in the game or search,
+ * or that is drawn by the fifty-move rule, is scored as a draw.
+ *
+ * The search can be limited by time with a \ref TimeManager. No new
+ * iteration is started once the soft limit has passed, and the search
+ * is aborted once the hard limit has passed. The clock is only read
+ * every few thousand nodes. The result of an aborted iteration is
+ * discarded in favour of the last completed iteration.
+ *
+ * Several lines can be searched at once for analysis (MultiPV), each
+ * showing the best continuation after a different first move. Rather
+ * than searching the root once per line, each iteration searches the
+ * root once with alpha held at the score of the worst line kept, so
+ * every move good enough to enter the lines gets an exact score and
+ * the remaining moves are refuted with null windows. The lines share
+ * the transposition table and the move ordering heuristics.
+ *
+ * When a \ref Tablebase is set, positions below the root that are in
+ * its tables are scored from the tables without being searched: a
+ * position won or lost in n moves gets the score of a mate in that
+ * many moves, and a drawn position scores zero.
+ *
+ * A \ref TranspositionTable can be shared between several searches
+ * on different threads. Stored results cut null window nodes and the
+ * stored best move is searched first. Each search can also be stopped
+ * through a shared flag, which is checked at every node.
+ *
+ * When the board is a \ref BitBoard, captures that lose material
+ * according to the static exchange evaluation are not searched in
+ * the quiescence search.
+ */
+class Search
+{
+public:
+
+  /*!
+   * \brief Defines the function called after each completed iteration
+   *
+   * The function receives the depth and score of the iteration.
+   */
+  using IterationCallback = std::function<void(int32_t depth, int32_t score)>;
+
+public:
+
+  static constexpr int32_t INFINITE_SCORE = 1000000;  /*!< A score greater than any possible score */
+  static constexpr int32_t MATE_SCORE = 900000;       /*!< The score for delivering mate at the root */
+  static constexpr int32_t MAX_PLY = 128;             /*!< The maximum search ply */
+
+  /*!
+   * \brief Defines the tunable search parameters
+   */
+  struct Parameters
+  {
+    bool lmrEnabled = true;          /*!< Enables late move reductions */
+    int32_t lmrMinDepth = 3;         /*!< The minimum depth at which moves are reduced, at least two */
+    int32_t lmrMinMoves = 4;         /*!< The number of moves searched before reductions start */
+    double lmrBase = 0.75;           /*!< The constant term of the reduction formula */
+    double lmrDivisor = 2.25;        /*!< The divisor of the logarithmic term of the reduction formula */
+    bool lmpEnabled = true;          /*!< Enables late move pruning */
+    int32_t lmpMaxDepth = 3;         /*!< The maximum depth at which quiet moves are pruned */
+    int32_t lmpBase = 3;             /*!< The number of quiet moves always searched */
+    int32_t historyThreshold = 2048; /*!< Quiet moves with at least this history score are not reduced or pruned */
+    int32_t aspirationWindow = 200;  /*!< The initial half width of the aspiration window, zero to disable */
+    int32_t timeCheckInterval = 2048; /*!< The number of nodes between checks of the clock */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a Search object for the supplied
+   * board and evaluation. The board is modified during the search
+   * but is restored to its original position once the search
+   * completes.
+   *
+   * \param board The board to search
+   * \param evaluation The evaluation used to score positions
+   */
+  Search(Board * board, Evaluation * evaluation);
+
+  /*!
+   * \brief Clears the node counts and selective depth
+   *
+   * This function is called at the start of each search. It can be
+   * called before the search is started on another thread, so the
+   * counts read from other threads never include an earlier search.
+   */
+  void clearStatistics();
+
+  /*!
+   * \brief Executes the search
+   *
+   * This function searches the current board position with
+   * iterative deepening up to the specified depth, followed by a
+   * quiescence search at each leaf.
+   * The returned score is from the point of view of the side to
+   * move. If a time manager is set the search may stop before the
+   * specified depth is reached.
+   *
+   * \param depth The nominal search depth
+   *
+   * \return The score for the position
+   */
+  int32_t execute(int32_t depth);
+
+  /*!
+   * \brief Returns the best move found by the last search
+   *
+   * This function returns the best move found by the most recent
+   * call to \ref execute. If no legal move exists the returned move
+   * is not valid.
+   *
+   * \return The best move
+   */
+  const Move & getBestMove() const;
+
+  /*!
+   * \brief Returns the number of lines found by the last search
+   *
+   * \return The number of lines, at most the MultiPV setting
+   */
+  uint32_t getLineCount() const;
+
+  /*!
+   * \brief Returns the score of a line
+   *
+   * \param line The index of the line, zero for the best line
+   *
+   * \return The score of the line from the point of view of the side to move
+   */
+  int32_t getLineScore(uint32_t line) const;
+
+  /*!
+   * \brief Returns the number of lines searched
+   *
+   * \return The number of lines searched
+   */
+  uint32_t getMultiPv() const;
+
+  /*!
+   * \brief Returns the search parameters
+   *
+   * \return The search parameters
+   */
+  const Parameters & getParameters() const;
+
+  /*!
+   * \brief Returns the number of evaluation cache hits of the last search
+   *
+   * \return The number of evaluations found in the evaluation cache
+   */
+  uint64_t getEvaluationCacheHits() const;
+
+  /*!
+   * \brief Returns the number of evaluation cache probes of the last search
+   *
+   * \return The number of evaluations looked up in the evaluation cache
+   */
+  uint64_t getEvaluationCacheProbes() const;
+
+  /*!
+   * \brief Returns the number of nodes visited by the last search
+   *
+   * This function returns the total number of nodes visited during
+   * the most recent search, including quiescence nodes.
+   *
+   * \return The number of nodes visited
+   */
+  uint64_t getNodes() const;
+
+  /*!
+   * \brief Returns a principal variation of the last search
+   *
+   * This function fills the supplied list with a principal
+   * variation found by the most recent call to \ref execute.
+   * The lines are ordered by score, so line zero starts with
+   * the best move.
+   *
+   * \param moveList The list that receives the moves
+   * \param line The index of the line
+   */
+  void getPrincipalVariation(MoveList & moveList, uint32_t line = 0) const;
+
+  /*!
+   * \brief Returns the number of quiescence nodes visited by the last search
+   *
+   * \return The number of quiescence nodes visited
+   */
+  uint64_t getQuiescenceNodes() const;
+
+  /*!
+   * \brief Returns the selective search depth of the last search
+   *
+   * \return The maximum ply reached, including the quiescence search
+   */
+  int32_t getSelectiveDepth() const;
+
+  /*!
+   * \brief Returns the number of tablebase hits of the last search
+   *
+   * \return The number of positions scored from the tablebase
+   */
+  uint64_t getTablebaseHits() const;
+
+  /*!
+   * \brief Returns whether the last search was aborted
+   *
+   * \return true if the last search was stopped before completing, false otherwise
+   */
+  bool isStopped() const;
+
+  /*!
+   * \brief Returns whether lazy evaluation is enabled
+   *
+   * \return true if lazy evaluation is enabled, false otherwise
+   */
+  bool isLazyEvaluationEnabled() const;
+
+  /*!
+   * \brief Returns whether null-move pruning is enabled
+   *
+   * \return true if null-move pruning is enabled, false otherwise
+   */
+  bool isNullMoveEnabled() const;
+
+  /*!
+   * \brief Returns whether quiet checks are searched in quiescence
+   *
+   * \return true if quiet checks are searched, false otherwise
+   */
+  bool isQuietChecksEnabled() const;
+
+  /*!
+   * \brief Sets the evaluation cache
+   *
+   * The cache may be shared with searches running on other threads.
+   * It must be cleared whenever the evaluation changes.
+   *
+   * \param evaluationCache The evaluation cache, or nullptr
+   */
+  void setEvaluationCache(EvaluationCache * evaluationCache);
+
+  /*!
+   * \brief Sets the function called after each completed iteration
+   *
+   * The function is called on the thread running the search, and
+   * can query the nodes and principal variation of the search.
+   *
+   * \param callback The function to call, or an empty function
+   */
+  void setIterationCallback(const IterationCallback & callback);
+
+  /*!
+   * \brief Sets whether lazy evaluation is enabled
+   *
+   * When enabled, the stand-pat evaluation of the quiescence search
+   * is given the search window and may stop before evaluating every
+   * term (see \ref Evaluation). Lazy evaluation is enabled by default.
+   *
+   * \param value true to enable lazy evaluation, false otherwise
+   */
+  void setLazyEvaluationEnabled(bool value);
+
+  /*!
+   * \brief Sets the number of lines searched
+   *
+   * Searching more than one line is intended for analysis, it
+   * makes the search slower. The number of lines is limited to the
+   * number of legal moves. The default is a single line.
+   *
+   * \param value The number of lines
+   */
+  void setMultiPv(uint32_t value);
+
+  /*!
+   * \brief Sets the maximum number of nodes to search
+   *
+   * The limit is not applied until the first iteration completes.
+   *
+   * \param value The maximum number of nodes, or zero for no limit
+   */
+  void setNodeLimit(uint64_t value);
+
+  /*!
+   * \brief Sets whether null-move pruning is enabled
+   *
+   * Null-move pruning is enabled by default.
+   *
+   * \param value true to enable null-move pruning, false otherwise
+   */
+  void setNullMoveEnabled(bool value);
+
+  /*!
+   * \brief Sets the flag used to stop the search
+   *
+   * The search stops as soon as the flag is set, which allows the
+   * search to be stopped from another thread. The first iteration
+   * always completes so that a best move is known. The flag is not
+   * cleared by the search.
+   *
+   * \param stopFlag The stop flag, or nullptr
+   */
+  void setStopFlag(const std::atomic<bool> * stopFlag);
+
+  /*!
+   * \brief Sets the tablebase
+   *
+   * The tablebase may be shared with searches running on other
+   * threads. Positions with castling rights or an en passant capture
+   * are searched as usual.
+   *
+   * \param tablebase The tablebase, or nullptr
+   */
+  void setTablebase(const Tablebase * tablebase);
+
+  /*!
+   * \brief Sets the time manager
+   *
+   * This function sets the time manager that limits the search. The
+   * time manager must be started before calling \ref execute. Pass
+   * nullptr to search to a fixed depth without time limits.
+   *
+   * \param timeManager The time manager, or nullptr
+   */
+  void setTimeManager(TimeManager * timeManager);
+
+  /*!
+   * \brief Sets the transposition table
+   *
+   * The table may be shared with searches running on other threads.
+   * The owner of the table is responsible for calling
+   * \ref TranspositionTable::newSearch before each search.
+   *
+   * \param transpositionTable The transposition table, or nullptr
+   */
+  void setTranspositionTable(TranspositionTable * transpositionTable);
+
+  /*!
+   * \brief Sets the search parameters
+   *
+   * This function sets the tunable search parameters and rebuilds
+   * the late move reduction table from them. The parameters apply
+   * to the next call to \ref execute. Parameters with a minimum
+   * reduction depth below two are rejected and leave the current
+   * parameters unchanged.
+   *
+   * \param parameters The search parameters
+   * \return true if the parameters were valid and set
+   */
+  bool setParameters(const Parameters & parameters);
+
+  /*!
+   * \brief Sets whether quiet checks are searched in quiescence
+   *
+   * When enabled, quiet moves that give check are searched along
+   * with captures at the first ply of the quiescence search. This
+   * finds more short tactics at the cost of a larger quiescence tree.
+   * Quiet checks are disabled by default.
+   *
+   * \param value true to search quiet checks, false otherwise
+   */
+  void setQuietChecksEnabled(bool value);
+
+private:
+
+  /*!
+   * \brief Adds a root move to the lines of the current iteration
+   *
+   * \param move The root move
+   * \param score The score of the move
+   */
+  void addRootLine(const Move * move, int32_t score);
+
+  /*!
+   * \brief Executes the alpha-beta search
+   *
+   * \param depth The remaining depth
+   * \param ply The distance from the root
+   * \param alpha The lower bound
+   * \param beta The upper bound
+   * \param allowNull true if a null move may be tried at this node
+   *
+   * \return The score for the position
+   */
+  int32_t alphaBeta(int32_t depth, int32_t ply, int32_t alpha, int32_t beta, bool allowNull);
+
+  /*!
+   * \brief Searches the root with an aspiration window
+   *
+   * \param depth The search depth
+   * \param previousScore The score of the previous iteration
+   * \param useWindow true to start with a window around the previous score
+   *
+   * \return The score for the position
+   */
+  int32_t aspirationSearch(int32_t depth, int32_t previousScore, bool useWindow);
+
+  /*!
+   * \brief Counts a visited node
+   *
+   * \param ply The distance from the root
+   */
+  void countNode(int32_t ply);
+
+  /*!
+   * \brief Returns the static evaluation from the side to move
+   *
+   * The evaluation cache is consulted first when one is set, and
+   * updated with the score when the position is not found. When
+   * lazy evaluation is enabled and a window is given, the evaluation
+   * may stop early outside the window, and the partial score is not
+   * stored in the cache.
+   *
+   * \param alpha The lower bound of the window for the side to move
+   * \param beta The upper bound of the window for the side to move
+   *
+   * \return The static score for the side to move
+   */
+  int32_t evaluate(int32_t alpha = -INFINITE_SCORE, int32_t beta = INFINITE_SCORE);
+
+  /*!
+   * \brief Returns the history score of a quiet move
+   *
+   * \param move The move
+   *
+   * \return The history score of the move for the side to move
+   */
+  int32_t getHistory(const Move * move) const;
+
+  /*!
+   * \brief Returns whether the side to move has pieces besides pawns
+   *
+   * This function is used to avoid null moves in pawn endings,
+   * where the side to move is often in zugzwang. The piece counts
+   * are read from the material key of the board.
+   *
+   * \return true if the side to move has a piece other than pawns and the king
+   */
+  bool hasNonPawnMaterial() const;
+
+  /*!
+   * \brief Returns whether the side to move is in check
+   *
+   * \return true if the side to move is in check, false otherwise
+   */
+  bool isInCheck() const;
+
+  /*!
+   * \brief Returns whether the search must stop
+   *
+   * This function counts down the nodes until the next check of the
+   * time manager, and flags the search as stopped once the hard time
+   * limit has passed.
+   *
+   * \return true if the search must stop, false otherwise
+   */
+  bool isStopRequested();
+
+  /*!
+   * \brief Returns whether the move just made left the mover in check
+   *
+   * This function must be called after \ref Board::makeMove to
+   * determine whether the move was legal.
+   *
+   * \return true if the previous move was illegal, false otherwise
+   */
+  bool isLastMoveIllegal() const;
+
+  /*!
+   * \brief Builds the late move reduction table
+   *
+   * This function computes the reduction for each depth and move
+   * number from the current parameters.
+   */
+  void initReductions();
+
+  /*!
+   * \brief Orders the moves in a move list
+   *
+   * This function orders the moves in the supplied list by most
+   * valuable victim, least valuable attacker. Quiet moves are placed
+   * after all captures and promotions, ordered by history score. The
+   * principal variation or stored move, if any, is placed first.
+   *
+   * \param moveList The list of moves
+   * \param order The resulting order of move indices
+   * \param firstMove The move in the list to search first, or nullptr
+   */
+  void orderMoves(const MoveList & moveList, uint8_t * order, const Move * firstMove) const;
+
+  /*!
+   * \brief Executes the quiescence search
+   *
+   * \param qply The distance from the start of the quiescence search
+   * \param ply The distance from the root
+   * \param alpha The lower bound
+   * \param beta The upper bound
+   *
+   * \return The score for the position
+   */
+  int32_t quiesce(int32_t qply, int32_t ply, int32_t alpha, int32_t beta);
+
+  /*!
+   * \brief Converts a score read from the transposition table
+   *
+   * \param score The stored score
+   * \param ply The distance from the root
+   *
+   * \return The score relative to the root
+   */
+  static int32_t scoreFromTable(int32_t score, int32_t ply);
+
+  /*!
+   * \brief Converts a score to be stored in the transposition table
+   *
+   * \param score The score relative to the root
+   * \param ply The distance from the root
+   *
+   * \return The score relative to the position
+   */
+  static int32_t scoreToTable(int32_t score, int32_t ply);
+
+  /*!
+   * \brief Rewards a quiet move that caused a beta cutoff
+   *
+   * \param move The move
+   * \param depth The depth at which the cutoff occurred
+   */
+  void updateHistory(const Move * move, int32_t depth);
+
+  /*!
+   * \brief Updates the principal variation after a move raised alpha
+   *
+   * This function stores the move at the head of the variation for
+   * the ply and appends the variation found below it.
+   *
+   * \param move The move
+   * \param ply The distance from the root
+   */
+  void updatePrincipalVariation(const Move * move, int32_t ply);
+
+private:
+
+  // A principal variation and its score
+  struct Line
+  {
+    int32_t score = 0;
+    int32_t length = 0;
+    Move moves[MAX_PLY];
+  };
+
+private:
+  bool mFollowPv;
+  bool mLazyEvaluation;
+  bool mNullMove;
+  bool mQuietChecks;
+  bool mStopped;
+  int32_t mCheckCountdown;          // Nodes remaining until the clock is checked
+  int32_t mSelectiveDepth;
+  uint32_t mMultiPv;
+  int32_t mPreviousPvLength;
+  uint32_t mRootPly;                // Board history size at the root of the search
+  int32_t mHistory[2][64][64];      // History scores by color, source and destination square
+  uint8_t mReductions[64][64];      // Late move reductions by depth and move number
+  int32_t mPvLength[MAX_PLY + 1];   // End of the principal variation at each ply
+  Move mPvTable[MAX_PLY][MAX_PLY];  // Triangular principal variation table
+  Move mPreviousPv[MAX_PLY];        // Principal variation being followed from the previous iteration
+  std::vector<Line> mLines;         // Lines of the last completed iteration, best first
+  std::vector<Line> mRootLines;     // Lines of the current iteration, best first
+  std::atomic<uint64_t> mNodes;     // Written by the search thread only, read by others
+  uint64_t mNodeLimit;
+  uint64_t mQuiescenceNodes;
+  const std::atomic<bool> * mStopFlag;
+  IterationCallback mIterationCallback;
+  Parameters mParameters;
+  Board * mBoard;
+  const BitBoard * mBitBoard;
+  Evaluation * mEvaluation;
+  EvaluationCache * mEvaluationCache;
+  uint64_t mEvaluationCacheHits;
+  uint64_t mEvaluationCacheProbes;
+  const Tablebase * mTablebase;
+  uint64_t mTablebaseHits;
+  TimeManager * mTimeManager;
+  TranspositionTable * mTranspositionTable;
+  Move mBestMove;
+};
+
+inline void Search::countNode(int32_t ply)
+{
+  mNodes.store(mNodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (ply >= mSelectiveDepth)
+  {
+    mSelectiveDepth = ply + 1;
+  }
+}
+
+inline const Move & Search::getBestMove() const
+{
+  return mBestMove;
+}
+
+inline uint32_t Search::getLineCount() const
+{
+  return static_cast<uint32_t>(mLines.size());
+}
+
+inline uint32_t Search::getMultiPv() const
+{
+  return mMultiPv;
+}
+
+inline const Search::Parameters & Search::getParameters() const
+{
+  return mParameters;
+}
+
+inline uint64_t Search::getEvaluationCacheHits() const
+{
+  return mEvaluationCacheHits;
+}
+
+inline uint64_t Search::getEvaluationCacheProbes() const
+{
+  return mEvaluationCacheProbes;
+}
+
+inline uint64_t Search::getNodes() const
+{
+  return mNodes.load(std::memory_order_relaxed);
+}
+
+inline uint64_t Search::getTablebaseHits() const
+{
+  return mTablebaseHits;
+}
+
+inline uint64_t Search::getQuiescenceNodes() const
+{
+  return mQuiescenceNodes;
+}
+
+inline int32_t Search::getSelectiveDepth() const
+{
+  return mSelectiveDepth;
+}
+
+inline bool Search::isStopped() const
+{
+  return mStopped;
+}
+
+inline bool Search::isLazyEvaluationEnabled() const
+{
+  return mLazyEvaluation;
+}
+
+inline bool Search::isNullMoveEnabled() const
+{
+  return mNullMove;
+}
+
+inline bool Search::isQuietChecksEnabled() const
+{
+  return mQuietChecks;
+}
+
+inline void Search::setEvaluationCache(EvaluationCache * evaluationCache)
+{
+  mEvaluationCache = evaluationCache;
+}
+
+inline void Search::setIterationCallback(const IterationCallback & callback)
+{
+  mIterationCallback = callback;
+}
+
+inline void Search::setMultiPv(uint32_t value)
+{
+  mMultiPv = (value > 0) ? value : 1;
+}
+
+inline void Search::setNodeLimit(uint64_t value)
+{
+  mNodeLimit = value;
+}
+
+inline void Search::setLazyEvaluationEnabled(bool value)
+{
+  mLazyEvaluation = value;
+}
+
+inline void Search::setNullMoveEnabled(bool value)
+{
+  mNullMove = value;
+}
+
+inline void Search::setQuietChecksEnabled(bool value)
+{
+  mQuietChecks = value;
+}
+
+inline void Search::setStopFlag(const std::atomic<bool> * stopFlag)
+{
+  mStopFlag = stopFlag;
+}
+
+inline void Search::setTablebase(const Tablebase * tablebase)
+{
+  mTablebase = tablebase;
+}
+
+inline void Search::setTimeManager(TimeManager * timeManager)
+{
+  mTimeManager = timeManager;
+}
+
+inline void Search::setTranspositionTable(TranspositionTable * transpositionTable)
+{
+  mTranspositionTable = transpositionTable;
+}
+
+}
+
+#endif // #ifndef JCL_SEARCH_H
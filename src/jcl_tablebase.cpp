@@ -0,0 +1,145 @@
+/*!
+ * \file jcl_tablebase.cpp
+ *
+ * This file contains the implementation for the Tablebase object
+ */
+
+#include "jcl_tablebase.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "jcl_bitboard.h"
+#include "jcl_board.h"
+#include "jcl_materialtable.h"
+
+namespace jcl
+{
+
+// Material key of the two kings alone
+static const uint64_t KINGS_KEY = MaterialTable::getPieceKey(PieceType::WhiteKing) + MaterialTable::getPieceKey(PieceType::BlackKing);
+
+// Returns the number of pieces in a material key
+static uint32_t countPieces(uint64_t materialKey)
+{
+  // Adjacent counts are added into bytes, which are then summed by the multiplication
+  uint64_t pairs = (materialKey & 0x0f0f0f0f0f0f0f0fULL) + ((materialKey >> 4) & 0x0f0f0f0f0f0f0f0fULL);
+  return static_cast<uint32_t>((pairs * 0x0101010101010101ULL) >> 56);
+}
+
+// Mirrors a bitboard vertically, exchanging the first and eighth ranks
+static uint64_t mirrorRanks(uint64_t bb)
+{
+  bb = ((bb >> 8) & 0x00ff00ff00ff00ffULL) | ((bb & 0x00ff00ff00ff00ffULL) << 8);
+  bb = ((bb >> 16) & 0x0000ffff0000ffffULL) | ((bb & 0x0000ffff0000ffffULL) << 16);
+  return (bb >> 32) | (bb << 32);
+}
+
+Tablebase::Tablebase()
+  : mMaxPieces(0)
+{
+
+}
+
+void Tablebase::addTable(std::unique_ptr<EndgameTable> table)
+{
+  mMaxPieces = std::max(mMaxPieces, table->getPieceCount());
+  uint64_t materialKey = table->getMaterialKey();
+  mTables.erase(EndgameTable::flipMaterialKey(materialKey));
+  mTables[materialKey] = std::move(table);
+}
+
+void Tablebase::clear()
+{
+  mTables.clear();
+  mMaxPieces = 0;
+}
+
+const EndgameTable * Tablebase::findTable(uint64_t materialKey, bool & flipped) const
+{
+  auto iterator = mTables.find(materialKey);
+  flipped = (iterator == mTables.end());
+  if (flipped)
+  {
+    iterator = mTables.find(EndgameTable::flipMaterialKey(materialKey));
+  }
+  return (iterator == mTables.end()) ? nullptr : iterator->second.get();
+}
+
+std::string Tablebase::getFileName(const std::string & directory, uint64_t materialKey)
+{
+  std::filesystem::path path(directory);
+  path /= EndgameTable::getSignature(materialKey) + FILE_EXTENSION;
+  return path.string();
+}
+
+size_t Tablebase::load(const std::string & directory)
+{
+  std::error_code error;
+  size_t count = 0;
+  for (const auto & entry : std::filesystem::directory_iterator(directory, error))
+  {
+    if (entry.path().extension() != FILE_EXTENSION)
+    {
+      continue;
+    }
+
+    std::unique_ptr<EndgameTable> table(new EndgameTable);
+    if (table->load(entry.path().string()))
+    {
+      addTable(std::move(table));
+      count++;
+    }
+  }
+
+  return count;
+}
+
+bool Tablebase::probe(const Board * board, uint8_t & value) const
+{
+  uint64_t materialKey = board->getMaterialKey();
+  if (countPieces(materialKey) > mMaxPieces ||
+      board->getCastlingRights() != Board::CASTLE_NONE ||
+      board->getEnpassantColumn() != Board::INVALID_ENPASSANT_COLUMN)
+  {
+    return false;
+  }
+
+  // Boards without bitboards are scanned, which only happens for positions with few pieces
+  uint64_t scanned[12];
+  const uint64_t * pieces = board->getPieceBitboards(scanned);
+  return probe(pieces, materialKey, board->getSideToMove(), value);
+}
+
+bool Tablebase::probe(const uint64_t * pieces, uint64_t materialKey, Color sideToMove, uint8_t & value) const
+{
+  if (materialKey == KINGS_KEY)
+  {
+    value = EndgameTable::DRAW;
+    return true;
+  }
+
+  bool flipped = false;
+  const EndgameTable * table = findTable(materialKey, flipped);
+  if (table == nullptr)
+  {
+    return false;
+  }
+
+  if (!flipped)
+  {
+    value = table->getValue(table->getIndex(pieces, sideToMove));
+    return true;
+  }
+
+  // The colors are exchanged and the board mirrored, so white becomes black
+  uint64_t mirrored[12];
+  for (int i = 0; i < 12; i++)
+  {
+    mirrored[i] = mirrorRanks(pieces[(i + 6) % 12]);
+  }
+  value = table->getValue(table->getIndex(mirrored, !sideToMove));
+  return true;
+}
+
+}
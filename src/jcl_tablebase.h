@@ -0,0 +1,161 @@
+/*!
+ * \file jcl_tablebase.h
+ *
+ * This file contains the interface for the Tablebase object
+ */
+
+#ifndef JCL_TABLEBASE_H
+#define JCL_TABLEBASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "jcl_endgametable.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+class Board;
+
+/*!
+ * \brief Defines a set of endgame tables
+ *
+ * The Tablebase object holds the endgame tables available to the
+ * search, keyed by their material key (see \ref MaterialTable), so
+ * finding the table of a position is a single lookup. Each table
+ * serves its material with either colors: a position whose colors
+ * are exchanged is mirrored vertically before it is indexed.
+ *
+ * Tables are generated by the \ref TablebaseGenerator, which adds
+ * them to a tablebase, or loaded from the files of a directory.
+ * Positions with only the two kings are always drawn and need no
+ * table.
+ *
+ * A tablebase is read-only once its tables are added, so it can be
+ * shared by the searches of several threads.
+ */
+class Tablebase
+{
+public:
+  static constexpr const char * FILE_EXTENSION = ".jtb"; /*!< The extension of table files */
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs an empty Tablebase object.
+   */
+  Tablebase();
+
+  Tablebase(const Tablebase &) = delete;
+  Tablebase & operator=(const Tablebase &) = delete;
+
+  /*!
+   * \brief Adds a table
+   *
+   * This function takes ownership of a table, replacing any table of
+   * the same material.
+   *
+   * \param table The table, which must be created or loaded
+   */
+  void addTable(std::unique_ptr<EndgameTable> table);
+
+  /*!
+   * \brief Removes all tables
+   */
+  void clear();
+
+  /*!
+   * \brief Finds the table of a material key
+   *
+   * \param materialKey The material key
+   * \param flipped Set to true if the table has the material with the colors exchanged
+   *
+   * \return The table, or nullptr if there is none
+   */
+  const EndgameTable * findTable(uint64_t materialKey, bool & flipped) const;
+
+  /*!
+   * \brief Returns the file name of a table
+   *
+   * \param directory The directory of the table
+   * \param materialKey The material key of the table
+   *
+   * \return The file name, the signature of the material with the FILE_EXTENSION
+   */
+  static std::string getFileName(const std::string & directory, uint64_t materialKey);
+
+  /*!
+   * \brief Returns the number of pieces of the largest table
+   *
+   * \return The number of pieces, kings included, or zero if there are no tables
+   */
+  uint32_t getMaxPieces() const;
+
+  /*!
+   * \brief Returns the number of tables
+   *
+   * \return The number of tables
+   */
+  size_t getTableCount() const;
+
+  /*!
+   * \brief Loads the tables of a directory
+   *
+   * This function maps every file of the directory with the
+   * FILE_EXTENSION. Files that cannot be loaded are skipped.
+   *
+   * \param directory The directory of the tables
+   *
+   * \return The number of tables loaded
+   */
+  size_t load(const std::string & directory);
+
+  /*!
+   * \brief Probes the tables for a position
+   *
+   * Positions with castling rights or an en passant capture are not
+   * in the tables.
+   *
+   * \param board The board
+   * \param value Holds the value of the position (see \ref EndgameTable)
+   *
+   * \return true if the position was found, false otherwise
+   */
+  bool probe(const Board * board, uint8_t & value) const;
+
+  /*!
+   * \brief Probes the tables for a position
+   *
+   * \param pieces The twelve piece bitboards, indexed by PieceType minus one
+   * \param materialKey The material key of the pieces
+   * \param sideToMove The side to move
+   * \param value Holds the value of the position (see \ref EndgameTable)
+   *
+   * \return true if the position was found, false otherwise
+   */
+  bool probe(const uint64_t * pieces, uint64_t materialKey, Color sideToMove, uint8_t & value) const;
+
+private:
+  std::unordered_map<uint64_t, std::unique_ptr<EndgameTable>> mTables; // Tables by material key
+  uint32_t mMaxPieces;                                                  // Pieces of the largest table
+};
+
+inline uint32_t Tablebase::getMaxPieces() const
+{
+  return mMaxPieces;
+}
+
+inline size_t Tablebase::getTableCount() const
+{
+  return mTables.size();
+}
+
+}
+
+#endif // #ifndef JCL_TABLEBASE_H
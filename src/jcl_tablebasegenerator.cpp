@@ -0,0 +1,558 @@
+/*!
+ * \file jcl_tablebasegenerator.cpp
+ *
+ * This file contains the implementation for the TablebaseGenerator object
+ */
+
+#include "jcl_tablebasegenerator.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "jcl_bitboard.h"
+#include "jcl_materialtable.h"
+#include "jcl_movelist.h"
+#include "jcl_piecesquare.h"
+#include "jcl_tablebase.h"
+
+namespace jcl
+{
+
+// Material key of the two kings alone
+static const uint64_t KINGS_KEY = MaterialTable::getPieceKey(PieceType::WhiteKing) + MaterialTable::getPieceKey(PieceType::BlackKing);
+
+// The longest win stored, in moves
+static const int32_t MAX_WIN = EndgameTable::LOSS - 1;
+
+// Ranks of the bitboards, bit zero being h1
+static const uint64_t RANK_1 = 0x00000000000000ffULL;
+static const uint64_t RANK_3 = 0x0000000000ff0000ULL;
+static const uint64_t RANK_6 = 0x0000ff0000000000ULL;
+static const uint64_t RANK_8 = 0xff00000000000000ULL;
+
+// Returns the distance of a won or lost value in plies
+static int32_t getPlies(uint8_t value)
+{
+  int32_t distance = EndgameTable::getDistance(value);
+  return EndgameTable::isLoss(value) ? 2 * distance : 2 * distance - 1;
+}
+
+// Returns the value of a distance in plies, wins being odd and losses even
+static uint8_t getValue(uint32_t plies)
+{
+  if ((plies & 1) != 0)
+  {
+    return static_cast<uint8_t>(std::min<uint32_t>((plies + 1) / 2, MAX_WIN));
+  }
+  return static_cast<uint8_t>(EndgameTable::LOSS + std::min<uint32_t>(plies / 2, EndgameTable::MAX_DISTANCE));
+}
+
+// Returns whether the king of a side is attacked
+static bool isKingAttacked(const Board * board, Color color)
+{
+  return board->isCellAttacked(board->getKingRow(color), board->getKingColumn(color), !color);
+}
+
+// Returns whether a side attacks a square of the piece bitboards
+static bool isSquareAttacked(const BitBoard * tables, const uint64_t * pieces, uint8_t square, Color color)
+{
+  const uint64_t * side = getSideBitboards(pieces, color);
+  uint64_t occupied = 0;
+  for (int i = 0; i < 12; i++)
+  {
+    occupied |= pieces[i];
+  }
+
+  return (BitBoard::getPawnAttacks(side[PAWNS], color) & (1ULL << square)) != 0 ||
+         (tables->getKnightAttacks(square) & side[KNIGHTS]) != 0 ||
+         (tables->getKingAttacks(square) & side[KINGS]) != 0 ||
+         (tables->getBishopAttacks(square, occupied) & (side[BISHOPS] | side[QUEENS])) != 0 ||
+         (tables->getRookAttacks(square, occupied) & (side[ROOKS] | side[QUEENS])) != 0;
+}
+
+// Reflects the piece bitboards in the a1-h8 diagonal
+static void reflectBitboards(const uint64_t * pieces, uint64_t * reflected)
+{
+  for (int i = 0; i < 12; i++)
+  {
+    reflected[i] = 0;
+    for (uint64_t bb = pieces[i]; bb != 0; bb &= bb - 1)
+    {
+      uint8_t bit = bitScanForward(bb);
+      uint8_t row = bit >> 3;
+      uint8_t col = 7 - (bit & 7);
+      reflected[i] |= 1ULL << ((col << 3) + 7 - row);
+    }
+  }
+}
+
+// Returns the squares a piece can have moved from without a capture or promotion
+static uint64_t getRetractions(const BitBoard * tables, PieceType pieceType, uint8_t square, uint64_t occupied)
+{
+  uint64_t empty = ~occupied;
+  uint64_t bit = 1ULL << square;
+  switch (pieceType)
+  {
+  case PieceType::WhitePawn:
+  {
+    uint64_t single = (bit >> 8) & empty & ~RANK_1;
+    return single | (((single & RANK_3) >> 8) & empty);
+  }
+  case PieceType::BlackPawn:
+  {
+    uint64_t single = (bit << 8) & empty & ~RANK_8;
+    return single | (((single & RANK_6) << 8) & empty);
+  }
+  case PieceType::WhiteKnight:
+  case PieceType::BlackKnight:
+    return tables->getKnightAttacks(square) & empty;
+  case PieceType::WhiteBishop:
+  case PieceType::BlackBishop:
+    return tables->getBishopAttacks(square, occupied) & empty;
+  case PieceType::WhiteRook:
+  case PieceType::BlackRook:
+    return tables->getRookAttacks(square, occupied) & empty;
+  case PieceType::WhiteQueen:
+  case PieceType::BlackQueen:
+    return (tables->getBishopAttacks(square, occupied) | tables->getRookAttacks(square, occupied)) & empty;
+  case PieceType::WhiteKing:
+  case PieceType::BlackKing:
+    return tables->getKingAttacks(square) & empty;
+  default:
+    return 0;
+  }
+}
+
+// Places the pieces of a position on the board, or removes them
+static void setPieces(BitBoard * board, const EndgameTable * table, const uint8_t * squares, bool place)
+{
+  const std::vector<PieceType> & pieceTypes = table->getPieceTypes();
+  for (uint32_t i = 0; i < table->getPieceCount(); i++)
+  {
+    board->setPieceType(squares[i] >> 3, squares[i] & 7, place ? pieceTypes[i] : PieceType::None);
+  }
+}
+
+// Returns the material of one side, kings excluded
+static int32_t getMaterialValue(uint64_t materialKey, Color color)
+{
+  uint32_t offset = getSideOffset(color) + 1;
+  return MaterialTable::getPieceCount(materialKey, static_cast<PieceType>(offset + PAWNS)) * PieceSquareValues::PAWN_WEIGHT_MG +
+         MaterialTable::getPieceCount(materialKey, static_cast<PieceType>(offset + ROOKS)) * PieceSquareValues::ROOK_WEIGHT_MG +
+         MaterialTable::getPieceCount(materialKey, static_cast<PieceType>(offset + KNIGHTS)) * PieceSquareValues::KNIGHT_WEIGHT_MG +
+         MaterialTable::getPieceCount(materialKey, static_cast<PieceType>(offset + BISHOPS)) * PieceSquareValues::BISHOP_WEIGHT_MG +
+         MaterialTable::getPieceCount(materialKey, static_cast<PieceType>(offset + QUEENS)) * PieceSquareValues::QUEEN_WEIGHT_MG;
+}
+
+// Returns the material key a table is generated with, the stronger side being white
+static uint64_t getCanonicalKey(uint64_t materialKey)
+{
+  uint64_t flipped = EndgameTable::flipMaterialKey(materialKey);
+  int32_t white = getMaterialValue(materialKey, Color::White);
+  int32_t black = getMaterialValue(materialKey, Color::Black);
+  if (white != black)
+  {
+    return (white > black) ? materialKey : flipped;
+  }
+  return ((materialKey & 0xffffffULL) >= (flipped & 0xffffffULL)) ? materialKey : flipped;
+}
+
+TablebaseGenerator::TablebaseGenerator(Tablebase * tablebase, size_t threadCount)
+  : mTablebase(tablebase)
+  , mTable(nullptr)
+  , mPass(0)
+  , mNextIndex(0)
+  , mChanges(0)
+  , mLastEvent(0)
+{
+  // Each board starts empty, the pieces of a position are placed and removed in turn
+  threadCount = std::max<size_t>(threadCount, 1);
+  for (size_t i = 0; i < threadCount; i++)
+  {
+    std::unique_ptr<BitBoard> board(new BitBoard);
+    board->setPosition("4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+    board->setPieceType(0, 4, PieceType::None);
+    board->setPieceType(7, 4, PieceType::None);
+    mBoards.push_back(std::move(board));
+  }
+}
+
+TablebaseGenerator::~TablebaseGenerator()
+{
+
+}
+
+bool TablebaseGenerator::generate(const std::string & signature)
+{
+  uint64_t materialKey = EndgameTable::getMaterialKey(signature);
+  return (materialKey != 0) && generateMaterial(materialKey);
+}
+
+bool TablebaseGenerator::generateMaterial(uint64_t materialKey)
+{
+  bool flipped = false;
+  if (materialKey == KINGS_KEY || mTablebase->findTable(materialKey, flipped) != nullptr)
+  {
+    return true;
+  }
+
+  materialKey = getCanonicalKey(materialKey);
+  if (!mDirectory.empty())
+  {
+    std::unique_ptr<EndgameTable> table(new EndgameTable);
+    if (table->load(Tablebase::getFileName(mDirectory, materialKey)))
+    {
+      mTablebase->addTable(std::move(table));
+      return true;
+    }
+  }
+
+  // Every capture of a piece other than a king
+  for (int i = 1; i <= 11; i++)
+  {
+    PieceType pieceType = static_cast<PieceType>(i);
+    if (pieceType != PieceType::WhiteKing && MaterialTable::getPieceCount(materialKey, pieceType) > 0 &&
+        !generateMaterial(materialKey - MaterialTable::getPieceKey(pieceType)))
+    {
+      return false;
+    }
+  }
+
+  // Every promotion, captures that promote being reached through the promoted material
+  for (int side = 0; side < 2; side++)
+  {
+    PieceType pawn = static_cast<PieceType>(side * 6 + 1);
+    if (MaterialTable::getPieceCount(materialKey, pawn) == 0)
+    {
+      continue;
+    }
+
+    for (int i = 2; i <= 5; i++)
+    {
+      uint64_t promotedKey = materialKey - MaterialTable::getPieceKey(pawn) + MaterialTable::getPieceKey(static_cast<PieceType>(side * 6 + i));
+      if (!generateMaterial(promotedKey))
+      {
+        return false;
+      }
+    }
+  }
+
+  return generateTable(materialKey);
+}
+
+bool TablebaseGenerator::generateTable(uint64_t materialKey)
+{
+  std::unique_ptr<EndgameTable> table(new EndgameTable);
+  if (!table->create(materialKey))
+  {
+    return false;
+  }
+
+  uint64_t entryCount = table->getEntryCount();
+  mTable = table.get();
+  mValues.reset(new std::atomic<uint8_t>[entryCount]);
+  for (uint64_t i = 0; i < entryCount; i++)
+  {
+    mValues[i].store(UNRESOLVED, std::memory_order_relaxed);
+  }
+  mEvents.reset(new uint8_t[entryCount]());
+  mLastEvent = 0;
+
+  // A pass that resolves nothing ends the generation once the moves into the other tables have been counted
+  for (mPass = 0; ; mPass++)
+  {
+    mNextIndex = 0;
+    mChanges = 0;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < mBoards.size(); i++)
+    {
+      threads.emplace_back(&TablebaseGenerator::runPass, this, mBoards[i].get());
+    }
+    runPass(mBoards[0].get());
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+      threads[i].join();
+    }
+
+    if (mPass > 0 && mChanges == 0 && mPass >= mLastEvent)
+    {
+      break;
+    }
+  }
+
+  for (uint64_t i = 0; i < entryCount; i++)
+  {
+    uint8_t value = mValues[i].load(std::memory_order_relaxed);
+    table->setValue(i, (value == RESOLVED_DRAW) ? EndgameTable::DRAW : value);
+  }
+  mValues.reset();
+  mEvents.reset();
+  mTable = nullptr;
+
+  if (!mDirectory.empty() && !table->save(Tablebase::getFileName(mDirectory, materialKey)))
+  {
+    return false;
+  }
+
+  if (mTableCallback)
+  {
+    mTableCallback(*table, mPass + 1);
+  }
+  mTablebase->addTable(std::move(table));
+  return true;
+}
+
+uint8_t TablebaseGenerator::initializeEntry(BitBoard * board, uint64_t index)
+{
+  uint32_t pieceCount = mTable->getPieceCount();
+  uint8_t squares[EndgameTable::MAX_PIECES];
+  Color sideToMove = Color::White;
+  mTable->getSquares(index, squares, sideToMove);
+
+  // Placements with two pieces on a square are not positions
+  uint64_t occupied = 0;
+  for (uint32_t i = 0; i < pieceCount; i++)
+  {
+    uint64_t bit = 1ULL << squares[i];
+    if ((occupied & bit) != 0)
+    {
+      return RESOLVED_DRAW;
+    }
+    occupied |= bit;
+  }
+
+  setPieces(board, mTable, squares, true);
+  board->setSideToMove(sideToMove);
+
+  // The side that just moved cannot be in check
+  Color otherSide = !sideToMove;
+  uint8_t value = UNRESOLVED;
+  if (isKingAttacked(board, otherSide))
+  {
+    value = RESOLVED_DRAW;
+  }
+  else
+  {
+    MoveList moveList;
+    board->generateMoves(moveList);
+
+    // Captures and promotions change the material and are found in the tables generated before
+    bool hasMove = false;
+    uint32_t winPlies = 0;
+    uint32_t lossPlies = 0;
+    for (uint32_t i = 0; i < moveList.size(); i++)
+    {
+      const Move * move = moveList[i];
+      board->makeMove(move);
+      if (isKingAttacked(board, sideToMove))
+      {
+        board->unmakeMove(move);
+        continue;
+      }
+
+      hasMove = true;
+      uint8_t child = EndgameTable::DRAW;
+      uint64_t materialKey = board->getMaterialKey();
+      if (materialKey != mTable->getMaterialKey() &&
+          mTablebase->probe(board->getBitboards(), materialKey, otherSide, child) && child != EndgameTable::DRAW)
+      {
+        uint32_t plies = static_cast<uint32_t>(getPlies(child)) + 1;
+        if (EndgameTable::isLoss(child))
+        {
+          winPlies = (winPlies == 0) ? plies : std::min(winPlies, plies);
+        }
+        else
+        {
+          lossPlies = std::max(lossPlies, plies);
+        }
+      }
+      board->unmakeMove(move);
+    }
+
+    // A side without a legal move is mated or stalemated
+    if (!hasMove)
+    {
+      bool inCheck = isKingAttacked(board, sideToMove);
+      value = inCheck ? EndgameTable::LOSS : RESOLVED_DRAW;
+    }
+    else
+    {
+      // The pass that counts the longest move into the other tables looks at the position again
+      uint32_t event = (winPlies != 0) ? winPlies : lossPlies;
+      mEvents[index] = static_cast<uint8_t>(event);
+      uint32_t lastEvent = mLastEvent.load(std::memory_order_relaxed);
+      while (event > lastEvent && !mLastEvent.compare_exchange_weak(lastEvent, event, std::memory_order_relaxed))
+      {
+      }
+    }
+  }
+
+  setPieces(board, mTable, squares, false);
+  return value;
+}
+
+bool TablebaseGenerator::isLost(BitBoard * board, uint64_t index)
+{
+  uint8_t squares[EndgameTable::MAX_PIECES];
+  Color sideToMove = Color::White;
+  mTable->getSquares(index, squares, sideToMove);
+  setPieces(board, mTable, squares, true);
+  board->setSideToMove(sideToMove);
+
+  Color otherSide = !sideToMove;
+  MoveList moveList;
+  board->generateMoves(moveList);
+
+  // Every legal move must lead to a win counted by an earlier pass
+  bool lost = true;
+  for (uint32_t i = 0; i < moveList.size() && lost; i++)
+  {
+    const Move * move = moveList[i];
+    board->makeMove(move);
+    if (isKingAttacked(board, sideToMove))
+    {
+      board->unmakeMove(move);
+      continue;
+    }
+
+    uint8_t child = EndgameTable::DRAW;
+    uint64_t materialKey = board->getMaterialKey();
+    if (materialKey == mTable->getMaterialKey())
+    {
+      child = mValues[mTable->getIndex(board->getBitboards(), otherSide)].load(std::memory_order_relaxed);
+    }
+    else
+    {
+      mTablebase->probe(board->getBitboards(), materialKey, otherSide, child);
+    }
+    board->unmakeMove(move);
+
+    lost = EndgameTable::isWin(child) && getPlies(child) < static_cast<int32_t>(mPass);
+  }
+
+  setPieces(board, mTable, squares, false);
+  return lost;
+}
+
+uint32_t TablebaseGenerator::resolveEntry(BitBoard * board, uint64_t index)
+{
+  if (mValues[index].load(std::memory_order_relaxed) != UNRESOLVED)
+  {
+    return 0;
+  }
+
+  // Wins are found on odd passes, losses on even passes once every move is known to lose
+  if ((mPass & 1) == 0 && !isLost(board, index))
+  {
+    return 0;
+  }
+
+  uint8_t expected = UNRESOLVED;
+  return mValues[index].compare_exchange_strong(expected, getValue(mPass), std::memory_order_relaxed) ? 1 : 0;
+}
+
+uint32_t TablebaseGenerator::retractMoves(BitBoard * board, uint64_t index)
+{
+  const std::vector<PieceType> & pieceTypes = mTable->getPieceTypes();
+  uint32_t pieceCount = mTable->getPieceCount();
+  uint8_t squares[EndgameTable::MAX_PIECES];
+  Color sideToMove = Color::White;
+  mTable->getSquares(index, squares, sideToMove);
+
+  // Squares are numbered row * 8 + column, bitboards have bit zero on h1
+  uint64_t pieces[12] = { 0 };
+  for (uint32_t i = 0; i < pieceCount; i++)
+  {
+    pieces[static_cast<int>(pieceTypes[i]) - 1] |= 1ULL << (squares[i] ^ 7);
+  }
+  uint64_t occupied = 0;
+  for (int i = 0; i < 12; i++)
+  {
+    occupied |= pieces[i];
+  }
+  uint8_t king = bitScanForward(getSideBitboards(pieces, sideToMove)[KINGS]);
+
+  // Only the side that just moved retracts a move, which cannot have left the other king in check
+  Color mover = !sideToMove;
+  uint32_t changes = 0;
+  for (uint32_t i = 0; i < pieceCount; i++)
+  {
+    PieceType pieceType = pieceTypes[i];
+    Color color = (pieceType <= PieceType::WhiteKing) ? Color::White : Color::Black;
+    if (color != mover)
+    {
+      continue;
+    }
+
+    uint8_t square = squares[i] ^ 7;
+    uint64_t & bitboard = pieces[static_cast<int>(pieceType) - 1];
+    for (uint64_t sources = getRetractions(board, pieceType, square, occupied); sources != 0; sources &= sources - 1)
+    {
+      uint64_t move = (1ULL << square) | (1ULL << bitScanForward(sources));
+      bitboard ^= move;
+      if (!isSquareAttacked(board, pieces, king, mover))
+      {
+        uint64_t predecessor = mTable->getIndex(pieces, mover);
+        changes += resolveEntry(board, predecessor);
+
+        // Without pawns, a white king on the diagonal leaves a second index for the same position
+        if (!mTable->hasPawns())
+        {
+          uint64_t reflected[12];
+          reflectBitboards(pieces, reflected);
+          uint64_t reflection = mTable->getIndex(reflected, mover);
+          if (reflection != predecessor)
+          {
+            changes += resolveEntry(board, reflection);
+          }
+        }
+      }
+      bitboard ^= move;
+    }
+  }
+
+  return changes;
+}
+
+void TablebaseGenerator::runPass(BitBoard * board)
+{
+  // Each pass retracts the moves into the positions resolved by the pass before
+  uint8_t frontier = (mPass > 0) ? getValue(mPass - 1) : UNRESOLVED;
+  uint64_t entryCount = mTable->getEntryCount();
+  for (;;)
+  {
+    uint64_t first = mNextIndex.fetch_add(CHUNK_SIZE);
+    if (first >= entryCount)
+    {
+      break;
+    }
+
+    uint64_t last = std::min(first + CHUNK_SIZE, entryCount);
+    uint64_t changes = 0;
+    for (uint64_t i = first; i < last; i++)
+    {
+      uint8_t value = mValues[i].load(std::memory_order_relaxed);
+      if (mPass == 0)
+      {
+        value = initializeEntry(board, i);
+        if (value != UNRESOLVED)
+        {
+          mValues[i].store(value, std::memory_order_relaxed);
+          changes++;
+        }
+      }
+      else if (value == frontier)
+      {
+        changes += retractMoves(board, i);
+      }
+      else if (mEvents[i] == mPass)
+      {
+        changes += resolveEntry(board, i);
+      }
+    }
+    mChanges += changes;
+  }
+}
+
+}
@@ -0,0 +1,257 @@
+/*!
+ * \file jcl_tablebasegenerator.h
+ *
+ * This file contains the interface for the TablebaseGenerator object
+ */
+
+#ifndef JCL_TABLEBASEGENERATOR_H
+#define JCL_TABLEBASEGENERATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jcl_endgametable.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+class BitBoard;
+class Tablebase;
+
+/*!
+ * \brief Defines the generation of endgame tables
+ *
+ * The TablebaseGenerator object computes the endgame table of a
+ * material signature by retrograde analysis with the move generator
+ * of the \ref BitBoard. A capture or a promotion leaves the table, so
+ * the tables of every material reachable from the signature are
+ * generated first, smallest first, and looked up for those moves.
+ *
+ * The first pass visits every position once. It marks the
+ * checkmates, stalemates and placements that are not legal
+ * positions, and notes for the others the pass at which their
+ * captures and promotions into the other tables decide them. Pass p
+ * then resolves exactly the positions mated or mating in p plies:
+ *
+ * - The moves into the positions lost in p - 1 plies are retracted,
+ *   and the positions they come from win in p plies.
+ * - The moves into the positions won in p - 1 plies are retracted,
+ *   and the positions they come from whose legal moves all lead to
+ *   positions won in fewer plies are lost in p plies.
+ * - The positions whose captures and promotions decide them at pass
+ *   p are resolved the same way.
+ *
+ * A retracted move takes back a move of the side that moved last
+ * to an empty square, pawns moving backwards, since captures and
+ * promotions change the material. Only the positions that a resolved
+ * position can be reached from are visited, so each pass costs much
+ * less than making every move of every position again. The passes
+ * end when one resolves nothing and no capture or promotion is left
+ * to count. The positions still unresolved are drawn.
+ *
+ * The generation holds two bytes for each position besides the
+ * table, so a table of five pieces without pawns (over 300 million
+ * positions) needs about a gigabyte of memory.
+ *
+ * The positions of each pass are shared among the threads in chunks,
+ * each thread with its own board. A value written during a pass is
+ * only read as resolved by later passes and is written with an
+ * atomic exchange, so the threads need no locks. Each generated
+ * table is added to the \ref Tablebase and, when a directory is set,
+ * saved there. Tables already in the
+ * tablebase or in the directory are not generated again.
+ */
+class TablebaseGenerator
+{
+public:
+
+  /*!
+   * \brief Defines a function called after each table is generated
+   *
+   * The function receives the table and the number of passes it took.
+   */
+  using TableCallback = std::function<void(const EndgameTable & table, uint32_t passCount)>;
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a TablebaseGenerator object adding its
+   * tables to the specified tablebase.
+   *
+   * \param tablebase The tablebase, which must outlive the generator
+   * \param threadCount The number of threads, the calling thread included
+   */
+  TablebaseGenerator(Tablebase * tablebase, size_t threadCount = 1);
+
+  /*!
+   * \brief Destructor
+   */
+  ~TablebaseGenerator();
+
+  TablebaseGenerator(const TablebaseGenerator &) = delete;
+  TablebaseGenerator & operator=(const TablebaseGenerator &) = delete;
+
+  /*!
+   * \brief Generates the table of a signature
+   *
+   * This function generates the table of the signature and of every
+   * material it can reach, unless they are already available.
+   *
+   * \param signature The signature, such as "KRPvKR"
+   *
+   * \return true if the tables are available, false if the signature
+   *         cannot be read, has too many pieces or a table cannot be saved
+   */
+  bool generate(const std::string & signature);
+
+  /*!
+   * \brief Returns the directory tables are saved to
+   *
+   * \return The directory, or an empty string if tables are not saved
+   */
+  const std::string & getDirectory() const;
+
+  /*!
+   * \brief Returns the number of threads
+   *
+   * \return The number of threads
+   */
+  size_t getThreadCount() const;
+
+  /*!
+   * \brief Sets the directory tables are saved to
+   *
+   * \param directory The directory, or an empty string to keep tables in memory only
+   */
+  void setDirectory(const std::string & directory);
+
+  /*!
+   * \brief Sets the function called after each table is generated
+   *
+   * \param callback The function to call, or an empty function
+   */
+  void setTableCallback(const TableCallback & callback);
+
+private:
+
+  /*!
+   * \brief Generates the tables of a material key and the material it reaches
+   *
+   * \param materialKey The material key
+   *
+   * \return true if the tables are available, false otherwise
+   */
+  bool generateMaterial(uint64_t materialKey);
+
+  /*!
+   * \brief Generates the table of a material key whose reachable tables are available
+   *
+   * \param materialKey The material key
+   *
+   * \return true if the table was generated, false otherwise
+   */
+  bool generateTable(uint64_t materialKey);
+
+  /*!
+   * \brief Visits a position in the first pass
+   *
+   * This function resolves checkmates, stalemates and placements
+   * that are not legal positions, and notes the pass at which the
+   * captures and promotions of the others decide them.
+   *
+   * \param board The board of the thread
+   * \param index The index of the position
+   *
+   * \return The value resolved, RESOLVED_DRAW, or UNRESOLVED
+   */
+  uint8_t initializeEntry(BitBoard * board, uint64_t index);
+
+  /*!
+   * \brief Returns whether every legal move of a position leads to a win counted by an earlier pass
+   *
+   * \param board The board of the thread
+   * \param index The index of the position
+   *
+   * \return true if the position is lost in the plies of the current pass, false otherwise
+   */
+  bool isLost(BitBoard * board, uint64_t index);
+
+  /*!
+   * \brief Resolves an unresolved position in the current pass
+   *
+   * On an odd pass the position wins, on an even pass it loses if
+   * \ref isLost finds every move lost.
+   *
+   * \param board The board of the thread
+   * \param index The index of the position
+   *
+   * \return 1 if the position was resolved, 0 otherwise
+   */
+  uint32_t resolveEntry(BitBoard * board, uint64_t index);
+
+  /*!
+   * \brief Resolves the positions a move can be retracted to from a resolved position
+   *
+   * \param board The board of the thread
+   * \param index The index of the position resolved by the previous pass
+   *
+   * \return The number of positions resolved
+   */
+  uint32_t retractMoves(BitBoard * board, uint64_t index);
+
+  /*!
+   * \brief Visits the positions of the current pass, a chunk at a time
+   *
+   * \param board The board of the thread
+   */
+  void runPass(BitBoard * board);
+
+  // Members
+  static constexpr uint64_t CHUNK_SIZE = 4096;        // Positions taken by a thread at a time
+  static constexpr uint8_t UNRESOLVED = 0;            // Value of a position not resolved yet
+  static constexpr uint8_t RESOLVED_DRAW = 255;       // Value of a drawn or invalid position during generation
+
+  Tablebase * mTablebase;                             // Tablebase the tables are added to
+  std::string mDirectory;                             // Directory tables are saved to
+  TableCallback mTableCallback;                       // Function called after each table
+  std::vector<std::unique_ptr<BitBoard>> mBoards;     // Board of each thread
+  const EndgameTable * mTable;                        // Table being generated
+  std::unique_ptr<std::atomic<uint8_t>[]> mValues;    // Values of the table being generated
+  std::unique_ptr<uint8_t[]> mEvents;                 // Pass at which the captures and promotions decide each position
+  uint32_t mPass;                                     // Current pass
+  std::atomic<uint64_t> mNextIndex;                   // First position of the next chunk
+  std::atomic<uint64_t> mChanges;                     // Positions resolved by the current pass
+  std::atomic<uint32_t> mLastEvent;                   // Last pass noted in the events
+};
+
+inline const std::string & TablebaseGenerator::getDirectory() const
+{
+  return mDirectory;
+}
+
+inline size_t TablebaseGenerator::getThreadCount() const
+{
+  return mBoards.size();
+}
+
+inline void TablebaseGenerator::setDirectory(const std::string & directory)
+{
+  mDirectory = directory;
+}
+
+inline void TablebaseGenerator::setTableCallback(const TableCallback & callback)
+{
+  mTableCallback = callback;
+}
+
+}
+
+#endif // #ifndef JCL_TABLEBASEGENERATOR_H
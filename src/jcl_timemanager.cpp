@@ -0,0 +1,154 @@
+/*!
+ * \file jcl_timemanager.cpp
+ *
+ * This file contains the implementation for the TimeManager object
+ */
+
+#include "jcl_timemanager.h"
+
+#include <algorithm>
+
+namespace jcl
+{
+
+// The number of moves the remaining time is spread over when the moves to go are unknown
+static const int32_t DefaultMovesToGo = 30;
+
+// The hard limit as a multiple of the optimum time
+static const int64_t HardLimitFactor = 5;
+
+// The bounds for the scale applied to the optimum time
+static const double MinScale = 0.5;
+static const double MaxScale = 3.0;
+
+// A score drop larger than this extends the time for the move
+static const int32_t ScoreDropMargin = 30;
+
+// The number of iterations with the same best move before the time is cut short
+static const int32_t StableIterationCount = 4;
+
+TimeManager::TimeManager()
+  : mPondering(false)
+  , mPonderingSeen(false)
+  , mTimeLimited(false)
+  , mBestMoveChanges(0.0)
+  , mScale(1.0)
+  , mPreviousScore(0)
+  , mStableIterations(0)
+  , mHardLimit(0)
+  , mMoveOverhead(30)
+  , mOptimumTime(0)
+{
+}
+
+int64_t TimeManager::getSoftLimit() const
+{
+  if (!mTimeLimited)
+  {
+    return 0;
+  }
+
+  int64_t softLimit = static_cast<int64_t>(mOptimumTime * mScale);
+  return std::min(softLimit, mHardLimit);
+}
+
+bool TimeManager::shouldStartIteration() const
+{
+  return (!mTimeLimited || isPondering() || getElapsed() < getSoftLimit());
+}
+
+bool TimeManager::shouldStopSearch()
+{
+  // Pondering is ended by another thread, the limits are checked once it is seen
+  if (isPondering())
+  {
+    mPonderingSeen = true;
+    return false;
+  }
+
+  if (!mTimeLimited)
+  {
+    return false;
+  }
+
+  // After a ponder hit past the soft limit no further time is spent
+  if (mPonderingSeen)
+  {
+    mPonderingSeen = false;
+    if (getElapsed() >= getSoftLimit())
+    {
+      return true;
+    }
+  }
+
+  return (getElapsed() >= mHardLimit);
+}
+
+void TimeManager::start(int64_t timeLeft, int64_t increment, int32_t movesToGo)
+{
+  startInfinite();
+  mTimeLimited = true;
+
+  int32_t moves = (movesToGo > 0) ? std::min(movesToGo, DefaultMovesToGo) : DefaultMovesToGo;
+  int64_t available = std::max<int64_t>(timeLeft - mMoveOverhead, 1);
+
+  // Most of the increment can be spent since it is returned after the move
+  mOptimumTime = std::max<int64_t>(available / moves + increment * 3 / 4, 1);
+  mHardLimit = std::min(mOptimumTime * HardLimitFactor, available * 4 / 5);
+  mOptimumTime = std::min(mOptimumTime, mHardLimit);
+}
+
+void TimeManager::startFixed(int64_t moveTime)
+{
+  startInfinite();
+  mTimeLimited = true;
+  mOptimumTime = mHardLimit = std::max<int64_t>(moveTime - mMoveOverhead, 1);
+}
+
+void TimeManager::startInfinite()
+{
+  mPonderingSeen = false;
+  mTimeLimited = false;
+  mBestMoveChanges = 0.0;
+  mScale = 1.0;
+  mPreviousScore = 0;
+  mStableIterations = 0;
+  mHardLimit = 0;
+  mOptimumTime = 0;
+  mPreviousBestMove = Move();
+  mTimer.restart();
+}
+
+void TimeManager::update(int32_t depth, int32_t score, const Move & bestMove)
+{
+  // There is nothing to scale when the limits coincide, as for fixed move times
+  if (mOptimumTime == mHardLimit)
+  {
+    return;
+  }
+
+  bool changed = (depth > 1 && (bestMove.getSourceRow() != mPreviousBestMove.getSourceRow() ||
+                                bestMove.getSourceColumn() != mPreviousBestMove.getSourceColumn() ||
+                                bestMove.getDestinationRow() != mPreviousBestMove.getDestinationRow() ||
+                                bestMove.getDestinationColumn() != mPreviousBestMove.getDestinationColumn()));
+
+  mBestMoveChanges = mBestMoveChanges / 2.0 + (changed ? 1.0 : 0.0);
+  mStableIterations = changed ? 0 : mStableIterations + 1;
+
+  double scale = 1.0 + mBestMoveChanges;
+  if (depth > 1 && score < mPreviousScore - ScoreDropMargin)
+  {
+    scale *= 1.5;
+  }
+
+  if (mStableIterations >= StableIterationCount)
+  {
+    scale *= 0.6;
+  }
+
+  mScale = std::max(MinScale, std::min(scale, MaxScale));
+  mPreviousScore = score;
+  mPreviousBestMove = bestMove;
+}
+
+}
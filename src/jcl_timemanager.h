@@ -0,0 +1,247 @@
+/*!
+ * \file jcl_timemanager.h
+ *
+ * This file contains the interface for the TimeManager object
+ */
+
+#ifndef JCL_TIMEMANAGER_H
+#define JCL_TIMEMANAGER_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "jcl_move.h"
+#include "jcl_timer.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines an object for budgeting the time for a move
+ *
+ * The TimeManager object derives the time to spend on a move from
+ * the remaining clock time, the increment and the number of moves
+ * until the next time control. It maintains two limits:
+ *
+ * - The soft limit is checked between iterations of the search. No new
+ *   iteration is started once it has passed, since an iteration that
+ *   cannot complete is wasted.
+ * - The hard limit is checked during the search, which is aborted
+ *   once it has passed.
+ *
+ * The soft limit is scaled after each iteration with \ref update. It is
+ * extended when the score drops or the best move changes between
+ * iterations, and shortened once the best move has been stable for
+ * several iterations. It never exceeds the hard limit.
+ *
+ * While pondering the limits are computed but not enforced, so the
+ * search runs until the opponent plays the expected move. Pondering
+ * can be ended from another thread while the search is running.
+ *
+ * All times are in milliseconds.
+ */
+class TimeManager
+{
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a TimeManager object with no time
+   * limit.
+   */
+  TimeManager();
+
+  /*!
+   * \brief Returns the time elapsed since the search started
+   *
+   * \return The elapsed time in milliseconds
+   */
+  int64_t getElapsed() const;
+
+  /*!
+   * \brief Returns the hard time limit
+   *
+   * \return The hard limit in milliseconds, or zero if there is no limit
+   */
+  int64_t getHardLimit() const;
+
+  /*!
+   * \brief Returns the time reserved for communication overhead
+   *
+   * \return The move overhead in milliseconds
+   */
+  int64_t getMoveOverhead() const;
+
+  /*!
+   * \brief Returns the current soft time limit
+   *
+   * This function returns the soft limit as scaled by the
+   * results of the iterations so far.
+   *
+   * \return The soft limit in milliseconds, or zero if there is no limit
+   */
+  int64_t getSoftLimit() const;
+
+  /*!
+   * \brief Returns whether the hard limit has passed
+   *
+   * \return true if the search must be aborted, false otherwise
+   */
+  bool isHardLimitReached() const;
+
+  /*!
+   * \brief Returns whether the search is pondering
+   *
+   * \return true if the limits are not enforced because of pondering, false otherwise
+   */
+  bool isPondering() const;
+
+  /*!
+   * \brief Returns whether the search is limited by time
+   *
+   * \return true if a time limit is set, false otherwise
+   */
+  bool isTimeLimited() const;
+
+  /*!
+   * \brief Sets the time reserved for communication overhead
+   *
+   * This time is subtracted from the remaining clock time when
+   * computing the limits, to allow for the delay between the
+   * engine and the clock. The default is 30 milliseconds.
+   *
+   * \param value The move overhead in milliseconds
+   */
+  void setMoveOverhead(int64_t value);
+
+  /*!
+   * \brief Sets whether the search is pondering
+   *
+   * This function may be called from another thread while the
+   * search is running. The time spent pondering counts towards the
+   * limits once pondering ends.
+   *
+   * \param value true while pondering, false otherwise
+   */
+  void setPondering(bool value);
+
+  /*!
+   * \brief Returns whether another iteration should be started
+   *
+   * \return true if the soft limit has not yet passed, false otherwise
+   */
+  bool shouldStartIteration() const;
+
+  /*!
+   * \brief Returns whether the running search should be aborted
+   *
+   * This function is called by the search thread only. It reports
+   * when the hard limit has passed. When pondering has ended since
+   * the last call and the soft limit has already passed, it also
+   * reports that the search should stop, since the current
+   * iteration would not have been started. All fields other than
+   * the pondering flag are therefore only accessed by the search
+   * thread.
+   *
+   * \return true if the search must be aborted, false otherwise
+   */
+  bool shouldStopSearch();
+
+  /*!
+   * \brief Starts timing a move played with a clock
+   *
+   * This function computes the limits for the move and starts the
+   * timer. When the number of moves to go is unknown the remaining
+   * time is assumed to last for a fixed number of moves.
+   *
+   * \param timeLeft The time remaining on the clock
+   * \param increment The increment added after each move
+   * \param movesToGo The number of moves until the next time control, or zero
+   */
+  void start(int64_t timeLeft, int64_t increment, int32_t movesToGo);
+
+  /*!
+   * \brief Starts timing a move with a fixed time
+   *
+   * Both limits are set to the supplied time less the move overhead.
+   *
+   * \param moveTime The time to spend on the move
+   */
+  void startFixed(int64_t moveTime);
+
+  /*!
+   * \brief Starts timing a move without a time limit
+   *
+   * The limits are never reached, but the elapsed time is still
+   * measured.
+   */
+  void startInfinite();
+
+  /*!
+   * \brief Updates the soft limit after a completed iteration
+   *
+   * \param depth The depth of the iteration
+   * \param score The score of the iteration
+   * \param bestMove The best move of the iteration
+   */
+  void update(int32_t depth, int32_t score, const Move & bestMove);
+
+private:
+  std::atomic<bool> mPondering;
+  bool mPonderingSeen;            // Whether the search thread has seen the search pondering
+  bool mTimeLimited;
+  double mBestMoveChanges;        // Decaying count of best move changes between iterations
+  double mScale;                  // Current scale applied to the optimum time
+  int32_t mPreviousScore;
+  int32_t mStableIterations;      // Number of iterations the best move has not changed
+  int64_t mHardLimit;
+  int64_t mMoveOverhead;
+  int64_t mOptimumTime;           // The soft limit before scaling
+  Move mPreviousBestMove;
+  Timer mTimer;
+};
+
+inline int64_t TimeManager::getElapsed() const
+{
+  return mTimer.elapsedMilliseconds();
+}
+
+inline int64_t TimeManager::getHardLimit() const
+{
+  return mHardLimit;
+}
+
+inline int64_t TimeManager::getMoveOverhead() const
+{
+  return mMoveOverhead;
+}
+
+inline bool TimeManager::isHardLimitReached() const
+{
+  return (mTimeLimited && !isPondering() && getElapsed() >= mHardLimit);
+}
+
+inline bool TimeManager::isPondering() const
+{
+  return mPondering.load(std::memory_order_relaxed);
+}
+
+inline bool TimeManager::isTimeLimited() const
+{
+  return mTimeLimited;
+}
+
+inline void TimeManager::setMoveOverhead(int64_t value)
+{
+  mMoveOverhead = value;
+}
+
+inline void TimeManager::setPondering(bool value)
+{
+  mPondering.store(value, std::memory_order_relaxed);
+}
+
+}
+
+#endif // #ifndef JCL_TIMEMANAGER_H
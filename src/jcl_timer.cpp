@@ -21,6 +21,16 @@ double Timer::elapsed() const
   return mElapsed; 
 }
 
+int64_t Timer::elapsedMilliseconds() const
+{
+  int64_t elapsed = static_cast<int64_t>(mElapsed) / 1000;
+  if (mStarted)
+  {
+    elapsed += std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - mStart).count();
+  }
+  return elapsed;
+}
+
 void Timer::reset()
 {
   mElapsed = 0.0;
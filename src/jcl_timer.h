@@ -8,6 +8,7 @@
 #define JCL_TIMER_H
 
 #include <chrono>
+#include <cstdint>
 
 namespace jcl
 {
@@ -17,7 +18,8 @@ namespace jcl
  *
  * The Timer object defines a high resolution timer
  * that can be used to measure performance of particular
- * algorithms or routines.
+ * algorithms or routines. The timer uses a monotonic clock
+ * so it is not affected by changes to the system time.
  */
 class Timer
 {
@@ -39,13 +41,25 @@ public:
   /*!
    * \brief Returns the elapsed time
    *
-   * This function returns the amount of time that has elasped
-   * since the timer was started.
+   * This function returns the amount of time in microseconds
+   * accumulated between calls to \ref start and \ref stop.
    *
    * \return The elapsed time
    */
   double elapsed() const;
 
+  /*!
+   * \brief Returns the elapsed time in milliseconds
+   *
+   * This function returns the accumulated time in milliseconds,
+   * including the time since the timer was last started if it is
+   * still running. It does not stop the timer, so it can be used
+   * to poll a running timer.
+   *
+   * \return The elapsed time in milliseconds
+   */
+  int64_t elapsedMilliseconds() const;
+
   /*!
    * \brief Resets the timer
    *
@@ -82,8 +96,8 @@ public:
 
 private:
 
-  using clock = std::chrono::high_resolution_clock;
-  using time_point = std::chrono::high_resolution_clock::time_point;
+  using clock = std::chrono::steady_clock;
+  using time_point = std::chrono::steady_clock::time_point;
 
   time_point mStart;
   double mElapsed;
@@ -0,0 +1,146 @@
+/*!
+ * \file jcl_transpositiontable.cpp
+ *
+ * This file contains the implementation for the TranspositionTable object
+ */
+
+#include "jcl_transpositiontable.h"
+
+namespace jcl
+{
+
+// Layout of the packed entry data
+//   bits  0-31  score
+//   bits 32-39  depth
+//   bits 40-41  bound
+//   bits 42-47  age
+//   bits 48-53  move source square
+//   bits 54-59  move destination square
+//   bits 60-62  move promoted piece
+//   bit  63     move present
+static const uint32_t DepthShift = 32;
+static const uint32_t BoundShift = 40;
+static const uint32_t AgeShift = 42;
+static const uint32_t MoveShift = 48;
+static const uint64_t MovePresent = 1ULL << 63;
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+  : mAge(0)
+  , mEntryCount(0)
+  , mSize(0)
+{
+  resize(megabytes);
+}
+
+void TranspositionTable::clear()
+{
+  for (size_t i = 0; i < mEntryCount; i++)
+  {
+    mEntries[i].key.store(0, std::memory_order_relaxed);
+    mEntries[i].data.store(0, std::memory_order_relaxed);
+  }
+  mAge = 0;
+}
+
+uint32_t TranspositionTable::getHashFull() const
+{
+  size_t sampleCount = (mEntryCount < 1000) ? mEntryCount : 1000;
+
+  uint32_t used = 0;
+  for (size_t i = 0; i < sampleCount; i++)
+  {
+    uint64_t data = mEntries[i].data.load(std::memory_order_relaxed);
+    uint8_t bound = (data >> BoundShift) & 0x03;
+    uint8_t age = (data >> AgeShift) & 0x3f;
+    if (bound != 0 && age == mAge)
+    {
+      used++;
+    }
+  }
+
+  return (sampleCount == 0) ? 0 : static_cast<uint32_t>(used * 1000 / sampleCount);
+}
+
+void TranspositionTable::newSearch()
+{
+  mAge = (mAge + 1) & 0x3f;
+}
+
+bool TranspositionTable::probe(uint64_t key, Data & data) const
+{
+  const Entry & entry = mEntries[key & (mEntryCount - 1)];
+  uint64_t packed = entry.data.load(std::memory_order_relaxed);
+  if ((entry.key.load(std::memory_order_relaxed) ^ packed) != key || packed == 0)
+  {
+    return false;
+  }
+
+  uint8_t sourceSquare = (packed >> MoveShift) & 0x3f;
+  uint8_t destinationSquare = (packed >> (MoveShift + 6)) & 0x3f;
+  data.score = static_cast<int32_t>(static_cast<uint32_t>(packed));
+  data.depth = static_cast<int32_t>((packed >> DepthShift) & 0xff);
+  data.bound = static_cast<Bound>((packed >> BoundShift) & 0x03);
+  data.hasMove = (packed & MovePresent) != 0;
+  data.sourceRow = sourceSquare >> 3;
+  data.sourceColumn = sourceSquare & 7;
+  data.destinationRow = destinationSquare >> 3;
+  data.destinationColumn = destinationSquare & 7;
+  data.promotedPiece = static_cast<Piece>((packed >> (MoveShift + 12)) & 0x07);
+  return true;
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+  // The entry count is a power of two so the index is a mask of the key
+  size_t bytes = ((megabytes > 0) ? megabytes : 1) * 1024 * 1024;
+  size_t entryCount = 1;
+  while (entryCount * 2 * sizeof(Entry) <= bytes)
+  {
+    entryCount *= 2;
+  }
+
+  mEntries.reset(new Entry[entryCount]);
+  mEntryCount = entryCount;
+  mSize = megabytes;
+  clear();
+}
+
+void TranspositionTable::store(uint64_t key, int32_t depth, int32_t score, Bound bound, const Move * move)
+{
+  Entry & entry = mEntries[key & (mEntryCount - 1)];
+  uint64_t oldData = entry.data.load(std::memory_order_relaxed);
+  bool samePosition = ((entry.key.load(std::memory_order_relaxed) ^ oldData) == key);
+
+  // Keep deeper results for other positions from the current search
+  uint8_t oldAge = (oldData >> AgeShift) & 0x3f;
+  int32_t oldDepth = static_cast<int32_t>((oldData >> DepthShift) & 0xff);
+  if (!samePosition && oldAge == mAge && oldDepth > depth)
+  {
+    return;
+  }
+
+  depth = (depth < 0) ? 0 : ((depth > 255) ? 255 : depth);
+  uint64_t data = static_cast<uint32_t>(score);
+  data |= static_cast<uint64_t>(depth) << DepthShift;
+  data |= static_cast<uint64_t>(bound) << BoundShift;
+  data |= static_cast<uint64_t>(mAge) << AgeShift;
+  if (move != nullptr)
+  {
+    uint64_t sourceSquare = (move->getSourceRow() << 3) + move->getSourceColumn();
+    uint64_t destinationSquare = (move->getDestinationRow() << 3) + move->getDestinationColumn();
+    data |= sourceSquare << MoveShift;
+    data |= destinationSquare << (MoveShift + 6);
+    data |= static_cast<uint64_t>(move->getPromotedPiece()) << (MoveShift + 12);
+    data |= MovePresent;
+  }
+  else if (samePosition)
+  {
+    // Keep the best move found by an earlier search of the position
+    data |= oldData & (0xffffULL << MoveShift);
+  }
+
+  entry.key.store(key ^ data, std::memory_order_relaxed);
+  entry.data.store(data, std::memory_order_relaxed);
+}
+
+}
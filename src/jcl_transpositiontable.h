@@ -0,0 +1,166 @@
+/*!
+ * \file jcl_transpositiontable.h
+ *
+ * This file contains the interface for the TranspositionTable object
+ */
+
+#ifndef JCL_TRANSPOSITIONTABLE_H
+#define JCL_TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "jcl_move.h"
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines a table of search results indexed by position hash
+ *
+ * The TranspositionTable object stores the result of searching a
+ * position, so that the result can be reused when the position is
+ * reached again through a different move order, or in a later
+ * iteration of the search. Each entry holds the score, the depth it
+ * was searched to, whether the score is exact or a bound, and the
+ * best move found.
+ *
+ * The table can be shared by several searches running on different
+ * threads without locking. Each entry is stored as two 64-bit words,
+ * with the key stored exclusive-or the data, so an entry torn by
+ * simultaneous writes fails the key comparison and is ignored.
+ */
+class TranspositionTable
+{
+public:
+
+  /*!
+   * \brief Defines the kind of score stored in an entry
+   */
+  enum class Bound : uint8_t
+  {
+    None = 0,  /*!< No score is stored */
+    Upper = 1, /*!< The score is an upper bound, all moves failed low */
+    Lower = 2, /*!< The score is a lower bound, a move failed high */
+    Exact = 3  /*!< The score is exact */
+  };
+
+  /*!
+   * \brief Defines the contents of an entry
+   */
+  struct Data
+  {
+    int32_t score;            /*!< The score of the position */
+    int32_t depth;            /*!< The depth the position was searched to */
+    Bound bound;              /*!< The kind of score */
+    bool hasMove;             /*!< Whether a best move is stored */
+    uint8_t sourceRow;        /*!< The source row of the best move */
+    uint8_t sourceColumn;     /*!< The source column of the best move */
+    uint8_t destinationRow;   /*!< The destination row of the best move */
+    uint8_t destinationColumn;/*!< The destination column of the best move */
+    Piece promotedPiece;      /*!< The promoted piece of the best move */
+  };
+
+public:
+
+  /*!
+   * \brief Constructor
+   *
+   * This function constructs a TranspositionTable object of the
+   * specified size.
+   *
+   * \param megabytes The size of the table in megabytes
+   */
+  TranspositionTable(size_t megabytes = 16);
+
+  /*!
+   * \brief Clears the table
+   */
+  void clear();
+
+  /*!
+   * \brief Returns how full the table is
+   *
+   * This function samples the first thousand entries and counts
+   * those written during the current search.
+   *
+   * \return The number of sampled entries in use, per thousand
+   */
+  uint32_t getHashFull() const;
+
+  /*!
+   * \brief Returns the size of the table
+   *
+   * \return The size of the table in megabytes
+   */
+  size_t getSize() const;
+
+  /*!
+   * \brief Starts a new search
+   *
+   * This function ages the table, so that entries written during
+   * earlier searches are replaced first.
+   */
+  void newSearch();
+
+  /*!
+   * \brief Looks up a position
+   *
+   * \param key The hash key of the position
+   * \param data The data stored for the position
+   *
+   * \return true if the position was found, false otherwise
+   */
+  bool probe(uint64_t key, Data & data) const;
+
+  /*!
+   * \brief Resizes the table
+   *
+   * This function reallocates the table with the specified size,
+   * which discards all entries. The table must not be in use by a
+   * search.
+   *
+   * \param megabytes The size of the table in megabytes
+   */
+  void resize(size_t megabytes);
+
+  /*!
+   * \brief Stores the result of searching a position
+   *
+   * An existing entry for a different position is only replaced
+   * if it is from an earlier search or was searched less deeply.
+   *
+   * \param key The hash key of the position
+   * \param depth The depth the position was searched to
+   * \param score The score of the position
+   * \param bound The kind of score
+   * \param move The best move, or nullptr
+   */
+  void store(uint64_t key, int32_t depth, int32_t score, Bound bound, const Move * move);
+
+private:
+
+  struct Entry
+  {
+    std::atomic<uint64_t> key;   // Position key exclusive-or the data
+    std::atomic<uint64_t> data;  // Packed entry data
+  };
+
+private:
+  uint8_t mAge;
+  size_t mEntryCount;
+  size_t mSize;
+  std::unique_ptr<Entry[]> mEntries;
+};
+
+inline size_t TranspositionTable::getSize() const
+{
+  return mSize;
+}
+
+}
+
+#endif // #ifndef JCL_TRANSPOSITIONTABLE_H
@@ -73,6 +73,55 @@ enum class PieceType : int32_t
   BlackKing = 12     /*!< Defines a black king */
 };
 
+/*!
+ * \brief Defines a packed evaluation score
+ *
+ * A Score holds a midgame and an endgame value in a single
+ * integer, so that evaluation terms for both phases of the game
+ * are added together in one operation. The midgame value is held
+ * in the low 16 bits and the endgame value in the high 16 bits,
+ * and each must stay within the range of a 16-bit integer. Scores
+ * may be added, subtracted and negated as plain integers.
+ */
+typedef int32_t Score;
+
+/*!
+ * \brief Creates a packed score
+ *
+ * \param midgame The midgame value
+ * \param endgame The endgame value
+ *
+ * \return The packed score
+ */
+constexpr Score makeScore(int32_t midgame, int32_t endgame)
+{
+  return static_cast<Score>(static_cast<uint32_t>(endgame) << 16) + midgame;
+}
+
+/*!
+ * \brief Returns the endgame value of a packed score
+ *
+ * \param score The packed score
+ *
+ * \return The endgame value
+ */
+constexpr int32_t getEndgameValue(Score score)
+{
+  return static_cast<int16_t>(static_cast<uint16_t>((static_cast<uint32_t>(score) + 0x8000) >> 16));
+}
+
+/*!
+ * \brief Returns the midgame value of a packed score
+ *
+ * \param score The packed score
+ *
+ * \return The midgame value
+ */
+constexpr int32_t getMidgameValue(Score score)
+{
+  return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score)));
+}
+
 }
 
 #endif // #ifndef JCL_TYPES_H
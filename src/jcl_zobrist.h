@@ -0,0 +1,159 @@
+/*!
+ * \file jcl_zobrist.h
+ *
+ * This file contains the interface for the Zobrist object
+ */
+
+#ifndef JCL_ZOBRIST_H
+#define JCL_ZOBRIST_H
+
+#include <cstdint>
+
+#include "jcl_types.h"
+
+namespace jcl
+{
+
+/*!
+ * \brief Defines the table of Zobrist keys
+ *
+ * The keys are generated at compile time from a fixed seed
+ * so hash values are identical between runs and builds.
+ */
+struct ZobristKeys
+{
+  uint64_t pieces[13][64];  // Keys indexed by PieceType and square index
+  uint64_t castling[16];    // Keys for each combination of castling rights
+  uint64_t enPassant[9];    // Keys for each en-passant column, the last is zero
+  uint64_t side;            // Key applied when black is to move
+
+  constexpr ZobristKeys()
+    : pieces()
+    , castling()
+    , enPassant()
+    , side(0)
+  {
+    uint64_t state = 0x6a63686573733031ULL;
+    for (int i = 1; i < 13; i++)
+    {
+      for (int j = 0; j < 64; j++)
+      {
+        pieces[i][j] = next(state);
+      }
+    }
+
+    // Castling keys are composed from one key per right
+    uint64_t rights[4] = { next(state), next(state), next(state), next(state) };
+    for (int i = 0; i < 16; i++)
+    {
+      for (int j = 0; j < 4; j++)
+      {
+        if (i & (1 << j))
+        {
+          castling[i] ^= rights[j];
+        }
+      }
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+      enPassant[i] = next(state);
+    }
+
+    side = next(state);
+  }
+
+  // SplitMix64 generator
+  static constexpr uint64_t next(uint64_t & state)
+  {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+};
+
+/*!
+ * \brief Defines the Zobrist hashing keys
+ *
+ * The Zobrist object provides the random keys used to compute
+ * a 64-bit hash of a board position. The hash of a position is
+ * the exclusive-or of the key for each piece on its square, the
+ * key for the castling rights, the key for the en-passant column
+ * and the side key when black is to move. Since exclusive-or is its
+ * own inverse the hash can be updated incrementally as moves are
+ * made and unmade.
+ */
+class Zobrist
+{
+public:
+
+  /*!
+   * \brief Returns the key for a set of castling rights
+   *
+   * \param castlingRights The castling rights
+   *
+   * \return The key for the castling rights
+   */
+  static uint64_t getCastlingKey(uint8_t castlingRights);
+
+  /*!
+   * \brief Returns the key for an en-passant column
+   *
+   * The key for Board::INVALID_ENPASSANT_COLUMN is zero.
+   *
+   * \param column The en-passant column
+   *
+   * \return The key for the en-passant column
+   */
+  static uint64_t getEnPassantKey(uint8_t column);
+
+  /*!
+   * \brief Returns the key for a piece on a square
+   *
+   * The key for PieceType::None is zero.
+   *
+   * \param pieceType The piece type
+   * \param row The row of the square
+   * \param col The column of the square
+   *
+   * \return The key for the piece on the square
+   */
+  static uint64_t getPieceKey(PieceType pieceType, uint8_t row, uint8_t col);
+
+  /*!
+   * \brief Returns the side to move key
+   *
+   * This key is included in the hash when black is to move.
+   *
+   * \return The side to move key
+   */
+  static uint64_t getSideKey();
+
+private:
+  static constexpr ZobristKeys mKeys{};
+};
+
+inline uint64_t Zobrist::getCastlingKey(uint8_t castlingRights)
+{
+  return mKeys.castling[castlingRights & 0x0f];
+}
+
+inline uint64_t Zobrist::getEnPassantKey(uint8_t column)
+{
+  return mKeys.enPassant[column];
+}
+
+inline uint64_t Zobrist::getPieceKey(PieceType pieceType, uint8_t row, uint8_t col)
+{
+  return mKeys.pieces[static_cast<int>(pieceType)][(row << 3) + col];
+}
+
+inline uint64_t Zobrist::getSideKey()
+{
+  return mKeys.side;
+}
+
+}
+
+#endif // #ifndef JCL_ZOBRIST_H
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Generates the king and pawn against king bitbase at build time and writes
+// it as a source file of the jcl library (see jcl_bitbase.h).
+//
+// White has the pawn. Squares are numbered row * 8 + column, a1 being 0,
+// and the pawn is mirrored to files a-d, so a position is indexed by the
+// side to move, the black king, the white king and one of 24 pawn squares.
+// Positions are classified by retrograde iteration: a position with white
+// to move is won if a move reaches a won position, and drawn if every move
+// reaches a drawn one. With black to move it is drawn if a move reaches a
+// drawn position, and won if every move reaches a won one. Positions still
+// unknown when an iteration changes nothing can never be forced, so they
+// are drawn.
+
+enum Result : uint8_t
+{
+  Invalid,
+  Unknown,
+  Draw,
+  Win
+};
+
+static const int White = 0;
+static const int Black = 1;
+static const uint32_t PositionCount = 2 * 64 * 64 * 24;
+
+static int getRow(int square)
+{
+  return square >> 3;
+}
+
+static int getColumn(int square)
+{
+  return square & 7;
+}
+
+static int getDistance(int first, int second)
+{
+  return std::max(std::abs(getRow(first) - getRow(second)), std::abs(getColumn(first) - getColumn(second)));
+}
+
+// Must match the index computed by Bitbase::probeKPK
+static uint32_t getIndex(int sideToMove, int blackKing, int whiteKing, int pawn)
+{
+  uint32_t pawnSlot = static_cast<uint32_t>((getRow(pawn) - 1) * 4 + getColumn(pawn));
+  return static_cast<uint32_t>(sideToMove) + 2 * (static_cast<uint32_t>(blackKing) + 64 * (static_cast<uint32_t>(whiteKing) + 64 * pawnSlot));
+}
+
+static bool isPawnAttack(int pawn, int square)
+{
+  return getRow(square) == getRow(pawn) + 1 && std::abs(getColumn(square) - getColumn(pawn)) == 1;
+}
+
+// Returns the squares a king can step to, ignoring attacks
+static std::vector<int> getKingSteps(int square)
+{
+  std::vector<int> steps;
+  for (int row = getRow(square) - 1; row <= getRow(square) + 1; row++)
+  {
+    for (int col = getColumn(square) - 1; col <= getColumn(square) + 1; col++)
+    {
+      if (row >= 0 && row < 8 && col >= 0 && col < 8 && (row != getRow(square) || col != getColumn(square)))
+      {
+        steps.push_back(row * 8 + col);
+      }
+    }
+  }
+  return steps;
+}
+
+// Classifies the positions decided without looking at the moves
+static Result classifyInitial(int sideToMove, int blackKing, int whiteKing, int pawn)
+{
+  if (getDistance(whiteKing, blackKing) <= 1 || whiteKing == pawn || blackKing == pawn ||
+      (sideToMove == White && isPawnAttack(pawn, blackKing)))
+  {
+    return Invalid;
+  }
+
+  // The pawn promotes safely
+  int queening = pawn + 8;
+  if (sideToMove == White && getRow(pawn) == 6 && queening != whiteKing && queening != blackKing &&
+      (getDistance(blackKing, queening) > 1 || getDistance(whiteKing, queening) == 1))
+  {
+    return Win;
+  }
+
+  if (sideToMove == Black)
+  {
+    // Stalemate, the pawn cannot give mate on its own
+    bool hasMove = false;
+    for (int square : getKingSteps(blackKing))
+    {
+      bool attacked = getDistance(square, whiteKing) <= 1 || isPawnAttack(pawn, square);
+      hasMove = hasMove || !attacked;
+    }
+
+    // The pawn is captured
+    if (!hasMove || (getDistance(blackKing, pawn) == 1 && getDistance(whiteKing, pawn) > 1))
+    {
+      return Draw;
+    }
+  }
+
+  return Unknown;
+}
+
+// Classifies a position from the results of its moves
+static Result classify(const std::vector<Result> & results, int sideToMove, int blackKing, int whiteKing, int pawn)
+{
+  bool anyWin = false;
+  bool anyDraw = false;
+  bool allWin = true;
+  bool allDraw = true;
+  auto visit = [&](Result result)
+  {
+    if (result == Invalid)
+    {
+      return;
+    }
+    anyWin = anyWin || (result == Win);
+    anyDraw = anyDraw || (result == Draw);
+    allWin = allWin && (result == Win);
+    allDraw = allDraw && (result == Draw);
+  };
+
+  if (sideToMove == White)
+  {
+    for (int square : getKingSteps(whiteKing))
+    {
+      if (square != pawn)
+      {
+        visit(results[getIndex(Black, blackKing, square, pawn)]);
+      }
+    }
+
+    if (getRow(pawn) < 6 && pawn + 8 != whiteKing && pawn + 8 != blackKing)
+    {
+      visit(results[getIndex(Black, blackKing, whiteKing, pawn + 8)]);
+      if (getRow(pawn) == 1 && pawn + 16 != whiteKing && pawn + 16 != blackKing)
+      {
+        visit(results[getIndex(Black, blackKing, whiteKing, pawn + 16)]);
+      }
+    }
+    return anyWin ? Win : (allDraw ? Draw : Unknown);
+  }
+
+  for (int square : getKingSteps(blackKing))
+  {
+    if (square != pawn)
+    {
+      visit(results[getIndex(White, square, whiteKing, pawn)]);
+    }
+  }
+  return anyDraw ? Draw : (allWin ? Win : Unknown);
+}
+
+int main(int argc, char ** argv)
+{
+  if (argc != 2)
+  {
+    std::cerr << "Usage: jcl_kpkgen output" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Result> results(PositionCount, Invalid);
+  for (int pawn = 8; pawn < 56; pawn++)
+  {
+    if (getColumn(pawn) > 3)
+    {
+      continue;
+    }
+
+    for (int whiteKing = 0; whiteKing < 64; whiteKing++)
+    {
+      for (int blackKing = 0; blackKing < 64; blackKing++)
+      {
+        for (int sideToMove = White; sideToMove <= Black; sideToMove++)
+        {
+          results[getIndex(sideToMove, blackKing, whiteKing, pawn)] = classifyInitial(sideToMove, blackKing, whiteKing, pawn);
+        }
+      }
+    }
+  }
+
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (uint32_t index = 0; index < PositionCount; index++)
+    {
+      if (results[index] != Unknown)
+      {
+        continue;
+      }
+
+      int sideToMove = index & 1;
+      int blackKing = (index >> 1) & 63;
+      int whiteKing = (index >> 7) & 63;
+      uint32_t pawnSlot = index >> 13;
+      int pawn = static_cast<int>((pawnSlot / 4 + 1) * 8 + pawnSlot % 4);
+      Result result = classify(results, sideToMove, blackKing, whiteKing, pawn);
+      if (result != Unknown)
+      {
+        results[index] = result;
+        changed = true;
+      }
+    }
+  }
+
+  std::ofstream outputStream(argv[1]);
+  outputStream << "// Generated by jcl_kpkgen, do not edit\n\n";
+  outputStream << "#include \"jcl_bitbase.h\"\n\n";
+  outputStream << "namespace jcl\n{\n\n";
+  outputStream << "const uint32_t Bitbase::KPK_TABLE[Bitbase::KPK_WORDS] =\n{";
+  for (uint32_t word = 0; word < PositionCount / 32; word++)
+  {
+    uint32_t bits = 0;
+    for (uint32_t bit = 0; bit < 32; bit++)
+    {
+      bits |= (results[word * 32 + bit] == Win) ? (1u << bit) : 0u;
+    }
+    outputStream << ((word % 8 == 0) ? "\n  " : " ") << "0x" << std::hex << std::setw(8) << std::setfill('0') << bits << ",";
+  }
+  outputStream << "\n};\n\n}\n";
+
+  return outputStream ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,6 +1,13 @@
+#include <cstdlib>
+
 #include "gtest/gtest.h"
 
 #include "jcl_bitboard.h"
+#include "jcl_board8x8.h"
+#include "jcl_evaluation.h"
+#include "jcl_materialtable.h"
+#include "jcl_piecesquare.h"
+#include "jcl_zobrist.h"
 
 #define ONE 1LL
 
@@ -1305,6 +1312,299 @@ TEST_F(BitboardTest, TestUnmakeBlackQueenCastle)
   testPieces(blackQueenSide);
 }
 
+TEST_F(BitboardTest, TestNullMove)
+{
+  char pieces[] =
+  {
+   'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r',
+   'p', 'p', 'p', 'p', '-', 'p', 'p', 'p',
+   '-', '-', '-', '-', '-', '-', '-', '-',
+   '-', '-', '-', '-', 'p', '-', '-', '-',
+   '-', '-', '-', '-', '-', '-', '-', '-',
+   '-', '-', '-', '-', '-', '-', '-', '-',
+   'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P',
+   'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R'
+  };
+
+  mBitBoard.setPosition("rnbqkbnr/pppp1ppp/8/4p3/8/8/PPPPPPPP/RNBQKBNR w KQkq e6 0 2");
+  uint64_t hashKey = mBitBoard.getHashKey();
+
+  jcl::Move move = mBitBoard.getNullMove();
+  mBitBoard.makeMove(&move);
+
+  testBitboards(pieces);
+  testPieces(pieces);
+  EXPECT_EQ(mBitBoard.getSideToMove(), jcl::Color::Black);
+  EXPECT_EQ(mBitBoard.getEnpassantColumn(), jcl::Board::INVALID_ENPASSANT_COLUMN);
+  EXPECT_NE(mBitBoard.getHashKey(), hashKey);
+
+  mBitBoard.unmakeMove(&move);
+
+  testBitboards(pieces);
+  testPieces(pieces);
+  EXPECT_EQ(mBitBoard.getSideToMove(), jcl::Color::White);
+  EXPECT_EQ(mBitBoard.getEnpassantColumn(), 4);
+  EXPECT_EQ(mBitBoard.getHashKey(), hashKey);
+}
+
+TEST_F(BitboardTest, TestRepetition)
+{
+  mBitBoard.setPosition("4k3/8/8/8/8/8/8/1N2K1n1 w - - 0 1");
+
+  const char * shuffle[] = { "b1c3", "g1f3", "c3b1", "f3g1", "b1c3", "g1f3", "c3b1", "f3g1" };
+  std::vector<jcl::Move> moves;
+  jcl::Board & board = mBitBoard;
+  for (const char * notation : shuffle)
+  {
+    jcl::MoveList moveList;
+    board.generateMoves(moveList);
+    for (uint32_t i = 0; i < moveList.size(); i++)
+    {
+      if (moveList[i]->toSmithNotation() == notation)
+      {
+        moves.push_back(*moveList[i]);
+      }
+    }
+    ASSERT_FALSE(moves.empty());
+    board.makeMove(&moves.back());
+
+    // Each position repeats four plies later, the start position again after eight
+    uint32_t ply = static_cast<uint32_t>(moves.size());
+    EXPECT_EQ(board.isRepetition(), ply >= 4) << ply;
+    EXPECT_EQ(board.isRepetition(2), ply == 8) << ply;
+  }
+
+  EXPECT_FALSE(board.isDrawByFiftyMove());
+  while (!moves.empty())
+  {
+    board.unmakeMove(&moves.back());
+    moves.pop_back();
+  }
+  EXPECT_FALSE(board.isRepetition());
+
+  mBitBoard.setPosition("4k3/8/8/8/8/8/8/1N2K1n1 w - - 100 80");
+  EXPECT_TRUE(board.isDrawByFiftyMove());
+}
+
+TEST_F(BitboardTest, TestDrawByRepetition)
+{
+  mBitBoard.setPosition("4k3/8/8/8/8/8/8/1N2K1n1 w - - 0 1");
+
+  jcl::Board & board = mBitBoard;
+  std::vector<jcl::Move> moves;
+  auto makeMove = [&board, &moves](const char * notation)
+  {
+    moves.push_back(board.getNullMove());
+    jcl::MoveList moveList;
+    board.generateMoves(moveList);
+    for (uint32_t i = 0; i < moveList.size(); i++)
+    {
+      if (moveList[i]->toSmithNotation() == notation)
+      {
+        moves.back() = *moveList[i];
+      }
+    }
+    board.makeMove(&moves.back());
+  };
+
+  // A position reached after the root is drawn on its first repeat,
+  // one from the game history on its second
+  const char * shuffle[] = { "b1c3", "g1f3", "c3b1", "f3g1", "b1c3", "g1f3", "c3b1", "f3g1" };
+  for (uint32_t ply = 1; ply <= 8; ply++)
+  {
+    makeMove(shuffle[ply - 1]);
+    EXPECT_EQ(board.isDrawByRepetition(0), ply >= 5) << ply;
+    EXPECT_EQ(board.isDrawByRepetition(4), ply == 8) << ply;
+    EXPECT_EQ(board.isDrawByRepetition(8), ply == 8) << ply;
+  }
+
+  // Positions before a null move are not compared
+  mBitBoard.setPosition("4k3/8/8/8/8/8/8/1N2K1n1 w - - 0 1");
+  moves.clear();
+  makeMove("null");
+  makeMove("g1f3");
+  makeMove("null");
+  makeMove("f3g1");
+  EXPECT_EQ(board.getHistorySize(), 4u);
+  EXPECT_FALSE(board.isRepetition());
+  EXPECT_FALSE(board.isDrawByRepetition(0));
+
+  board.unmakeMove(&moves.back());
+  moves.pop_back();
+  board.unmakeMove(&moves.back());
+  moves.pop_back();
+  makeMove("b1c3");
+  makeMove("f3g1");
+  makeMove("c3b1");
+  EXPECT_TRUE(board.isDrawByRepetition(0));
+}
+
+TEST_F(BitboardTest, TestMobility)
+{
+  // Pawn attacks do not wrap around the edge files
+  mBitBoard.setPosition("4k3/p6p/8/8/8/8/P3P2P/4K3 w - - 0 1");
+  uint64_t whiteAttacks = jcl::BitBoard::getPawnAttacks(mBitBoard.getPawns(jcl::Color::White), jcl::Color::White);
+  uint64_t blackAttacks = jcl::BitBoard::getPawnAttacks(mBitBoard.getPawns(jcl::Color::Black), jcl::Color::Black);
+  EXPECT_EQ(jcl::popCount(whiteAttacks), 4u);
+  EXPECT_EQ(jcl::popCount(blackAttacks), 2u);
+  for (uint8_t row = 0; row < 8; row++)
+  {
+    for (uint8_t col = 0; col < 8; col++)
+    {
+      uint64_t mask = ONE << (row * 8 + 7 - col);
+      bool whitePawnAttack = (row == 2 && (col == 1 || col == 3 || col == 5 || col == 6));
+      bool blackPawnAttack = (row == 5 && (col == 1 || col == 6));
+      EXPECT_EQ((whiteAttacks & mask) != 0, whitePawnAttack);
+      EXPECT_EQ((blackAttacks & mask) != 0, blackPawnAttack);
+    }
+  }
+
+  // Mirrored positions evaluate to opposite scores with mobility included
+  jcl::Evaluation evaluation;
+  mBitBoard.setPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  EXPECT_EQ(evaluation.evaluateBoard(&mBitBoard), 0);
+  mBitBoard.setPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  int32_t whiteScore = evaluation.evaluateBoard(&mBitBoard);
+  mBitBoard.setPosition("r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq - 0 1");
+  EXPECT_EQ(evaluation.evaluateBoard(&mBitBoard), -whiteScore);
+
+  // Only the bitboard scores mobility, which favours white with two active bishops;
+  // black keeps a pawn so the position is not evaluated as a won endgame
+  jcl::Board8x8 board8x8;
+  const char * fen = "4k3/7p/8/8/8/1P6/PBP5/4K2B w - - 0 1";
+  mBitBoard.setPosition(fen);
+  board8x8.setPosition(fen);
+  EXPECT_EQ(mBitBoard.getBitBoard(), &mBitBoard);
+  EXPECT_EQ(board8x8.getBitBoard(), nullptr);
+
+  // Boards without bitboards scan their pieces into the same layout
+  uint64_t scanned[12];
+  EXPECT_EQ(mBitBoard.getPieceBitboards(scanned), mBitBoard.getBitboards());
+  EXPECT_EQ(board8x8.getPieceBitboards(scanned), scanned);
+  for (uint32_t i = 0; i < 12; i++)
+  {
+    EXPECT_EQ(scanned[i], mBitBoard.getBitboards()[i]);
+  }
+  EXPECT_GT(evaluation.evaluateBoard(&mBitBoard), evaluation.evaluateBoard(&board8x8));
+}
+
+TEST_F(BitboardTest, TestKingSafety)
+{
+  // The difference from the mailbox board leaves only the attack terms,
+  // which are compared for the black king on g8 and on a8
+  jcl::Evaluation evaluation;
+  jcl::Board8x8 board8x8;
+  auto evaluateAttacks = [&](const char * fen)
+  {
+    mBitBoard.setPosition(fen);
+    board8x8.setPosition(fen);
+    return evaluation.evaluateBoard(&mBitBoard) - evaluation.evaluateBoard(&board8x8);
+  };
+
+  // Five pieces attack the king zone on g8, none the one on a8
+  int32_t attacked = evaluateAttacks("6k1/3R1ppp/8/6NQ/2B5/8/8/4KR2 w - - 0 1");
+  int32_t safe = evaluateAttacks("k7/pppR4/8/6NQ/2B5/8/8/4KR2 w - - 0 1");
+  EXPECT_GT(attacked, safe + 20);
+
+  // A lone queen next to the king is not scored as an attack
+  attacked = evaluateAttacks("6k1/5ppp/8/7Q/8/8/8/1NB1KR2 w - - 0 1");
+  safe = evaluateAttacks("k7/ppp5/8/7Q/8/8/8/1NB1KR2 w - - 0 1");
+  EXPECT_LE(std::abs(attacked - safe), 5);
+}
+
+TEST_F(BitboardTest, TestPieceSquareScore)
+{
+  // Castling, captures and promotions for both sides
+  mBitBoard.setPosition("r3k2r/pPppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PpPBBPPP/R3K2R w KQkq - 0 1");
+
+  jcl::Board & board = mBitBoard;
+  auto computeScore = [&board]()
+  {
+    int32_t score = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      for (uint8_t j = 0; j < 8; j++)
+      {
+        score += jcl::PieceSquare::getValue(board.getPieceType(i, j), i, j);
+      }
+    }
+    return score;
+  };
+
+  auto computePawnHashKey = [&board]()
+  {
+    uint64_t key = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      for (uint8_t j = 0; j < 8; j++)
+      {
+        jcl::PieceType pieceType = board.getPieceType(i, j);
+        if (pieceType == jcl::PieceType::WhitePawn || pieceType == jcl::PieceType::BlackPawn)
+        {
+          key ^= jcl::Zobrist::getPieceKey(pieceType, i, j);
+        }
+      }
+    }
+    return key;
+  };
+
+  auto computePhase = [&board]()
+  {
+    int32_t phase = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      for (uint8_t j = 0; j < 8; j++)
+      {
+        phase += jcl::PieceSquare::getPhase(board.getPieceType(i, j));
+      }
+    }
+    return phase;
+  };
+
+  auto computeMaterialKey = [&board]()
+  {
+    uint64_t key = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      for (uint8_t j = 0; j < 8; j++)
+      {
+        key += jcl::MaterialTable::getPieceKey(board.getPieceType(i, j));
+      }
+    }
+    return key;
+  };
+
+  int32_t initialScore = board.getPieceSquareScore();
+  EXPECT_EQ(initialScore, computeScore());
+  EXPECT_EQ(jcl::MaterialTable::getPieceCount(board.getMaterialKey(), jcl::PieceType::WhitePawn), 8u);
+  EXPECT_EQ(jcl::MaterialTable::getPieceCount(board.getMaterialKey(), jcl::PieceType::BlackQueen), 1u);
+  EXPECT_EQ(board.getPhase(), jcl::PieceSquare::MAX_PHASE);
+
+  jcl::MoveList moveList;
+  board.generateMoves(moveList);
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    board.makeMove(moveList[i]);
+    EXPECT_EQ(board.getPieceSquareScore(), computeScore()) << moveList[i]->toSmithNotation();
+
+    jcl::MoveList replies;
+    board.generateMoves(replies);
+    for (uint32_t j = 0; j < replies.size(); j++)
+    {
+      board.makeMove(replies[j]);
+      EXPECT_EQ(board.getPieceSquareScore(), computeScore()) << replies[j]->toSmithNotation();
+      EXPECT_EQ(board.computePieceSquareScore(), computeScore()) << replies[j]->toSmithNotation();
+      EXPECT_EQ(board.getPhase(), computePhase()) << replies[j]->toSmithNotation();
+      EXPECT_EQ(board.getPawnHashKey(), computePawnHashKey()) << replies[j]->toSmithNotation();
+      EXPECT_EQ(board.getMaterialKey(), computeMaterialKey()) << replies[j]->toSmithNotation();
+      board.unmakeMove(replies[j]);
+    }
+
+    board.unmakeMove(moveList[i]);
+    EXPECT_EQ(board.getPieceSquareScore(), initialScore);
+  }
+}
+
 TEST_F(BitboardTest, TestWhitePawnMovesStartup)
 {
   mBitBoard.setPosition("8/8/8/8/8/8/PPPPPPPP/8 w - - 0 1");
@@ -1390,6 +1690,36 @@ TEST_F(BitboardTest, TestWhitePawnMovesStartupDoubleBlocked)
   EXPECT_EQ(compareMoves(moveList, correctMoves), true);
 }
 
+TEST_F(BitboardTest, TestWhiteEnPassantMoves)
+{
+  mBitBoard.setPosition("4k3/8/8/1PpP4/8/8/8/4K3 w - c6 0 1");
+
+  jcl::MoveList correctMoves;
+
+  correctMoves.addMove(jcl::Move(4, 1, 5, 2, 0, 0, 0, 0, jcl::Piece::Pawn, jcl::Move::Type::EpCapture, jcl::Piece::Pawn, jcl::Piece::Pawn));
+  correctMoves.addMove(jcl::Move(4, 3, 5, 2, 0, 0, 0, 0, jcl::Piece::Pawn, jcl::Move::Type::EpCapture, jcl::Piece::Pawn, jcl::Piece::Pawn));
+
+  jcl::MoveList moveList;
+  mBitBoard.generateCaptures(moveList);
+
+  EXPECT_EQ(compareMoves(moveList, correctMoves), true);
+}
+
+TEST_F(BitboardTest, TestBlackEnPassantMoves)
+{
+  mBitBoard.setPosition("4k3/8/8/8/3pPp2/8/8/4K3 b - e3 0 1");
+
+  jcl::MoveList correctMoves;
+
+  correctMoves.addMove(jcl::Move(3, 3, 2, 4, 0, 0, 0, 0, jcl::Piece::Pawn, jcl::Move::Type::EpCapture, jcl::Piece::Pawn, jcl::Piece::Pawn));
+  correctMoves.addMove(jcl::Move(3, 5, 2, 4, 0, 0, 0, 0, jcl::Piece::Pawn, jcl::Move::Type::EpCapture, jcl::Piece::Pawn, jcl::Piece::Pawn));
+
+  jcl::MoveList moveList;
+  mBitBoard.generateCaptures(moveList);
+
+  EXPECT_EQ(compareMoves(moveList, correctMoves), true);
+}
+
 // TEST_F(BitboardTest, TestStartPositionMoves)
 // {
 //   jcl::MoveList moveList;
@@ -1490,3 +1820,32 @@ TEST_F(BitboardTest, TestWhitePawnMovesStartupDoubleBlocked)
 
 //   EXPECT_EQ(compareMoves(moveList, correctMoves), true);
 // }
+
+TEST_F(BitboardTest, TestStaticExchangeEvaluation)
+{
+  // Undefended pawn
+  mBitBoard.setPosition("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1");
+  jcl::Move rookCapture(0, 4, 4, 4, 0, 0, 0, 0, jcl::Piece::Rook, jcl::Move::Type::Capture, jcl::Piece::Pawn);
+  EXPECT_EQ(mBitBoard.see(&rookCapture), 100);
+  EXPECT_TRUE(mBitBoard.seeGE(&rookCapture, 100));
+  EXPECT_FALSE(mBitBoard.seeGE(&rookCapture, 101));
+
+  // Defended pawn with x-ray attackers behind both sides
+  mBitBoard.setPosition("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+  jcl::Move knightCapture(2, 3, 4, 4, 0, 0, 0, 0, jcl::Piece::Knight, jcl::Move::Type::Capture, jcl::Piece::Pawn);
+  EXPECT_EQ(mBitBoard.see(&knightCapture), -200);
+  EXPECT_TRUE(mBitBoard.seeGE(&knightCapture, -200));
+  EXPECT_FALSE(mBitBoard.seeGE(&knightCapture, 0));
+
+  // Pawn defended only by the king, which may recapture
+  mBitBoard.setPosition("8/8/3k4/4p3/8/8/8/4R2K w - - 0 1");
+  EXPECT_EQ(mBitBoard.see(&rookCapture), -400);
+  EXPECT_TRUE(mBitBoard.seeGE(&rookCapture, -400));
+  EXPECT_FALSE(mBitBoard.seeGE(&rookCapture, -399));
+
+  // The king may not recapture onto a square the knight still defends
+  mBitBoard.setPosition("8/8/3k4/4p3/8/3N4/8/4R2K w - - 0 1");
+  EXPECT_EQ(mBitBoard.see(&rookCapture), 100);
+  EXPECT_TRUE(mBitBoard.seeGE(&rookCapture, 100));
+  EXPECT_FALSE(mBitBoard.seeGE(&rookCapture, 101));
+}
@@ -11,6 +11,11 @@ class MockBoard : public jcl::Board
 protected:
 
   // Override
+  bool doGenerateCaptures(jcl::MoveList & moveList) const override
+  {
+    return true;
+  }
+
   bool doGenerateMoves(jcl::MoveList & moveList) const override
   {
     return true;
@@ -0,0 +1,845 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "jcl_batchevaluation.h"
+#include "jcl_bitboard.h"
+#include "jcl_board8x8.h"
+#include "jcl_evaluation.h"
+#include "jcl_evaluationcache.h"
+#include "jcl_materialtable.h"
+#include "jcl_move.h"
+#include "jcl_movelist.h"
+#include "jcl_network.h"
+#include "jcl_openingbook.h"
+#include "jcl_openingbookbuilder.h"
+#include "jcl_pawntable.h"
+#include "jcl_search.h"
+#include "jcl_tablebase.h"
+#include "jcl_tablebasegenerator.h"
+#include "jcl_timemanager.h"
+#include "jcl_transpositiontable.h"
+
+class SearchTest : public testing::Test
+{
+protected:
+  SearchTest()
+    : mSearch(&mBoard, &mEvaluation)
+  {
+  }
+
+protected:
+  jcl::Board8x8 mBoard;
+  jcl::Evaluation mEvaluation;
+  jcl::Search mSearch;
+};
+
+TEST_F(SearchTest, TestEvaluation)
+{
+  jcl::Score score = jcl::makeScore(-120, 345);
+  EXPECT_EQ(jcl::getMidgameValue(score), -120);
+  EXPECT_EQ(jcl::getEndgameValue(score), 345);
+  EXPECT_EQ(jcl::getMidgameValue(-score + jcl::makeScore(20, -45)), 140);
+  EXPECT_EQ(jcl::getEndgameValue(-score + jcl::makeScore(20, -45)), -390);
+
+  // Mirrored positions with the colors swapped evaluate to opposite scores
+  mBoard.setPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard), 0);
+
+  mBoard.setPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  int32_t whiteScore = mEvaluation.evaluateBoard(&mBoard);
+  mBoard.setPosition("r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq - 0 1");
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard), -whiteScore);
+
+  // The king is safer on its home rank in the middlegame and belongs in the centre in the endgame
+  mBoard.setPosition("rnbqk2r/pppppppp/8/8/8/8/PPPPPPPP/RNBQ1RK1 w kq - 0 1");
+  int32_t castledScore = mEvaluation.evaluateBoard(&mBoard);
+  mBoard.setPosition("rnbqk2r/pppppppp/8/8/4K3/8/PPPPPPPP/RNBQ1R2 w kq - 0 1");
+  EXPECT_LT(mEvaluation.evaluateBoard(&mBoard), castledScore);
+
+  mBoard.setPosition("4k3/pppp4/8/8/8/8/PPPP4/6K1 w - - 0 1");
+  int32_t cornerScore = mEvaluation.evaluateBoard(&mBoard);
+  mBoard.setPosition("4k3/pppp4/8/8/4K3/8/PPPP4/8 w - - 0 1");
+  EXPECT_GT(mEvaluation.evaluateBoard(&mBoard), cornerScore);
+}
+
+TEST_F(SearchTest, TestPawnStructure)
+{
+  // White has passed f- and h-pawns, black has passed a- and c-pawns
+  mBoard.setPosition("4k3/8/3p4/2p1P3/p7/7P/5P1P/4K3 w - - 0 1");
+  jcl::PawnTable & table = mEvaluation.getPawnTable();
+  table.clear();
+  mEvaluation.evaluateBoard(&mBoard);
+  EXPECT_EQ(table.getProbes(), 1u);
+  EXPECT_EQ(table.getHits(), 0u);
+
+  bool found = false;
+  jcl::PawnTable::Entry * entry = table.probe(mBoard.getPawnHashKey(), found);
+  ASSERT_TRUE(found);
+  auto square = [](int row, int col) { return 1ULL << ((row << 3) + 7 - col); };
+  EXPECT_EQ(entry->pawns[0], square(1, 5) | square(1, 7) | square(2, 7) | square(4, 4));
+  EXPECT_EQ(entry->passed[0], square(1, 5) | square(1, 7) | square(2, 7));
+  EXPECT_EQ(entry->passed[1], square(3, 0) | square(4, 2));
+
+  // Only the four king moves keep the pawn structure cached
+  table.clearStatistics();
+  jcl::MoveList moveList;
+  jcl::Board & board = mBoard;
+  board.generateMoves(moveList);
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    board.makeMove(moveList[i]);
+    mEvaluation.evaluateBoard(&mBoard);
+    board.unmakeMove(moveList[i]);
+  }
+  EXPECT_EQ(table.getProbes(), moveList.size());
+  EXPECT_EQ(table.getHits(), 4u);
+  EXPECT_DOUBLE_EQ(table.getHitRate(), 100.0 * 4 / moveList.size());
+}
+
+TEST_F(SearchTest, TestMaterialTable)
+{
+  // The material is evaluated once and found again for the same pieces
+  jcl::MaterialTable & table = mEvaluation.getMaterialTable();
+  table.clear();
+  mBoard.setPosition("4k3/5p2/4b3/8/8/2B5/5PP1/4K3 w - - 0 1");
+  int32_t oppositeScore = mEvaluation.evaluateBoard(&mBoard);
+  mBoard.setPosition("4k3/5p2/3b4/8/8/2B5/5PP1/4K3 w - - 0 1");
+  int32_t sameScore = mEvaluation.evaluateBoard(&mBoard);
+  EXPECT_EQ(table.getProbes(), 2u);
+  EXPECT_EQ(table.getHits(), 1u);
+
+  // Bishops on opposite colors halve the extra pawn
+  EXPECT_GT(oppositeScore, 0);
+  EXPECT_LT(oppositeScore, sameScore);
+
+  // A minor piece or two knights cannot win against a lone king
+  mBoard.setPosition("4k3/8/8/8/8/8/8/1N2K3 w - - 0 1");
+  EXPECT_LT(std::abs(mEvaluation.evaluateBoard(&mBoard)), 100);
+  mBoard.setPosition("4k3/8/8/8/8/8/8/1N2KN2 w - - 0 1");
+  EXPECT_LT(std::abs(mEvaluation.evaluateBoard(&mBoard)), 100);
+
+  // A bishop and knight mate in a corner of the color of the bishop
+  mBoard.setPosition("8/8/8/8/4N3/2K5/8/k1B5 w - - 0 1");
+  int32_t rightCorner = mEvaluation.evaluateBoard(&mBoard);
+  mBoard.setPosition("k7/8/2K5/8/4N3/8/8/2B5 w - - 0 1");
+  int32_t wrongCorner = mEvaluation.evaluateBoard(&mBoard);
+  EXPECT_GT(rightCorner, wrongCorner);
+  EXPECT_GT(wrongCorner, 1000);
+
+  // The rook wins when its king stops the pawn, not against a supported pawn
+  mBoard.setPosition("k6R/8/8/8/8/4p3/8/4K3 w - - 0 1");
+  int32_t stoppedScore = mEvaluation.evaluateBoard(&mBoard);
+  mBoard.setPosition("4k3/8/4P3/8/8/8/8/K6r b - - 0 1");
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard), -stoppedScore);
+  mBoard.setPosition("7K/8/8/8/8/7R/1pk5/8 w - - 0 1");
+  int32_t supportedScore = mEvaluation.evaluateBoard(&mBoard);
+  EXPECT_GT(stoppedScore, 500);
+  EXPECT_LT(supportedScore, 100);
+
+  // A king and pawn against a king are won or drawn as in the bitbase
+  mBoard.setPosition("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1");
+  int32_t wonScore = mEvaluation.evaluateBoard(&mBoard);
+  EXPECT_GT(wonScore, 1000);
+  mBoard.setPosition("8/8/8/8/4p3/4k3/8/4K3 w - - 0 1");
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard), -wonScore);
+  mBoard.setPosition("8/8/8/4k3/8/8/4P3/4K3 w - - 0 1");
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard), 0);
+}
+
+TEST_F(SearchTest, TestLazyEvaluation)
+{
+  mBoard.setPosition("r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 b - - 0 7");
+  int32_t score = mEvaluation.evaluateBoard(&mBoard);
+
+  // A window around the score evaluates every stage
+  bool complete = false;
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard, score - 1, score + 1, complete), score);
+  EXPECT_TRUE(complete);
+
+  // A window far from the score stops after the material
+  int32_t partial = mEvaluation.evaluateBoard(&mBoard, score + 2000, score + 2001, complete);
+  EXPECT_FALSE(complete);
+  EXPECT_LT(partial, score + 2000);
+  EXPECT_EQ(mEvaluation.getLazyCutoffs(jcl::Evaluation::Stage::Material), 1u);
+
+  // A large material margin leaves the pawn structure margin to stop it
+  int32_t margin = mEvaluation.getLazyMargin(jcl::Evaluation::Stage::Material);
+  mEvaluation.setLazyMargin(jcl::Evaluation::Stage::Material, 5000);
+  mEvaluation.evaluateBoard(&mBoard, score + 2000, score + 2001, complete);
+  EXPECT_FALSE(complete);
+  EXPECT_EQ(mEvaluation.getLazyCutoffs(jcl::Evaluation::Stage::PawnStructure), 1u);
+  EXPECT_EQ(mEvaluation.getLazyEvaluations(), 3u);
+
+  mEvaluation.setLazyMargin(jcl::Evaluation::Stage::Material, margin);
+  mEvaluation.clearStatistics();
+  EXPECT_EQ(mEvaluation.getLazyEvaluations(), 0u);
+  EXPECT_EQ(mEvaluation.getLazyCutoffs(jcl::Evaluation::Stage::Material), 0u);
+
+  // Lazy evaluation does not change the result of a search
+  mSearch.setLazyEvaluationEnabled(false);
+  int32_t expectedScore = mSearch.execute(4);
+  std::string expectedMove = mSearch.getBestMove().toSmithNotation();
+  mSearch.setLazyEvaluationEnabled(true);
+  EXPECT_EQ(mSearch.execute(4), expectedScore);
+  EXPECT_EQ(mSearch.getBestMove().toSmithNotation(), expectedMove);
+  EXPECT_GT(mEvaluation.getLazyEvaluations(), 0u);
+}
+
+TEST_F(SearchTest, TestNetwork)
+{
+  jcl::Network network;
+  std::string fileName = testing::TempDir() + "jcl_test_network.bin";
+  EXPECT_FALSE(network.load(fileName + ".missing"));
+  EXPECT_FALSE(network.isLoaded());
+
+  // Random weights small enough that the accumulators do not overflow
+  std::mt19937 random(1234);
+  std::uniform_int_distribution<int32_t> distribution(-32, 32);
+  std::ofstream file(fileName, std::ios::binary);
+  auto write = [&](size_t count, size_t size)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      int32_t value = distribution(random);
+      file.write(reinterpret_cast<const char *>(&value), size);
+    }
+  };
+  uint32_t header[2] = { jcl::Network::FILE_MAGIC, jcl::Network::FILE_VERSION };
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  write(jcl::Network::HIDDEN_SIZE, 2);
+  write(static_cast<size_t>(jcl::Network::INPUT_SIZE) * jcl::Network::HIDDEN_SIZE, 2);
+  write(jcl::Network::LAYER1_SIZE, 4);
+  write(jcl::Network::LAYER1_SIZE * 2 * jcl::Network::HIDDEN_SIZE, 1);
+  write(jcl::Network::LAYER2_SIZE, 4);
+  write(jcl::Network::LAYER2_SIZE * jcl::Network::LAYER1_SIZE, 1);
+  write(1, 4);
+  write(jcl::Network::LAYER2_SIZE, 1);
+  file.close();
+  ASSERT_TRUE(network.load(fileName));
+  EXPECT_EQ(network.getFileName(), fileName);
+
+  // Incremental accumulators match a refresh after every move and unmove
+  jcl::Board & board = mBoard;
+  mBoard.setNetwork(&network);
+  mBoard.setPosition("r3k2r/pPppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PpPBBPPP/R3K2R w KQkq - 0 1");
+  auto isRefreshed = [&]()
+  {
+    jcl::Network::Accumulator accumulator;
+    network.refreshAccumulator(&mBoard, jcl::Color::White, accumulator);
+    network.refreshAccumulator(&mBoard, jcl::Color::Black, accumulator);
+    return std::equal(&accumulator.values[0][0], &accumulator.values[0][0] + 2 * jcl::Network::HIDDEN_SIZE,
+                      &mBoard.getAccumulator().values[0][0]);
+  };
+
+  jcl::MoveList moveList;
+  board.generateMoves(moveList);
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    const jcl::Move * move = moveList[i];
+    mBoard.makeMove(move);
+    EXPECT_TRUE(isRefreshed()) << i;
+
+    jcl::MoveList replyList;
+    board.generateMoves(replyList);
+    for (uint32_t j = 0; j < replyList.size(); j++)
+    {
+      mBoard.makeMove(replyList[j]);
+      EXPECT_TRUE(isRefreshed()) << i << " " << j;
+      mBoard.unmakeMove(replyList[j]);
+    }
+
+    mBoard.unmakeMove(move);
+    EXPECT_TRUE(isRefreshed()) << i;
+  }
+
+  // The network replaces the evaluation and sees mirrored positions alike
+  int32_t whiteScore = mEvaluation.evaluateBoard(&mBoard);
+  EXPECT_EQ(whiteScore, network.evaluate(mBoard.getAccumulator(), jcl::Color::White));
+  mBoard.setPosition("r3k2r/pPpbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/PpPPQPB1/R3K2R b KQkq - 0 1");
+  EXPECT_EQ(mEvaluation.evaluateBoard(&mBoard), -whiteScore);
+
+  // A packed position is scored by the network as on the board
+  mBoard.setPosition("r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 b - - 0 7");
+  EXPECT_EQ(mEvaluation.evaluatePosition(jcl::BatchEvaluation::pack(&mBoard), &network), mEvaluation.evaluateBoard(&mBoard));
+
+  // The portable loops give the same accumulators and scores as the AVX2 kernels
+  bool avx2Enabled = jcl::Network::isAvx2Enabled();
+  jcl::Network::Accumulator accumulators[2];
+  int32_t scores[2];
+  for (int32_t i = 0; i < 2; i++)
+  {
+    EXPECT_EQ(jcl::Network::setAvx2Enabled(i == 0), (i == 0) && avx2Enabled);
+    network.refreshAccumulator(&mBoard, jcl::Color::White, accumulators[i]);
+    network.refreshAccumulator(&mBoard, jcl::Color::Black, accumulators[i]);
+    scores[i] = network.evaluate(accumulators[i], jcl::Color::Black);
+  }
+  jcl::Network::setAvx2Enabled(avx2Enabled);
+  EXPECT_TRUE(std::equal(&accumulators[0].values[0][0], &accumulators[0].values[0][0] + 2 * jcl::Network::HIDDEN_SIZE,
+                         &accumulators[1].values[0][0]));
+  EXPECT_EQ(scores[0], scores[1]);
+
+  mBoard.setNetwork(nullptr);
+  network.unload();
+  EXPECT_FALSE(network.isLoaded());
+  std::remove(fileName.c_str());
+}
+
+TEST_F(SearchTest, TestBatchEvaluation)
+{
+  // The positions after each move from a few positions, scored on a bitboard
+  const char * fens[] =
+  {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 b - - 0 7",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"
+  };
+
+  jcl::BitBoard bitBoard;
+  jcl::Board & board = bitBoard;
+  jcl::Evaluation evaluation;
+  std::vector<jcl::PackedPosition> positions;
+  std::vector<int32_t> expected;
+  for (const char * fen : fens)
+  {
+    bitBoard.setPosition(fen);
+    jcl::MoveList moveList;
+    board.generateMoves(moveList);
+    for (uint32_t i = 0; i < moveList.size(); i++)
+    {
+      bitBoard.makeMove(moveList[i]);
+      positions.push_back(jcl::BatchEvaluation::pack(&bitBoard));
+      expected.push_back(evaluation.evaluateBoard(&bitBoard));
+      bitBoard.unmakeMove(moveList[i]);
+    }
+  }
+
+  // Enough copies that every thread takes several chunks
+  size_t count = positions.size();
+  while (positions.size() < 20000)
+  {
+    positions.push_back(positions[positions.size() % count]);
+  }
+
+  jcl::BatchEvaluation batch(3);
+  EXPECT_EQ(batch.getThreadCount(), 3u);
+  std::vector<int32_t> scores(positions.size());
+  for (int repeat = 0; repeat < 2; repeat++)
+  {
+    std::fill(scores.begin(), scores.end(), 0);
+    batch.evaluate(positions.data(), positions.size(), scores.data());
+    for (size_t i = 0; i < scores.size(); i++)
+    {
+      ASSERT_EQ(scores[i], expected[i % count]) << i;
+    }
+  }
+}
+
+TEST_F(SearchTest, TestEvaluationCache)
+{
+  jcl::EvaluationCache cache(1);
+  int32_t score = 0;
+  cache.store(0x1234567890abcdefULL, -321);
+  ASSERT_TRUE(cache.probe(0x1234567890abcdefULL, score));
+  EXPECT_EQ(score, -321);
+  EXPECT_FALSE(cache.probe(0x2234567890abcdefULL, score));
+
+  // Scores that do not fit in an entry are not stored
+  cache.store(0x0fedcba987654321ULL, 40000);
+  EXPECT_FALSE(cache.probe(0x0fedcba987654321ULL, score));
+
+  // The cache does not change the result of a search
+  mBoard.setPosition("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+  int32_t expectedScore = mSearch.execute(4);
+  std::string expectedMove = mSearch.getBestMove().toSmithNotation();
+
+  cache.clear();
+  mSearch.setEvaluationCache(&cache);
+  EXPECT_EQ(mSearch.execute(4), expectedScore);
+  EXPECT_EQ(mSearch.getBestMove().toSmithNotation(), expectedMove);
+  EXPECT_GT(mSearch.getEvaluationCacheHits(), 0u);
+  EXPECT_LE(mSearch.getEvaluationCacheHits(), mSearch.getEvaluationCacheProbes());
+}
+
+TEST_F(SearchTest, TestPolyglotKey)
+{
+  // The keys published with the Polyglot book format
+  struct Line
+  {
+    std::vector<const char *> moves;
+    uint64_t key;
+    const char * fen;
+  };
+  std::vector<Line> lines =
+  {
+    { {}, 0x463b96181691fc9cULL, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" },
+    { { "e2e4" }, 0x823c9b50fd114196ULL, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1" },
+    { { "e2e4", "d7d5" }, 0x0756b94461c50fb0ULL, "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2" },
+    { { "e2e4", "d7d5", "e4e5" }, 0x662fafb965db29d4ULL, "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2" },
+    { { "e2e4", "d7d5", "e4e5", "f7f5" }, 0x22a48b5a8e47ff78ULL, "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3" },
+    { { "e2e4", "d7d5", "e4e5", "f7f5", "e1e2" }, 0x652a607ca3f242c1ULL, "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3" },
+    { { "e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7" }, 0x00fdd303c946bdd9ULL, "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4" },
+    { { "a2a4", "b7b5", "h2h4", "b5b4", "c2c4" }, 0x3c8123ea7b067637ULL, "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3" },
+    { { "a2a4", "b7b5", "h2h4", "b5b4", "c2c4", "b4c3", "a1a3" }, 0x5c3f9b829b279560ULL, "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4" }
+  };
+
+  // The key is kept up to date as moves are made and unmade on each kind of board
+  jcl::BitBoard bitBoard;
+  for (jcl::Board * board : { static_cast<jcl::Board *>(&mBoard), static_cast<jcl::Board *>(&bitBoard) })
+  {
+    for (const Line & line : lines)
+    {
+      board->reset();
+      uint64_t startKey = board->getPolyglotKey();
+      std::vector<jcl::Move> moves;
+      for (const char * notation : line.moves)
+      {
+        jcl::MoveList moveList;
+        board->generateMoves(moveList);
+        for (uint32_t i = 0; i < moveList.size(); i++)
+        {
+          if (moveList[i]->toSmithNotation() == notation)
+          {
+            moves.push_back(*moveList[i]);
+          }
+        }
+        ASSERT_FALSE(moves.empty());
+        board->makeMove(&moves.back());
+      }
+      EXPECT_EQ(board->getPolyglotKey(), line.key) << line.fen;
+
+      while (!moves.empty())
+      {
+        board->unmakeMove(&moves.back());
+        moves.pop_back();
+      }
+      EXPECT_EQ(board->getPolyglotKey(), startKey);
+
+      board->setPosition(line.fen);
+      EXPECT_EQ(board->getPolyglotKey(), line.key) << line.fen;
+    }
+  }
+}
+
+TEST_F(SearchTest, TestOpeningBook)
+{
+  // Castling is stored as the king taking its own rook
+  mBoard.setPosition("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  const jcl::Board & board = mBoard;
+  jcl::MoveList moveList;
+  board.generateMoves(moveList);
+  std::vector<uint16_t> castles;
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    if (moveList[i]->isCastle())
+    {
+      castles.push_back(jcl::OpeningBook::encodeMove(moveList[i]));
+    }
+  }
+  std::sort(castles.begin(), castles.end());
+  ASSERT_EQ(castles.size(), 2u);
+  EXPECT_EQ(castles[0], (4 << 6) | 0);
+  EXPECT_EQ(castles[1], (4 << 6) | 7);
+
+  // Entries are sorted by key and stored big endian
+  mBoard.setPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  uint64_t startKey = mBoard.getPolyglotKey();
+  auto encode = [](int sourceRow, int sourceColumn, int destinationRow, int destinationColumn)
+  {
+    return static_cast<uint16_t>(destinationColumn | (destinationRow << 3) | (sourceColumn << 6) | (sourceRow << 9));
+  };
+  std::vector<jcl::OpeningBook::Entry> bookEntries =
+  {
+    { startKey - 1, encode(1, 0, 2, 0), 1, 0 },
+    { startKey, encode(1, 4, 3, 4), 3, 0 },
+    { startKey, encode(1, 4, 4, 4), 5, 0 },
+    { startKey, encode(1, 3, 3, 3), 1, 0 },
+    { startKey, encode(1, 2, 3, 2), 0, 0 },
+    { startKey + 1, encode(1, 7, 2, 7), 1, 0 }
+  };
+
+  std::string fileName = testing::TempDir() + "jcl_test_book.bin";
+  std::ofstream file(fileName, std::ios::binary);
+  for (const jcl::OpeningBook::Entry & entry : bookEntries)
+  {
+    uint64_t fields[4] = { entry.key, entry.move, entry.weight, entry.learn };
+    int sizes[4] = { 8, 2, 2, 4 };
+    for (int i = 0; i < 4; i++)
+    {
+      for (int j = sizes[i] - 1; j >= 0; j--)
+      {
+        file.put(static_cast<char>((fields[i] >> (8 * j)) & 0xff));
+      }
+    }
+  }
+  file.close();
+
+  jcl::OpeningBook book;
+  EXPECT_FALSE(book.load(fileName + ".missing"));
+  ASSERT_TRUE(book.load(fileName));
+  EXPECT_EQ(book.getEntryCount(), bookEntries.size());
+
+  // The illegal move and the move without weight are left out
+  std::vector<jcl::OpeningBook::Entry> entries;
+  EXPECT_EQ(book.findEntries(startKey, entries), 4u);
+  EXPECT_EQ(book.findEntries(startKey + 2, entries), 0u);
+  std::vector<jcl::Move> moves;
+  std::vector<uint16_t> weights;
+  ASSERT_EQ(book.findMoves(&mBoard, moves, weights), 2u);
+  EXPECT_EQ(moves[0].toSmithNotation(), "e2e4");
+  EXPECT_EQ(moves[1].toSmithNotation(), "d2d4");
+
+  // Moves are chosen in proportion to their weights
+  jcl::Move move;
+  for (uint64_t random = 0; random < 8; random++)
+  {
+    ASSERT_TRUE(book.selectMove(&mBoard, random, move));
+    EXPECT_EQ(move.toSmithNotation(), (random % 4 < 3) ? "e2e4" : "d2d4");
+  }
+  EXPECT_EQ(mBoard.getPolyglotKey(), startKey);
+
+  book.unload();
+  EXPECT_FALSE(book.isLoaded());
+  std::remove(fileName.c_str());
+}
+
+TEST_F(SearchTest, TestOpeningBookBuilder)
+{
+  // Moves are read in standard algebraic notation
+  jcl::Move move;
+  mBoard.setPosition("r3k2r/1P6/8/8/8/2N3N1/8/R3K2R w KQkq - 0 1");
+  ASSERT_TRUE(jcl::OpeningBookBuilder::findMove(&mBoard, "O-O-O", move));
+  EXPECT_EQ(move.toSmithNotation(), "e1c1");
+  ASSERT_TRUE(jcl::OpeningBookBuilder::findMove(&mBoard, "Nce4+", move));
+  EXPECT_EQ(move.toSmithNotation(), "c3e4");
+  ASSERT_TRUE(jcl::OpeningBookBuilder::findMove(&mBoard, "bxa8=N!", move));
+  EXPECT_EQ(move.getPromotedPiece(), jcl::Piece::Knight);
+  EXPECT_FALSE(jcl::OpeningBookBuilder::findMove(&mBoard, "Ne4", move));
+  EXPECT_FALSE(jcl::OpeningBookBuilder::findMove(&mBoard, "Ke2x", move));
+
+  // Each move is counted for the side that played it, up to the ply limit
+  jcl::OpeningBookBuilder builder(3);
+  const char * startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+  mBoard.setPosition(startFen);
+  EXPECT_EQ(builder.addGame(&mBoard, { "e4", "e5", "Nf3", "Nc6" }, jcl::OpeningBookBuilder::GameResult::WhiteWin), 3u);
+  mBoard.setPosition(startFen);
+  EXPECT_EQ(builder.addGame(&mBoard, { "e4", "c5", "Qh6" }, jcl::OpeningBookBuilder::GameResult::Draw), 2u);
+  mBoard.setPosition(startFen);
+  EXPECT_EQ(builder.addGame(&mBoard, { "d4" }, jcl::OpeningBookBuilder::GameResult::BlackWin), 1u);
+  EXPECT_EQ(builder.getEntryCount(), 5u);
+
+  // The saved book weights moves by their points and leaves out those without any
+  std::string fileName = testing::TempDir() + "jcl_test_built_book.bin";
+  EXPECT_EQ(builder.save(fileName), 3u);
+  jcl::OpeningBook book;
+  ASSERT_TRUE(book.load(fileName));
+  ASSERT_EQ(book.getEntryCount(), 3u);
+  for (size_t i = 1; i < book.getEntryCount(); i++)
+  {
+    EXPECT_LT(book.getEntry(i - 1).key, book.getEntry(i).key);
+  }
+
+  mBoard.setPosition(startFen);
+  std::vector<jcl::Move> moves;
+  std::vector<uint16_t> weights;
+  ASSERT_EQ(book.findMoves(&mBoard, moves, weights), 1u);
+  EXPECT_EQ(moves[0].toSmithNotation(), "e2e4");
+  EXPECT_EQ(weights[0], 3);
+
+  book.unload();
+  std::remove(fileName.c_str());
+
+  // Games with en passant captures are counted in full on either board
+  jcl::BitBoard bitBoard;
+  for (jcl::Board * board : { static_cast<jcl::Board *>(&mBoard), static_cast<jcl::Board *>(&bitBoard) })
+  {
+    jcl::OpeningBookBuilder enPassantBuilder;
+    board->setPosition(startFen);
+    EXPECT_EQ(enPassantBuilder.addGame(board, { "e4", "a6", "e5", "d5", "exd6" }, jcl::OpeningBookBuilder::GameResult::Draw), 5u);
+    EXPECT_EQ(board->getPieceType(4, 3), jcl::PieceType::None);
+
+    board->setPosition("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3");
+    ASSERT_TRUE(jcl::OpeningBookBuilder::findMove(board, "exd6", move));
+    EXPECT_TRUE(move.isEnPassantCapture());
+  }
+}
+
+TEST_F(SearchTest, TestGenerateCaptures)
+{
+  mBoard.setPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+  jcl::MoveList moveList;
+  mBoard.generateCaptures(moveList);
+
+  EXPECT_EQ(moveList.size(), 8u);
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    EXPECT_TRUE(moveList[i]->isCapture() || moveList[i]->isPromotion());
+  }
+}
+
+TEST_F(SearchTest, TestQuiescenceResolvesExchange)
+{
+  // The queen takes a defended pawn and is lost at the horizon of a one ply search
+  mBoard.setPosition("4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1");
+
+  mSearch.execute(1);
+
+  EXPECT_NE(mSearch.getBestMove().toSmithNotation(), "d2d5");
+  EXPECT_GT(mSearch.getQuiescenceNodes(), 0u);
+}
+
+TEST_F(SearchTest, TestMateInOne)
+{
+  mBoard.setPosition("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+
+  int32_t score = mSearch.execute(2);
+
+  EXPECT_EQ(mSearch.getBestMove().toSmithNotation(), "a1a8");
+  EXPECT_EQ(score, jcl::Search::MATE_SCORE - 1);
+}
+
+TEST_F(SearchTest, TestTablebase)
+{
+  // The longest win with a queen against a lone king is ten moves
+  jcl::Tablebase tablebase;
+  jcl::TablebaseGenerator generator(&tablebase, 2);
+  int32_t longestWin = 0;
+  generator.setTableCallback([&](const jcl::EndgameTable & table, uint32_t)
+  {
+    for (uint64_t i = 0; i < table.getEntryCount(); i++)
+    {
+      if (jcl::EndgameTable::isWin(table.getValue(i)))
+      {
+        longestWin = std::max(longestWin, jcl::EndgameTable::getDistance(table.getValue(i)));
+      }
+    }
+  });
+  ASSERT_TRUE(generator.generate("KQvK"));
+  EXPECT_EQ(longestWin, 10);
+  EXPECT_EQ(tablebase.getMaxPieces(), 3u);
+
+  // Either color is found in the same table
+  uint8_t value = 0;
+  mBoard.setPosition("k7/8/1K6/8/8/8/8/6Q1 w - - 0 1");
+  ASSERT_TRUE(tablebase.probe(&mBoard, value));
+  EXPECT_EQ(value, 1);
+  mBoard.setPosition("6q1/8/8/8/8/1k6/8/K7 b - - 0 1");
+  ASSERT_TRUE(tablebase.probe(&mBoard, value));
+  EXPECT_EQ(value, 1);
+  mBoard.setPosition("k7/8/1K6/8/8/8/8/6Q1 b - - 0 1");
+  ASSERT_TRUE(tablebase.probe(&mBoard, value));
+  EXPECT_EQ(value, jcl::EndgameTable::LOSS + 1);
+  mBoard.setPosition("k7/8/1K6/8/8/8/8/6R1 w - - 0 1");
+  EXPECT_FALSE(tablebase.probe(&mBoard, value));
+
+  // A saved table is mapped back with the same values
+  bool flipped = false;
+  const jcl::EndgameTable * table = tablebase.findTable(jcl::EndgameTable::getMaterialKey("KQvK"), flipped);
+  ASSERT_NE(table, nullptr);
+  EXPECT_FALSE(flipped);
+  std::string fileName = testing::TempDir() + "jcl_test_tablebase.jtb";
+  ASSERT_TRUE(table->save(fileName));
+  jcl::EndgameTable loadedTable;
+  ASSERT_TRUE(loadedTable.load(fileName));
+  EXPECT_EQ(loadedTable.getMaterialKey(), table->getMaterialKey());
+  ASSERT_EQ(loadedTable.getEntryCount(), table->getEntryCount());
+  bool equal = true;
+  for (uint64_t i = 0; i < table->getEntryCount(); i++)
+  {
+    equal = equal && (loadedTable.getValue(i) == table->getValue(i));
+  }
+  EXPECT_TRUE(equal);
+  loadedTable.unload();
+  std::remove(fileName.c_str());
+
+  // The search scores the positions after each move from the table
+  mBoard.setPosition("8/8/8/4k3/8/8/8/4K2Q w - - 0 1");
+  ASSERT_TRUE(tablebase.probe(&mBoard, value));
+  ASSERT_TRUE(jcl::EndgameTable::isWin(value));
+  mSearch.setTablebase(&tablebase);
+  int32_t score = mSearch.execute(2);
+  mSearch.setTablebase(nullptr);
+  EXPECT_EQ(score, jcl::Search::MATE_SCORE - (2 * jcl::EndgameTable::getDistance(value) - 1));
+  EXPECT_GT(mSearch.getTablebaseHits(), 0u);
+
+  // Retracting moves reaches both reflections of a king on the long diagonal
+  longestWin = 0;
+  ASSERT_TRUE(generator.generate("KRvK"));
+  EXPECT_EQ(longestWin, 16);
+}
+
+TEST_F(SearchTest, TestLateMoveReductions)
+{
+  mBoard.setPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  mSearch.execute(4);
+  uint64_t reducedNodes = mSearch.getNodes();
+
+  jcl::Search::Parameters parameters = mSearch.getParameters();
+  parameters.lmrEnabled = false;
+  parameters.lmpEnabled = false;
+  EXPECT_TRUE(mSearch.setParameters(parameters));
+  mSearch.execute(4);
+
+  EXPECT_FALSE(mSearch.getParameters().lmrEnabled);
+  EXPECT_LT(reducedNodes, mSearch.getNodes());
+
+  parameters.lmrMinDepth = 1;
+  EXPECT_FALSE(mSearch.setParameters(parameters));
+  EXPECT_EQ(mSearch.getParameters().lmrMinDepth, 3);
+}
+
+TEST_F(SearchTest, TestPrincipalVariation)
+{
+  mBoard.setPosition("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+  mSearch.execute(4);
+
+  jcl::MoveList pv;
+  mSearch.getPrincipalVariation(pv);
+
+  ASSERT_GE(pv.size(), 4u);
+  EXPECT_EQ(pv[0]->toSmithNotation(), mSearch.getBestMove().toSmithNotation());
+
+  // Every move of the variation must be playable in turn
+  jcl::Board & board = mBoard;
+  for (uint32_t i = 0; i < pv.size(); i++)
+  {
+    jcl::MoveList moveList;
+    board.generateMoves(moveList);
+    bool found = false;
+    for (uint32_t j = 0; j < moveList.size(); j++)
+    {
+      found |= (moveList[j]->toSmithNotation() == pv[i]->toSmithNotation());
+    }
+    EXPECT_TRUE(found);
+    board.makeMove(pv[i]);
+  }
+}
+
+TEST_F(SearchTest, TestMultiPv)
+{
+  mBoard.setPosition("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+  mSearch.setMultiPv(3);
+  int32_t score = mSearch.execute(4);
+
+  // The lines start with different moves and are ordered by score
+  ASSERT_EQ(mSearch.getLineCount(), 3u);
+  EXPECT_EQ(mSearch.getLineScore(0), score);
+  std::vector<std::string> firstMoves;
+  for (uint32_t line = 0; line < mSearch.getLineCount(); line++)
+  {
+    jcl::MoveList pv;
+    mSearch.getPrincipalVariation(pv, line);
+    ASSERT_GE(pv.size(), 1u);
+    EXPECT_EQ(std::count(firstMoves.begin(), firstMoves.end(), pv[0]->toSmithNotation()), 0);
+    firstMoves.push_back(pv[0]->toSmithNotation());
+    if (line > 0)
+    {
+      EXPECT_LE(mSearch.getLineScore(line), mSearch.getLineScore(line - 1));
+    }
+  }
+  EXPECT_EQ(firstMoves[0], mSearch.getBestMove().toSmithNotation());
+
+  // A position with fewer legal moves than lines has one line for each move
+  mBoard.setPosition("7k/8/8/8/8/8/8/K7 w - - 0 1");
+  mSearch.execute(2);
+  EXPECT_EQ(mSearch.getLineCount(), 3u);
+}
+
+TEST_F(SearchTest, TestTimeManagerLimits)
+{
+  jcl::TimeManager timeManager;
+  timeManager.setMoveOverhead(0);
+
+  timeManager.start(60000, 1000, 20);
+  EXPECT_EQ(timeManager.getSoftLimit(), 3750);
+  EXPECT_EQ(timeManager.getHardLimit(), 18750);
+
+  // The hard limit never exceeds most of the remaining time
+  timeManager.start(1000, 0, 1);
+  EXPECT_EQ(timeManager.getSoftLimit(), 800);
+  EXPECT_EQ(timeManager.getHardLimit(), 800);
+
+  timeManager.startFixed(500);
+  EXPECT_EQ(timeManager.getSoftLimit(), 500);
+  EXPECT_EQ(timeManager.getHardLimit(), 500);
+
+  timeManager.startInfinite();
+  EXPECT_FALSE(timeManager.isTimeLimited());
+  EXPECT_FALSE(timeManager.isHardLimitReached());
+  EXPECT_TRUE(timeManager.shouldStartIteration());
+
+  // A ponder hit past the soft limit stops the search at its next check
+  timeManager.start(60000, 0, 0);
+  timeManager.setPondering(true);
+  EXPECT_FALSE(timeManager.shouldStopSearch());
+  timeManager.setPondering(false);
+  EXPECT_FALSE(timeManager.shouldStopSearch());
+
+  timeManager.startFixed(1);
+  timeManager.setPondering(true);
+  while (timeManager.getElapsed() < 2)
+  {
+  }
+  EXPECT_FALSE(timeManager.shouldStopSearch());
+  timeManager.setPondering(false);
+  EXPECT_TRUE(timeManager.shouldStopSearch());
+}
+
+TEST_F(SearchTest, TestTimeLimitedSearch)
+{
+  mBoard.setPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+  jcl::TimeManager timeManager;
+  timeManager.startFixed(200);
+  mSearch.setTimeManager(&timeManager);
+  mSearch.execute(jcl::Search::MAX_PLY);
+
+  EXPECT_TRUE(mSearch.isStopped());
+  EXPECT_LT(timeManager.getElapsed(), 1000);
+  EXPECT_NE(mSearch.getBestMove().toSmithNotation(), jcl::Move().toSmithNotation());
+}
+
+TEST_F(SearchTest, TestTranspositionTable)
+{
+  jcl::TranspositionTable table(1);
+  jcl::Move move(6, 4, 7, 4, 0, 0, 0, 0, jcl::Piece::Pawn, jcl::Move::Type::Promotion, jcl::Piece::None, jcl::Piece::Queen);
+  table.store(0x1234567890abcdefULL, 7, -250, jcl::TranspositionTable::Bound::Lower, &move);
+
+  jcl::TranspositionTable::Data data;
+  ASSERT_TRUE(table.probe(0x1234567890abcdefULL, data));
+  EXPECT_EQ(data.score, -250);
+  EXPECT_EQ(data.depth, 7);
+  EXPECT_EQ(data.bound, jcl::TranspositionTable::Bound::Lower);
+  EXPECT_TRUE(data.hasMove);
+  EXPECT_EQ(data.sourceRow, 6);
+  EXPECT_EQ(data.destinationRow, 7);
+  EXPECT_EQ(data.destinationColumn, 4);
+  EXPECT_EQ(data.promotedPiece, jcl::Piece::Queen);
+  EXPECT_FALSE(table.probe(0x1234567890abcdeeULL, data));
+
+  // The table does not change the result of a search
+  mBoard.setPosition("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+  mSearch.setTranspositionTable(&table);
+  EXPECT_EQ(mSearch.execute(4), jcl::Search::MATE_SCORE - 1);
+  EXPECT_EQ(mSearch.getBestMove().toSmithNotation(), "a1a8");
+  EXPECT_GT(table.getHashFull(), 0u);
+}
+
+TEST_F(SearchTest, TestStopFlag)
+{
+  std::atomic<bool> stop(true);
+  mSearch.setStopFlag(&stop);
+  mSearch.execute(jcl::Search::MAX_PLY);
+
+  // The first iteration always completes so a move is available
+  EXPECT_TRUE(mSearch.isStopped());
+  EXPECT_NE(mSearch.getBestMove().toSmithNotation(), jcl::Move().toSmithNotation());
+}
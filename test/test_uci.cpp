@@ -0,0 +1,310 @@
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "jcl_board8x8.h"
+#include "jcl_evaluation.h"
+#include "jcl_search.h"
+#include "jcl_transpositiontable.h"
+#include "uciengine.h"
+
+// A stream buffer that passes text between threads. Reads block until
+// text is written or the pipe is closed, so the engine can be fed
+// commands while it searches and its output can be waited for.
+class Pipe : public std::streambuf
+{
+public:
+  Pipe()
+    : mReadPosition(0)
+    , mClosed(false)
+  {
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosed = true;
+    mCondition.notify_all();
+  }
+
+  // Waits for the text to be written at or after a position, and returns
+  // the position after it, or std::string::npos on a timeout
+  size_t waitFor(const std::string & text, size_t from, std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    size_t position = std::string::npos;
+    mCondition.wait_for(lock, timeout, [&]
+    {
+      position = mText.find(text, from);
+      return position != std::string::npos;
+    });
+    return (position == std::string::npos) ? position : position + text.size();
+  }
+
+  std::string getText()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mText;
+  }
+
+protected:
+  int_type underflow() override
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] { return mReadPosition < mText.size() || mClosed; });
+    if (mReadPosition == mText.size())
+    {
+      return traits_type::eof();
+    }
+
+    mReadBuffer = mText.substr(mReadPosition);
+    mReadPosition = mText.size();
+    setg(&mReadBuffer[0], &mReadBuffer[0], &mReadBuffer[0] + mReadBuffer.size());
+    return traits_type::to_int_type(mReadBuffer[0]);
+  }
+
+  int_type overflow(int_type c) override
+  {
+    if (c != traits_type::eof())
+    {
+      char character = traits_type::to_char_type(c);
+      xsputn(&character, 1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char * text, std::streamsize count) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mText.append(text, static_cast<size_t>(count));
+    mCondition.notify_all();
+    return count;
+  }
+
+private:
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::string mText;
+  std::string mReadBuffer;
+  size_t mReadPosition;
+  bool mClosed;
+};
+
+class UciTest : public testing::Test
+{
+protected:
+  UciTest()
+    : mInputBuffer(nullptr)
+    , mOutputBuffer(nullptr)
+  {
+  }
+
+  ~UciTest() override
+  {
+    stop();
+  }
+
+  // Starts the engine on its own thread, reading the commands given to send
+  void start()
+  {
+    mInputBuffer = std::cin.rdbuf(&mInput);
+    mOutputBuffer = std::cout.rdbuf(&mOutput);
+    mEngineThread = std::thread([this] { mEngine.run(); });
+  }
+
+  // Quits the engine started by start
+  void stop()
+  {
+    if (mEngineThread.joinable())
+    {
+      send("quit");
+      mInput.close();
+      mEngineThread.join();
+      std::cin.rdbuf(mInputBuffer);
+      std::cout.rdbuf(mOutputBuffer);
+    }
+  }
+
+  void send(const std::string & command)
+  {
+    mInput.sputn(command.c_str(), static_cast<std::streamsize>(command.size()));
+    mInput.sputc('\n');
+  }
+
+  // Waits for the engine to print the text at or after a position of its output
+  size_t waitFor(const std::string & text, size_t from = 0, std::chrono::milliseconds timeout = std::chrono::seconds(30))
+  {
+    return mOutput.waitFor(text, from, timeout);
+  }
+
+  // Runs the commands through the engine and returns everything it printed
+  std::string run(const std::string & commands)
+  {
+    std::istringstream input(commands + "\nquit\n");
+    std::ostringstream output;
+    std::streambuf * inputBuffer = std::cin.rdbuf(input.rdbuf());
+    std::streambuf * outputBuffer = std::cout.rdbuf(output.rdbuf());
+
+    UciEngine engine;
+    engine.run();
+
+    std::cin.rdbuf(inputBuffer);
+    std::cout.rdbuf(outputBuffer);
+    return output.str();
+  }
+
+  // Returns the score of the last info line, or INT32_MIN without one
+  static int32_t getScore(const std::string & output)
+  {
+    size_t position = output.rfind("score cp ");
+    return (position == std::string::npos) ? INT32_MIN : std::stoi(output.substr(position + 9));
+  }
+
+  // Returns the score of a search of the position on a board with a fresh table
+  static int32_t search(jcl::Board & board, const std::string & fen, int32_t depth)
+  {
+    jcl::Evaluation evaluation;
+    jcl::TranspositionTable table;
+    jcl::Search search(&board, &evaluation);
+    search.setTranspositionTable(&table);
+    board.setPosition(fen);
+    return search.execute(depth);
+  }
+
+protected:
+  Pipe mInput;
+  Pipe mOutput;
+  std::streambuf * mInputBuffer;
+  std::streambuf * mOutputBuffer;
+  UciEngine mEngine;
+  std::thread mEngineThread;
+};
+
+TEST_F(UciTest, TestEnPassantMove)
+{
+  std::string output = run("position startpos moves e2e4 a7a6 e4e5 d7d5 e5d6 e7d6");
+  EXPECT_EQ(output.find("Illegal move"), std::string::npos) << output;
+}
+
+TEST_F(UciTest, TestPromotionMove)
+{
+  // Only a knight on a8 can reach b6
+  std::string output = run("position fen 7k/P7/8/8/8/8/8/K7 w - - 0 1 moves a7a8n h8g7 a8b6");
+  EXPECT_EQ(output.find("Illegal move"), std::string::npos) << output;
+
+  output = run("position fen 7k/P7/8/8/8/8/8/K7 w - - 0 1 moves a7a8");
+  EXPECT_NE(output.find("Illegal move a7a8"), std::string::npos) << output;
+
+  output = run("position startpos moves e2e4q");
+  EXPECT_NE(output.find("Illegal move e2e4q"), std::string::npos) << output;
+}
+
+TEST_F(UciTest, TestMoveIntoCheck)
+{
+  std::string output = run("position fen 4k3/4r3/8/8/8/8/4B3/4K3 w - - 0 1 moves e2d3");
+  EXPECT_NE(output.find("Illegal move e2d3"), std::string::npos) << output;
+}
+
+TEST_F(UciTest, TestBitBoardSearch)
+{
+  // Mobility and king safety only exist on bitboards, so the engine scores
+  // the position as a bitboard search does and unlike a mailbox search
+  const std::string fen = "r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 0 7";
+  start();
+  send("position fen " + fen);
+  send("go depth 4");
+  ASSERT_NE(waitFor("bestmove"), std::string::npos) << mOutput.getText();
+  std::string output = mOutput.getText();
+
+  jcl::BitBoard bitBoard;
+  jcl::Board8x8 board8x8;
+  int32_t bitBoardScore = search(bitBoard, fen, 4);
+  EXPECT_EQ(getScore(output), bitBoardScore) << output;
+  EXPECT_NE(search(board8x8, fen, 4), bitBoardScore);
+}
+
+TEST_F(UciTest, TestStopLatency)
+{
+  // An infinite search is stopped soon after stop from deep in its tree
+  start();
+  send("position startpos");
+  send("go infinite");
+  ASSERT_NE(waitFor("info depth 8"), std::string::npos) << mOutput.getText();
+
+  auto stopTime = std::chrono::steady_clock::now();
+  send("stop");
+  size_t position = waitFor("bestmove ");
+  ASSERT_NE(position, std::string::npos) << mOutput.getText();
+  EXPECT_LT(std::chrono::steady_clock::now() - stopTime, std::chrono::milliseconds(500));
+
+  // The move is legal in the position
+  std::string output = mOutput.getText();
+  std::string bestMove = output.substr(position, output.find_first_of(" \n", position) - position);
+  send("position startpos moves " + bestMove);
+  send("isready");
+  ASSERT_NE(waitFor("readyok"), std::string::npos);
+  EXPECT_EQ(mOutput.getText().find("Illegal move"), std::string::npos) << mOutput.getText();
+}
+
+TEST_F(UciTest, TestInfiniteSearch)
+{
+  // An infinite search waits for stop even once its depth is reached
+  start();
+  send("position startpos moves e2e4 e7e5");
+  send("go infinite depth 2");
+  ASSERT_NE(waitFor("info depth 2"), std::string::npos) << mOutput.getText();
+  EXPECT_EQ(waitFor("bestmove", 0, std::chrono::milliseconds(300)), std::string::npos) << mOutput.getText();
+
+  send("stop");
+  EXPECT_NE(waitFor("bestmove", 0, std::chrono::seconds(1)), std::string::npos) << mOutput.getText();
+}
+
+TEST_F(UciTest, TestPonderHit)
+{
+  // A ponder search ignores the clock until the ponder hit
+  start();
+  send("position startpos moves e2e4");
+  send("go ponder wtime 1000 btime 1000");
+  EXPECT_EQ(waitFor("bestmove", 0, std::chrono::milliseconds(1500)), std::string::npos) << mOutput.getText();
+
+  // It then keeps the time it has used, which is already past its limit
+  auto hitTime = std::chrono::steady_clock::now();
+  send("ponderhit");
+  ASSERT_NE(waitFor("bestmove"), std::string::npos) << mOutput.getText();
+  EXPECT_LT(std::chrono::steady_clock::now() - hitTime, std::chrono::milliseconds(500));
+
+  // A ponder miss stops the search and a new one starts on the played move
+  size_t position = mOutput.getText().size();
+  send("go ponder wtime 1000 btime 1000");
+  send("stop");
+  position = waitFor("bestmove", position, std::chrono::seconds(1));
+  ASSERT_NE(position, std::string::npos) << mOutput.getText();
+  send("position startpos moves e2e4 c7c5");
+  send("go wtime 1000 btime 1000 movetime 100");
+  EXPECT_NE(waitFor("bestmove", position, std::chrono::seconds(2)), std::string::npos) << mOutput.getText();
+}
+
+TEST_F(UciTest, TestThreads)
+{
+  // Helper threads share the search and are stopped with it
+  start();
+  send("setoption name Threads value 4");
+  send("position fen r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 0 7");
+  send("go depth 5");
+  size_t position = waitFor("bestmove");
+  ASSERT_NE(position, std::string::npos) << mOutput.getText();
+  EXPECT_NE(mOutput.getText().find("info depth 5"), std::string::npos) << mOutput.getText();
+
+  send("go infinite");
+  ASSERT_NE(waitFor("info depth 4", position), std::string::npos) << mOutput.getText();
+  auto stopTime = std::chrono::steady_clock::now();
+  send("stop");
+  ASSERT_NE(waitFor("bestmove", position), std::string::npos) << mOutput.getText();
+  EXPECT_LT(std::chrono::steady_clock::now() - stopTime, std::chrono::milliseconds(500));
+}
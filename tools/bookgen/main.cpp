@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jcl_bitboard.h"
+#include "jcl_openingbookbuilder.h"
+
+// Builds an opening book from PGN files, for example:
+//   jcl_bookgen -o book.bin -p 24 -m 2 -t 4 games1.pgn games2.pgn
+// The files are read as a stream on the calling thread, which splits them
+// into games and hands them in batches to worker threads. Each worker plays
+// the moves on its own board and counts them in the shared builder. Games
+// without a decisive or drawn result are skipped.
+
+static const char * StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static const size_t BatchSize = 1024;
+
+struct Game
+{
+  std::string fen;
+  std::vector<std::string> moves;
+  jcl::OpeningBookBuilder::GameResult result = jcl::OpeningBookBuilder::GameResult::Draw;
+  bool hasResult = false;
+};
+
+// Batches of games waiting for a worker, bounded so reading cannot run far ahead
+class GameQueue
+{
+public:
+  explicit GameQueue(size_t capacity)
+    : mCapacity(capacity)
+    , mClosed(false)
+  {
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosed = true;
+    mCondition.notify_all();
+  }
+
+  bool pop(std::vector<Game> & batch)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] { return !mBatches.empty() || mClosed; });
+    if (mBatches.empty())
+    {
+      return false;
+    }
+
+    batch = std::move(mBatches.front());
+    mBatches.pop_front();
+    mCondition.notify_all();
+    return true;
+  }
+
+  void push(std::vector<Game> && batch)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] { return mBatches.size() < mCapacity; });
+    mBatches.push_back(std::move(batch));
+    mCondition.notify_all();
+  }
+
+private:
+  size_t mCapacity;
+  bool mClosed;
+  std::deque<std::vector<Game>> mBatches;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+};
+
+// Reads the value of a tag pair such as [Result "1-0"]
+static bool readTag(const std::string & line, std::string & name, std::string & value)
+{
+  size_t nameEnd = line.find(' ');
+  size_t valueStart = line.find('"');
+  size_t valueEnd = line.rfind('"');
+  if (nameEnd == std::string::npos || valueStart == std::string::npos || valueEnd <= valueStart)
+  {
+    return false;
+  }
+
+  name = line.substr(1, nameEnd - 1);
+  value = line.substr(valueStart + 1, valueEnd - valueStart - 1);
+  return true;
+}
+
+// Splits a line of movetext into moves, skipping comments, variations,
+// move numbers, annotation glyphs and results, and keeping at most maxPlies
+static void readMoves(const std::string & line, int & commentDepth, int & variationDepth, size_t maxPlies, std::vector<std::string> & moves)
+{
+  std::string token;
+  auto flush = [&]()
+  {
+    // Move numbers may be written against the move, as in 1.e4
+    size_t start = 0;
+    while (start < token.size() && ((token[start] >= '0' && token[start] <= '9') || token[start] == '.'))
+    {
+      start++;
+    }
+    bool number = (start > 0 && token.find('.') != std::string::npos && token.find('.') < start);
+    std::string move = number ? token.substr(start) : token;
+    if (!move.empty() && move[0] != '$' && move != "*" && move != "1-0" && move != "0-1" && move != "1/2-1/2" &&
+        moves.size() < maxPlies)
+    {
+      moves.push_back(move);
+    }
+    token.clear();
+  };
+
+  for (char c : line)
+  {
+    if (commentDepth > 0)
+    {
+      commentDepth = (c == '}') ? 0 : commentDepth;
+      continue;
+    }
+
+    if (c == ';')
+    {
+      break;
+    }
+    else if (c == '{')
+    {
+      flush();
+      commentDepth = 1;
+    }
+    else if (c == '(')
+    {
+      flush();
+      variationDepth++;
+    }
+    else if (c == ')')
+    {
+      token.clear();
+      variationDepth = std::max(variationDepth - 1, 0);
+    }
+    else if (variationDepth > 0)
+    {
+      continue;
+    }
+    else if (c == ' ' || c == '\t' || c == '\r')
+    {
+      flush();
+    }
+    else
+    {
+      token += c;
+    }
+  }
+  flush();
+}
+
+static void printUsage()
+{
+  std::cerr << "Usage: jcl_bookgen [-o book] [-p plies] [-m min games] [-t threads] file.pgn..." << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+  std::string outputFile = "book.bin";
+  uint32_t maxPlies = 24;
+  uint32_t minGames = 1;
+  size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+  std::vector<std::string> inputFiles;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string argument = argv[i];
+    if (argument == "-o" && i + 1 < argc)
+    {
+      outputFile = argv[++i];
+    }
+    else if (argument == "-p" && i + 1 < argc)
+    {
+      maxPlies = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (argument == "-m" && i + 1 < argc)
+    {
+      minGames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (argument == "-t" && i + 1 < argc)
+    {
+      threadCount = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (!argument.empty() && argument[0] == '-')
+    {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+    else
+    {
+      inputFiles.push_back(argument);
+    }
+  }
+
+  if (inputFiles.empty())
+  {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  jcl::OpeningBookBuilder builder(maxPlies);
+  GameQueue queue(4 * threadCount);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < threadCount; i++)
+  {
+    workers.emplace_back([&builder, &queue]()
+    {
+      jcl::BitBoard board;
+      std::vector<Game> batch;
+      while (queue.pop(batch))
+      {
+        for (const Game & game : batch)
+        {
+          if (board.setPosition(game.fen.empty() ? StartFen : game.fen))
+          {
+            builder.addGame(&board, game.moves, game.result);
+          }
+        }
+      }
+    });
+  }
+
+  // Tag pairs start a game, the movetext follows them
+  uint64_t gameCount = 0;
+  std::vector<Game> batch;
+  Game game;
+  bool inMovetext = false;
+  int commentDepth = 0;
+  int variationDepth = 0;
+  auto finishGame = [&]()
+  {
+    if (game.hasResult && !game.moves.empty())
+    {
+      batch.push_back(std::move(game));
+      gameCount++;
+      if (batch.size() >= BatchSize)
+      {
+        queue.push(std::move(batch));
+        batch.clear();
+      }
+    }
+
+    game = Game();
+    inMovetext = false;
+    commentDepth = 0;
+    variationDepth = 0;
+  };
+
+  for (const std::string & inputFile : inputFiles)
+  {
+    std::ifstream inputStream(inputFile);
+    if (!inputStream)
+    {
+      std::cerr << "Could not open " << inputFile << std::endl;
+      continue;
+    }
+
+    std::string line;
+    while (std::getline(inputStream, line))
+    {
+      if (commentDepth == 0 && !line.empty() && line[0] == '[')
+      {
+        if (inMovetext)
+        {
+          finishGame();
+        }
+
+        std::string name, value;
+        if (readTag(line, name, value))
+        {
+          if (name == "FEN")
+          {
+            game.fen = value;
+          }
+          else if (name == "Result")
+          {
+            game.hasResult = (value == "1-0" || value == "0-1" || value == "1/2-1/2");
+            game.result = (value == "1-0") ? jcl::OpeningBookBuilder::GameResult::WhiteWin
+                        : (value == "0-1") ? jcl::OpeningBookBuilder::GameResult::BlackWin
+                                           : jcl::OpeningBookBuilder::GameResult::Draw;
+          }
+        }
+      }
+      else if (!line.empty())
+      {
+        inMovetext = true;
+        readMoves(line, commentDepth, variationDepth, maxPlies, game.moves);
+      }
+    }
+    finishGame();
+  }
+
+  if (!batch.empty())
+  {
+    queue.push(std::move(batch));
+  }
+  queue.close();
+  for (std::thread & worker : workers)
+  {
+    worker.join();
+  }
+
+  size_t entryCount = builder.save(outputFile, minGames);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << gameCount << " games, " << builder.getEntryCount() << " positions and moves, "
+            << entryCount << " entries written to " << outputFile << " in " << seconds << " s" << std::endl;
+
+  return (entryCount > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -8,6 +8,7 @@
 #include "jcl_board.h"
 #include "jcl_fen.h"
 #include "jcl_perft.h"
+#include "jcl_piecesquare.h"
 #include "jcl_timer.h"
 #include "jcl_types.h"
 #include "jcl_util.h"
@@ -101,6 +102,10 @@ void ConsoleGame::run()
     {
       handleEval();
     }
+    else if (commandString == "benchpst")
+    {
+      handleBenchPieceSquare(iss);
+    }
     // else if (commandString == "engine")
     //   handleEngine();
     else if (commandString == "new")
@@ -147,6 +152,61 @@ void ConsoleGame::handleDivide(std::istringstream & iss) const
   perft.divide(perftLevel);
 }
 
+void ConsoleGame::handleBenchPieceSquare(std::istringstream & iss) const
+{
+  uint32_t count = readValue<uint32_t>(iss);
+  if (count == 0)
+  {
+    count = 1000000;
+  }
+
+  // Summing square by square, as the evaluation did before the board kept the sum
+  jcl::Timer timer;
+  timer.start();
+  int64_t loopSum = 0;
+  for (uint32_t n = 0; n < count; n++)
+  {
+    jcl::Score score = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      for (uint8_t j = 0; j < 8; j++)
+      {
+        score += jcl::PieceSquare::getValue(mBoard->getPieceType(i, j), i, j);
+      }
+    }
+    loopSum += score;
+  }
+  timer.stop();
+  double loopTime = timer.elapsed();
+
+  // Computed by the board, from bit planes for a bitboard
+  timer.restart();
+  int64_t boardSum = 0;
+  for (uint32_t n = 0; n < count; n++)
+  {
+    boardSum += mBoard->computePieceSquareScore();
+  }
+  timer.stop();
+  double boardTime = timer.elapsed();
+
+  // The whole evaluation, which reads the sum the board keeps up to date
+  timer.restart();
+  int64_t evaluationSum = 0;
+  for (uint32_t n = 0; n < count; n++)
+  {
+    evaluationSum += mEvaluation->evaluateBoard(mBoard);
+  }
+  timer.stop();
+  double evaluationTime = timer.elapsed();
+
+  int64_t expectedSum = static_cast<int64_t>(mBoard->getPieceSquareScore()) * count;
+  bool match = (loopSum == expectedSum && boardSum == expectedSum);
+  std::cout << "Square loop: " << loopTime * 1e3 / count << " ns\n";
+  std::cout << "Board sum:   " << boardTime * 1e3 / count << " ns\n";
+  std::cout << "Evaluation:  " << evaluationTime * 1e3 / count << " ns (score " << evaluationSum / count << ")\n";
+  std::cout << "Sums " << (match ? "match" : "differ") << " the incremental score\n";
+}
+
 void ConsoleGame::handleEval() const
 {
   jcl::MoveList moveList;
@@ -162,7 +222,7 @@ void ConsoleGame::handleEval() const
     uint8_t kingCol = mBoard->getKingColumn(!mBoard->getSideToMove());
     if (!mBoard->isCellAttacked(kingRow, kingCol, mBoard->getSideToMove()))
     {
-      double score = mEvaluation->evaluateBoard(mBoard);
+      int32_t score = mEvaluation->evaluateBoard(mBoard);
       std::cout << score << "\n";
     }
     mBoard->unmakeMove(m);
@@ -177,6 +237,7 @@ void ConsoleGame::handleHelp() const
   //std::cout << "disp.................Same as print\n";
   std::cout << "new..................Start a new game\n";
   std::cout << "eval.................Evaluation the current board position\n";
+  std::cout << "benchpst <count>.....Times the piece-square sum of the current position\n";
   std::cout << "move <smith>.........Performs a move\n";
   std::cout << "perft <level>........Counts the total number of nodes to depth <level>\n";
   //std::cout << "divide <level>.......Displays the number of child moves\n";
@@ -21,6 +21,7 @@ private:
   int32_t getMoveIndex(uint8_t srcRow, uint8_t srcCol, uint8_t dstRow, uint8_t dstCol, const jcl::MoveList & moveList) const;
   void doMove(const jcl::Move * move);
   void doPerft(int32_t perftLevel) const;
+  void handleBenchPieceSquare(std::istringstream & iss) const;
   void handleDivide(std::istringstream & iss) const;
   // void handleEngine();
   void handleEval() const;
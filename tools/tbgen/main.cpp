@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jcl_tablebase.h"
+#include "jcl_tablebasegenerator.h"
+
+// Generates endgame tables offline, for example:
+//   jcl_tbgen -t 4 -d tables KQvK KRvK KPvK KRPvKR
+// Every table a signature reaches through captures and promotions is
+// generated first, unless its file is already in the directory.
+
+static void printUsage()
+{
+  std::cerr << "Usage: jcl_tbgen [-t threads] [-d directory] signature..." << std::endl;
+}
+
+// Prints the outcome counts and the longest win of a table
+static void printTable(const jcl::EndgameTable & table, uint32_t passCount, double seconds)
+{
+  uint64_t wins = 0;
+  uint64_t losses = 0;
+  int32_t longestWin = 0;
+  for (uint64_t i = 0; i < table.getEntryCount(); i++)
+  {
+    uint8_t value = table.getValue(i);
+    if (jcl::EndgameTable::isWin(value))
+    {
+      wins++;
+      longestWin = std::max(longestWin, jcl::EndgameTable::getDistance(value));
+    }
+    else if (jcl::EndgameTable::isLoss(value))
+    {
+      losses++;
+    }
+  }
+
+  std::cout << jcl::EndgameTable::getSignature(table.getMaterialKey())
+            << ": " << table.getEntryCount() << " entries, "
+            << wins << " won, " << losses << " lost, "
+            << "longest win " << longestWin << " moves, "
+            << passCount << " passes, " << seconds << " s" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+  size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+  std::string directory = ".";
+  std::vector<std::string> signatures;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string argument = argv[i];
+    if (argument == "-t" && i + 1 < argc)
+    {
+      threadCount = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (argument == "-d" && i + 1 < argc)
+    {
+      directory = argv[++i];
+    }
+    else if (!argument.empty() && argument[0] == '-')
+    {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+    else
+    {
+      signatures.push_back(argument);
+    }
+  }
+
+  if (signatures.empty())
+  {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  jcl::Tablebase tablebase;
+  jcl::TablebaseGenerator generator(&tablebase, threadCount);
+  generator.setDirectory(directory);
+
+  auto start = std::chrono::steady_clock::now();
+  generator.setTableCallback([&start](const jcl::EndgameTable & table, uint32_t passCount)
+  {
+    auto now = std::chrono::steady_clock::now();
+    printTable(table, passCount, std::chrono::duration<double>(now - start).count());
+    start = now;
+  });
+
+  for (const std::string & signature : signatures)
+  {
+    if (!generator.generate(signature))
+    {
+      std::cerr << "Could not generate " << signature << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
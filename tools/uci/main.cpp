@@ -0,0 +1,12 @@
+#include <cstdlib>
+#include <memory>
+
+#include "uciengine.h"
+
+int main(int argc, char ** argv)
+{
+  std::unique_ptr<UciEngine> engine(new UciEngine);
+  engine->run();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,659 @@
+#include "uciengine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "jcl_movelist.h"
+#include "jcl_types.h"
+
+static const char * StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Option limits
+static const size_t DefaultEvalCache = 4;
+static const size_t DefaultHash = 16;
+static const size_t MaxHash = 4096;
+static const uint32_t MaxMultiPv = 64;
+static const size_t MaxThreads = 64;
+
+UciEngine::Worker::Worker()
+  : search(&board, &evaluation)
+{
+}
+
+UciEngine::UciEngine()
+  : mStop(false)
+  , mInfinite(false)
+  , mOwnBook(false)
+  , mPonder(false)
+  , mStartFen(StartFen)
+  , mEvaluationCache(DefaultEvalCache)
+  , mRandom(std::random_device()())
+  , mTable(DefaultHash)
+{
+  resizeWorkers(1);
+}
+
+UciEngine::~UciEngine()
+{
+  stopSearch();
+}
+
+bool UciEngine::applyMove(jcl::Board * board, const std::string & moveString) const
+{
+  if (moveString.size() < 4)
+  {
+    return false;
+  }
+
+  uint8_t srcCol = moveString[0] - 'a';
+  uint8_t srcRow = moveString[1] - '1';
+  uint8_t dstCol = moveString[2] - 'a';
+  uint8_t dstRow = moveString[3] - '1';
+
+  jcl::Piece promotedPiece = jcl::Piece::None;
+  if (moveString.size() > 4)
+  {
+    switch (moveString[4])
+    {
+      case 'q': promotedPiece = jcl::Piece::Queen; break;
+      case 'r': promotedPiece = jcl::Piece::Rook; break;
+      case 'b': promotedPiece = jcl::Piece::Bishop; break;
+      case 'n': promotedPiece = jcl::Piece::Knight; break;
+      default: return false;
+    }
+  }
+
+  // Only promotions carry a promoted piece, en passant captures store a pawn
+  jcl::MoveList moveList;
+  board->generateMoves(moveList);
+  jcl::Color side = board->getSideToMove();
+  for (uint32_t i = 0; i < moveList.size(); i++)
+  {
+    const jcl::Move * move = moveList[i];
+    bool promotion = move->isPromotion() || move->isPromotionCapture();
+    if (move->getSourceRow() != srcRow || move->getSourceColumn() != srcCol ||
+        move->getDestinationRow() != dstRow || move->getDestinationColumn() != dstCol ||
+        (promotion ? move->getPromotedPiece() : jcl::Piece::None) != promotedPiece)
+    {
+      continue;
+    }
+
+    // The generated moves are pseudo-legal, so the own king must not be left in check
+    board->makeMove(move);
+    if (board->isCellAttacked(board->getKingRow(side), board->getKingColumn(side), !side))
+    {
+      board->unmakeMove(move);
+      return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+std::string UciEngine::findPonderMove(Worker * worker) const
+{
+  const jcl::Search & search = worker->search;
+  const jcl::Move & bestMove = search.getBestMove();
+
+  jcl::MoveList pv;
+  search.getPrincipalVariation(pv);
+  if (pv.size() > 1)
+  {
+    return toUciNotation(*pv[1]);
+  }
+
+  // A variation cut short by the table still leaves the reply in the table
+  jcl::Board & board = worker->board;
+  jcl::TranspositionTable::Data data;
+  std::string ponderMove;
+  board.makeMove(&bestMove);
+  if (mTable.probe(board.getHashKey(), data) && data.hasMove)
+  {
+    jcl::MoveList moveList;
+    board.generateMoves(moveList);
+    for (uint32_t i = 0; i < moveList.size(); i++)
+    {
+      const jcl::Move * move = moveList[i];
+      if (move->getSourceRow() == data.sourceRow && move->getSourceColumn() == data.sourceColumn &&
+          move->getDestinationRow() == data.destinationRow && move->getDestinationColumn() == data.destinationColumn &&
+          move->getPromotedPiece() == data.promotedPiece)
+      {
+        ponderMove = toUciNotation(*move);
+        break;
+      }
+    }
+  }
+  board.unmakeMove(&bestMove);
+  return ponderMove;
+}
+
+void UciEngine::handleGo(std::istringstream & iss)
+{
+  stopSearch();
+
+  GoLimits limits;
+  std::string token;
+  while (iss >> token)
+  {
+    if (token == "wtime")
+      iss >> limits.time[static_cast<int>(jcl::Color::White)];
+    else if (token == "btime")
+      iss >> limits.time[static_cast<int>(jcl::Color::Black)];
+    else if (token == "winc")
+      iss >> limits.increment[static_cast<int>(jcl::Color::White)];
+    else if (token == "binc")
+      iss >> limits.increment[static_cast<int>(jcl::Color::Black)];
+    else if (token == "movestogo")
+      iss >> limits.movesToGo;
+    else if (token == "depth")
+      iss >> limits.depth;
+    else if (token == "nodes")
+      iss >> limits.nodes;
+    else if (token == "mate")
+      iss >> limits.mate;
+    else if (token == "movetime")
+      iss >> limits.moveTime;
+    else if (token == "infinite")
+      limits.infinite = true;
+    else if (token == "ponder")
+      limits.ponder = true;
+  }
+
+  // A book move is played at once, analysis and pondering always search
+  jcl::Move bookMove;
+  if (mOwnBook && mBook.isLoaded() && !limits.infinite && !limits.ponder &&
+      mBook.selectMove(&mWorkers[0]->board, mRandom(), bookMove))
+  {
+    send("bestmove " + toUciNotation(bookMove));
+    return;
+  }
+
+  int side = static_cast<int>(mWorkers[0]->board.getSideToMove());
+  if (limits.moveTime > 0)
+  {
+    mTimeManager.startFixed(limits.moveTime);
+  }
+  else if (limits.time[side] > 0 && !limits.infinite)
+  {
+    mTimeManager.start(limits.time[side], limits.increment[side], limits.movesToGo);
+  }
+  else
+  {
+    mTimeManager.startInfinite();
+  }
+
+  mStop = false;
+  mInfinite = limits.infinite;
+  mTimeManager.setPondering(limits.ponder);
+  mTable.newSearch();
+  mSearchThread = std::thread(&UciEngine::searchMain, this, limits);
+}
+
+void UciEngine::handleNewGame()
+{
+  stopSearch();
+  mTable.clear();
+  mEvaluationCache.clear();
+}
+
+void UciEngine::handlePonderHit()
+{
+  // The ponder search becomes the real search, keeping the time it has used.
+  // The search thread checks the limits itself once it sees pondering end.
+  std::lock_guard<std::mutex> lock(mStateMutex);
+  mTimeManager.setPondering(false);
+  mStateCondition.notify_all();
+}
+
+void UciEngine::handlePosition(std::istringstream & iss)
+{
+  std::string token;
+  std::string fen;
+  iss >> token;
+  if (token == "startpos")
+  {
+    fen = StartFen;
+    iss >> token;
+  }
+  else if (token == "fen")
+  {
+    while (iss >> token && token != "moves")
+    {
+      fen += (fen.empty() ? "" : " ") + token;
+    }
+  }
+  else
+  {
+    return;
+  }
+
+  std::vector<std::string> moves;
+  if (token == "moves")
+  {
+    while (iss >> token)
+    {
+      moves.push_back(token);
+    }
+  }
+
+  stopSearch();
+
+  // When the game has only moved on, only the new moves are played
+  bool extends = (fen == mStartFen && moves.size() >= mMoves.size() &&
+                  std::equal(mMoves.begin(), mMoves.end(), moves.begin()));
+  size_t firstMove = extends ? mMoves.size() : 0;
+
+  mStartFen = fen;
+  mMoves = moves;
+  for (size_t i = 0; i < mWorkers.size(); i++)
+  {
+    size_t applied = setWorkerPosition(mWorkers[i].get(), firstMove);
+    if (applied < mMoves.size())
+    {
+      send("info string Illegal move " + mMoves[applied]);
+      mMoves.resize(applied);
+    }
+  }
+}
+
+void UciEngine::handleSetOption(std::istringstream & iss)
+{
+  std::string token;
+  std::string name;
+  std::string value;
+  iss >> token;
+  while (iss >> token && token != "value")
+  {
+    name += (name.empty() ? "" : " ") + token;
+  }
+  std::getline(iss >> std::ws, value);
+  value.erase(value.find_last_not_of(" \t\r") + 1);
+
+  stopSearch();
+  if (name == "BookFile")
+  {
+    if (value.empty() || value == "<empty>")
+    {
+      mBook.unload();
+    }
+    else if (!mBook.load(value))
+    {
+      send("info string Could not load book " + value);
+    }
+  }
+  else if (name == "EvalFile")
+  {
+    // An empty name goes back to the hand-written evaluation
+    if (value.empty() || value == "<empty>")
+    {
+      mNetwork.unload();
+    }
+    else if (!mNetwork.load(value))
+    {
+      send("info string Could not load network " + value);
+    }
+
+    for (size_t i = 0; i < mWorkers.size(); i++)
+    {
+      mWorkers[i]->board.setNetwork(mNetwork.isLoaded() ? &mNetwork : nullptr);
+    }
+    mEvaluationCache.clear();
+  }
+  else if (name == "EvalCache")
+  {
+    size_t megabytes = std::strtoul(value.c_str(), nullptr, 10);
+    mEvaluationCache.resize(std::max<size_t>(1, std::min(megabytes, MaxHash)));
+  }
+  else if (name == "Hash")
+  {
+    size_t megabytes = std::strtoul(value.c_str(), nullptr, 10);
+    mTable.resize(std::max<size_t>(1, std::min(megabytes, MaxHash)));
+  }
+  else if (name == "MultiPV")
+  {
+    uint32_t count = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    mWorkers[0]->search.setMultiPv(std::max<uint32_t>(1, std::min(count, MaxMultiPv)));
+  }
+  else if (name == "OwnBook")
+  {
+    mOwnBook = (value == "true");
+  }
+  else if (name == "Ponder")
+  {
+    mPonder = (value == "true");
+  }
+  else if (name == "TablebasePath")
+  {
+    // The workers keep probing the same tablebase, which is only reloaded here
+    mTablebase.clear();
+    if (!value.empty() && value != "<empty>")
+    {
+      size_t count = mTablebase.load(value);
+      send("info string Loaded " + std::to_string(count) + " tablebase files from " + value);
+    }
+  }
+  else if (name == "Threads")
+  {
+    size_t count = std::strtoul(value.c_str(), nullptr, 10);
+    resizeWorkers(std::max<size_t>(1, std::min(count, MaxThreads)));
+  }
+  else
+  {
+    send("info string Unknown option " + name);
+  }
+}
+
+void UciEngine::handleStop()
+{
+  std::lock_guard<std::mutex> lock(mStateMutex);
+  mStop = true;
+  mStateCondition.notify_all();
+}
+
+void UciEngine::handleUci() const
+{
+  send("id name jchess");
+  send("id author Jeff Meese");
+  send("option name BookFile type string default <empty>");
+  send("option name EvalFile type string default <empty>");
+  send("option name EvalCache type spin default " + std::to_string(DefaultEvalCache) + " min 1 max " + std::to_string(MaxHash));
+  send("option name Hash type spin default " + std::to_string(DefaultHash) + " min 1 max " + std::to_string(MaxHash));
+  send("option name TablebasePath type string default <empty>");
+  send("option name Threads type spin default 1 min 1 max " + std::to_string(MaxThreads));
+  send("option name MultiPV type spin default 1 min 1 max " + std::to_string(MaxMultiPv));
+  send(std::string("option name OwnBook type check default ") + (mOwnBook ? "true" : "false"));
+  send(std::string("option name Ponder type check default ") + (mPonder ? "true" : "false"));
+  send("uciok");
+}
+
+void UciEngine::reportIteration(int32_t depth)
+{
+  const jcl::Search & search = mWorkers[0]->search;
+
+  uint64_t nodes = 0;
+  for (size_t i = 0; i < mWorkers.size(); i++)
+  {
+    nodes += mWorkers[i]->search.getNodes();
+  }
+
+  int64_t elapsed = mTimeManager.getElapsed();
+  uint64_t nps = nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(elapsed, 1));
+
+  // One info line for each line searched, best first
+  for (uint32_t line = 0; line < search.getLineCount(); line++)
+  {
+    std::ostringstream oss;
+    oss << "info depth " << depth << " seldepth " << search.getSelectiveDepth();
+    if (search.getMultiPv() > 1)
+    {
+      oss << " multipv " << line + 1;
+    }
+
+    int32_t score = search.getLineScore(line);
+    if (std::abs(score) >= jcl::Search::MATE_SCORE - jcl::Search::MAX_PLY)
+    {
+      int32_t mateIn = (score > 0) ? (jcl::Search::MATE_SCORE - score + 1) / 2 : -(jcl::Search::MATE_SCORE + score) / 2;
+      oss << " score mate " << mateIn;
+    }
+    else
+    {
+      oss << " score cp " << score;
+    }
+    oss << " nodes " << nodes << " nps " << nps << " hashfull " << mTable.getHashFull() << " time " << elapsed;
+
+    jcl::MoveList pv;
+    search.getPrincipalVariation(pv, line);
+    oss << " pv";
+    for (uint32_t i = 0; i < pv.size(); i++)
+    {
+      oss << " " << toUciNotation(*pv[i]);
+    }
+    send(oss.str());
+  }
+}
+
+void UciEngine::reportHitRates() const
+{
+  uint64_t pawnHits = 0;
+  uint64_t pawnProbes = 0;
+  uint64_t materialHits = 0;
+  uint64_t materialProbes = 0;
+  uint64_t evaluationHits = 0;
+  uint64_t evaluationProbes = 0;
+  uint64_t tablebaseHits = 0;
+  uint64_t lazyEvaluations = 0;
+  uint64_t lazyCutoffs[jcl::Evaluation::STAGE_COUNT] = { 0 };
+  for (size_t i = 0; i < mWorkers.size(); i++)
+  {
+    lazyEvaluations += mWorkers[i]->evaluation.getLazyEvaluations();
+    for (uint32_t stage = 0; stage < jcl::Evaluation::STAGE_COUNT; stage++)
+    {
+      lazyCutoffs[stage] += mWorkers[i]->evaluation.getLazyCutoffs(static_cast<jcl::Evaluation::Stage>(stage));
+    }
+    pawnHits += mWorkers[i]->evaluation.getPawnTable().getHits();
+    pawnProbes += mWorkers[i]->evaluation.getPawnTable().getProbes();
+    materialHits += mWorkers[i]->evaluation.getMaterialTable().getHits();
+    materialProbes += mWorkers[i]->evaluation.getMaterialTable().getProbes();
+    evaluationHits += mWorkers[i]->search.getEvaluationCacheHits();
+    evaluationProbes += mWorkers[i]->search.getEvaluationCacheProbes();
+    tablebaseHits += mWorkers[i]->search.getTablebaseHits();
+  }
+
+  if (evaluationProbes > 0)
+  {
+    std::ostringstream oss;
+    oss << "info string evaluation cache hit rate " << std::fixed << std::setprecision(1) << (100.0 * evaluationHits / evaluationProbes) << "%";
+    send(oss.str());
+  }
+
+  // Lazy evaluations that stopped after the material and pawn structure stages
+  if (lazyEvaluations > 0)
+  {
+    std::ostringstream oss;
+    oss << "info string lazy evaluation cut " << std::fixed << std::setprecision(1)
+        << (100.0 * lazyCutoffs[static_cast<uint32_t>(jcl::Evaluation::Stage::Material)] / lazyEvaluations) << "% after material, "
+        << (100.0 * lazyCutoffs[static_cast<uint32_t>(jcl::Evaluation::Stage::PawnStructure)] / lazyEvaluations) << "% after pawns";
+    send(oss.str());
+  }
+
+  if (pawnProbes > 0)
+  {
+    std::ostringstream oss;
+    oss << "info string pawn table hit rate " << std::fixed << std::setprecision(1) << (100.0 * pawnHits / pawnProbes) << "%";
+    send(oss.str());
+  }
+
+  if (materialProbes > 0)
+  {
+    std::ostringstream oss;
+    oss << "info string material table hit rate " << std::fixed << std::setprecision(1) << (100.0 * materialHits / materialProbes) << "%";
+    send(oss.str());
+  }
+
+  if (tablebaseHits > 0)
+  {
+    send("info string tablebase hits " + std::to_string(tablebaseHits));
+  }
+}
+
+void UciEngine::resizeWorkers(size_t count)
+{
+  while (mWorkers.size() > count)
+  {
+    mWorkers.pop_back();
+  }
+
+  while (mWorkers.size() < count)
+  {
+    std::unique_ptr<Worker> worker(new Worker);
+    worker->search.setTranspositionTable(&mTable);
+    worker->search.setStopFlag(&mStop);
+    worker->search.setEvaluationCache(&mEvaluationCache);
+    worker->search.setTablebase(&mTablebase);
+    worker->board.setNetwork(mNetwork.isLoaded() ? &mNetwork : nullptr);
+    setWorkerPosition(worker.get(), 0);
+    mWorkers.push_back(std::move(worker));
+  }
+}
+
+void UciEngine::run()
+{
+  std::string inputString;
+  while (std::getline(std::cin, inputString))
+  {
+    std::istringstream iss(inputString);
+    std::string commandString;
+    iss >> commandString;
+
+    if (commandString == "quit")
+    {
+      break;
+    }
+    else if (commandString == "uci")
+    {
+      handleUci();
+    }
+    else if (commandString == "isready")
+    {
+      send("readyok");
+    }
+    else if (commandString == "ucinewgame")
+    {
+      handleNewGame();
+    }
+    else if (commandString == "position")
+    {
+      handlePosition(iss);
+    }
+    else if (commandString == "go")
+    {
+      handleGo(iss);
+    }
+    else if (commandString == "stop")
+    {
+      handleStop();
+    }
+    else if (commandString == "ponderhit")
+    {
+      handlePonderHit();
+    }
+    else if (commandString == "setoption")
+    {
+      handleSetOption(iss);
+    }
+  }
+
+  stopSearch();
+}
+
+void UciEngine::searchMain(GoLimits limits)
+{
+  int32_t depth = jcl::Search::MAX_PLY;
+  if (limits.depth > 0)
+  {
+    depth = std::min(limits.depth, depth);
+  }
+  else if (limits.mate > 0)
+  {
+    depth = std::min(2 * limits.mate - 1, depth);
+  }
+
+  for (size_t i = 0; i < mWorkers.size(); i++)
+  {
+    mWorkers[i]->search.clearStatistics();
+    mWorkers[i]->evaluation.getPawnTable().clearStatistics();
+    mWorkers[i]->evaluation.getMaterialTable().clearStatistics();
+    mWorkers[i]->evaluation.clearStatistics();
+  }
+
+  // Helper threads search the same position and share results through the table
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < mWorkers.size(); i++)
+  {
+    jcl::Search * search = &mWorkers[i]->search;
+    helpers.emplace_back([search] { search->execute(jcl::Search::MAX_PLY); });
+  }
+
+  jcl::Search & search = mWorkers[0]->search;
+  search.setTimeManager(&mTimeManager);
+  search.setNodeLimit(limits.nodes);
+  search.setIterationCallback([this](int32_t iterationDepth, int32_t) { reportIteration(iterationDepth); });
+  search.execute(depth);
+
+  // In infinite and ponder mode the best move is only sent when the GUI asks for it
+  {
+    std::unique_lock<std::mutex> lock(mStateMutex);
+    mStateCondition.wait(lock, [this] { return mStop || (!mInfinite && !mTimeManager.isPondering()); });
+  }
+
+  mStop = true;
+  for (size_t i = 0; i < helpers.size(); i++)
+  {
+    helpers[i].join();
+  }
+
+  reportHitRates();
+
+  // The expected reply lets the GUI start the next ponder search
+  const jcl::Move & bestMove = search.getBestMove();
+  if (bestMove.getPiece() == jcl::Piece::None)
+  {
+    send("bestmove 0000");
+  }
+  else
+  {
+    std::string ponderMove = findPonderMove(mWorkers[0].get());
+    send("bestmove " + toUciNotation(bestMove) + (ponderMove.empty() ? "" : " ponder " + ponderMove));
+  }
+}
+
+void UciEngine::send(const std::string & line) const
+{
+  std::lock_guard<std::mutex> lock(mOutputMutex);
+  std::cout << line << std::endl;
+}
+
+size_t UciEngine::setWorkerPosition(Worker * worker, size_t firstMove)
+{
+  jcl::Board & board = worker->board;
+  if (firstMove == 0 && !board.setPosition(mStartFen))
+  {
+    return 0;
+  }
+
+  for (size_t i = firstMove; i < mMoves.size(); i++)
+  {
+    if (!applyMove(&board, mMoves[i]))
+    {
+      return i;
+    }
+  }
+
+  return mMoves.size();
+}
+
+void UciEngine::stopSearch()
+{
+  if (mSearchThread.joinable())
+  {
+    handleStop();
+    mSearchThread.join();
+  }
+}
+
+std::string UciEngine::toUciNotation(const jcl::Move & move)
+{
+  std::string notation = move.toSmithNotation();
+  switch (move.getPromotedPiece())
+  {
+    case jcl::Piece::Queen: notation += 'q'; break;
+    case jcl::Piece::Rook: notation += 'r'; break;
+    case jcl::Piece::Bishop: notation += 'b'; break;
+    case jcl::Piece::Knight: notation += 'n'; break;
+    default: break;
+  }
+  return notation;
+}
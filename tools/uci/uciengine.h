@@ -0,0 +1,112 @@
+#ifndef UCIENGINE_H
+#define UCIENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jcl_bitboard.h"
+#include "jcl_evaluation.h"
+#include "jcl_evaluationcache.h"
+#include "jcl_network.h"
+#include "jcl_openingbook.h"
+#include "jcl_search.h"
+#include "jcl_tablebase.h"
+#include "jcl_timemanager.h"
+#include "jcl_transpositiontable.h"
+
+// Runs the Universal Chess Interface protocol on standard input and output.
+// Commands are read on the calling thread while the search runs on worker
+// threads, so stop, ponderhit and isready are answered during a search.
+// A ponder search runs without enforcing the clock. On ponderhit it simply
+// carries on as the real search, keeping its table and the time it has
+// used, and on a miss the GUI stops it and starts a new search.
+// Setting EvalFile loads a network that all workers evaluate with in place
+// of the hand-written evaluation.
+// EvalCache sizes the evaluation cache, which the workers share like the table.
+// BookFile loads an opening book and OwnBook plays its moves, chosen at random
+// by weight, without searching while the position is in the book.
+// TablebasePath loads the endgame tables of a directory, which the workers
+// share and probe during the search.
+class UciEngine
+{
+public:
+  UciEngine();
+  ~UciEngine();
+
+public:
+  void run();
+
+private:
+  struct GoLimits
+  {
+    int64_t time[2] = { 0, 0 };
+    int64_t increment[2] = { 0, 0 };
+    int32_t movesToGo = 0;
+    int32_t depth = 0;
+    uint64_t nodes = 0;
+    int32_t mate = 0;
+    int64_t moveTime = 0;
+    bool infinite = false;
+    bool ponder = false;
+  };
+
+  // Each search thread owns a board, evaluation and search, and shares the table.
+  // The board is a bitboard so the search prunes by exchange evaluation and
+  // the evaluation includes mobility and king safety.
+  struct Worker
+  {
+    jcl::BitBoard board;
+    jcl::Evaluation evaluation;
+    jcl::Search search;
+
+    Worker();
+  };
+
+private:
+  bool applyMove(jcl::Board * board, const std::string & moveString) const;
+  std::string findPonderMove(Worker * worker) const;
+  void handleGo(std::istringstream & iss);
+  void handleNewGame();
+  void handlePonderHit();
+  void handlePosition(std::istringstream & iss);
+  void handleSetOption(std::istringstream & iss);
+  void handleStop();
+  void handleUci() const;
+  void reportIteration(int32_t depth);
+  void reportHitRates() const;
+  void resizeWorkers(size_t count);
+  void searchMain(GoLimits limits);
+  void send(const std::string & line) const;
+  size_t setWorkerPosition(Worker * worker, size_t firstMove);
+  void stopSearch();
+  static std::string toUciNotation(const jcl::Move & move);
+
+private:
+  std::atomic<bool> mStop;
+  bool mInfinite;
+  bool mOwnBook;
+  bool mPonder;
+  std::string mStartFen;
+  std::vector<std::string> mMoves;
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+  std::thread mSearchThread;
+  std::mutex mStateMutex;
+  std::condition_variable mStateCondition;
+  mutable std::mutex mOutputMutex;
+  jcl::EvaluationCache mEvaluationCache;
+  jcl::Network mNetwork;
+  jcl::OpeningBook mBook;
+  std::mt19937_64 mRandom;
+  jcl::Tablebase mTablebase;
+  jcl::TimeManager mTimeManager;
+  jcl::TranspositionTable mTable;
+};
+
+#endif // UCIENGINE_H